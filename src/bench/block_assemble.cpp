@@ -5,8 +5,10 @@
 #include <bench/bench.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <keva/common.h>
 #include <node/miner.h>
 #include <random.h>
+#include <script/keva.h>
 #include <test/util/mining.h>
 #include <test/util/script.h>
 #include <test/util/setup_common.h>
@@ -14,6 +16,7 @@
 #include <validation.h>
 
 
+#include <string>
 #include <vector>
 
 static void AssembleBlock(benchmark::Bench& bench)
@@ -60,5 +63,51 @@ static void BlockAssemblerAddPackageTxns(benchmark::Bench& bench)
     });
 }
 
+static void BlockAssemblerAddKevaChains(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+
+    // Busy namespaces: each coinbase funds a chain of updates of one
+    // namespace, every update spending the keva output of the previous one.
+    constexpr size_t NUM_NAMESPACES{50};
+    constexpr size_t UPDATES_PER_NAMESPACE{40};
+    {
+        LOCK2(cs_main, testing_setup->m_node.mempool->cs);
+        for (size_t n{0}; n < NUM_NAMESPACES; ++n) {
+            const CTransactionRef& coinbase{testing_setup->m_coinbase_txns.at(n)};
+            const valtype nameSpace{ValtypeFromString("ns" + std::to_string(n))};
+            COutPoint prevout{coinbase->GetHash(), 0};
+            CAmount value{coinbase->vout[0].nValue};
+            for (size_t i{0}; i < UPDATES_PER_NAMESPACE; ++i) {
+                CMutableTransaction mtx;
+                mtx.SetKevacoin();
+                mtx.vin.emplace_back(prevout);
+                const CAmount fee{100 * (1 + static_cast<CAmount>(det_rand.randrange(30)))};
+                value -= fee;
+                const valtype key{ValtypeFromString("key" + std::to_string(i))};
+                mtx.vout.emplace_back(value, CKevaScript::buildKevaPut(P2WSH_OP_TRUE, nameSpace, key, det_rand.randbytes(100)));
+                const CTransactionRef ptx{MakeTransactionRef(mtx)};
+                LockPoints lp;
+                testing_setup->m_node.mempool->addUnchecked(CTxMemPoolEntry(ptx, fee, /*time=*/0, /*entry_height=*/1, /*entry_sequence=*/0,
+                                                                            /*spends_coinbase=*/i == 0, /*sigops_cost=*/4, lp));
+                prevout = COutPoint{ptx->GetHash(), 0};
+            }
+        }
+    }
+
+    node::BlockAssembler::Options assembler_options;
+    assembler_options.test_block_validity = false;
+
+    // Report the template build time per keva operation included.
+    PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE, assembler_options);
+    const int64_t keva_ops{node::BlockAssembler::m_last_block_num_keva_ops.value()};
+    assert(keva_ops > 0);
+    bench.batch(keva_ops).unit("keva op").run([&] {
+        PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE, assembler_options);
+    });
+}
+
 BENCHMARK(AssembleBlock, benchmark::PriorityLevel::HIGH);
 BENCHMARK(BlockAssemblerAddPackageTxns, benchmark::PriorityLevel::LOW);
+BENCHMARK(BlockAssemblerAddKevaChains, benchmark::PriorityLevel::LOW);
@@ -0,0 +1,94 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <primitives/block.h>
+#include <random.h>
+#include <streams.h>
+#include <uint256.h>
+
+#include <cassert>
+
+static CBlockHeader CreateHeader()
+{
+    FastRandomContext rng(true);
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = rng.rand256();
+    header.hashMerkleRoot = rng.rand256();
+    header.nTime = 1600000000;
+    header.nBits = 0x1e0fffff;
+    header.nNonce = 1000;
+    header.cnHeader.major_version = 12;
+    header.cnHeader.timestamp = header.nTime;
+    header.cnHeader.prev_id = header.GetOriginalBlockHash();
+    header.cnHeader.nonce = rng.rand32();
+    header.cnHeader.merkle_root = rng.rand256();
+    header.cnHeader.nTxes = 300;
+    assert(header.isCNConsistent());
+    return header;
+}
+
+// The CryptoNote header blob as it used to be built, through binary_archive.
+static void CryptoNoteHeaderBlobArchive(benchmark::Bench& bench)
+{
+    const CBlockHeader header = CreateHeader();
+    bench.run([&] {
+        cryptonote::blobdata blob = cryptonote::t_serializable_object_to_blob(header.cnHeader);
+        ankerl::nanobench::doNotOptimizeAway(blob);
+    });
+}
+
+static void CryptoNoteHeaderBlob(benchmark::Bench& bench)
+{
+    const CBlockHeader header = CreateHeader();
+    bench.run([&] {
+        unsigned char blob[CryptoNoteHeader::MAX_BLOB_SIZE];
+        ankerl::nanobench::doNotOptimizeAway(header.cnHeader.WriteBlob(blob));
+    });
+}
+
+static void DeserializeBlockHeader(benchmark::Bench& bench)
+{
+    DataStream stream;
+    stream << CreateHeader();
+    std::byte a{0};
+    stream.write({&a, 1}); // Prevent compaction
+    const size_t size = stream.size();
+
+    bench.unit("header").run([&] {
+        CBlockHeader header;
+        stream >> header;
+        bool rewound = stream.Rewind(size);
+        assert(rewound);
+    });
+}
+
+// Hashing a header that was built in memory, as for the block index.
+static void BlockHeaderHash(benchmark::Bench& bench)
+{
+    const CBlockHeader header = CreateHeader();
+    bench.unit("header").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(header.GetHash());
+    });
+}
+
+// Hashing a deserialized header again, as validation and relay do.
+static void DeserializedBlockHeaderHash(benchmark::Bench& bench)
+{
+    DataStream stream;
+    stream << CreateHeader();
+    CBlockHeader header;
+    stream >> header;
+    bench.unit("header").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(header.GetHash());
+    });
+}
+
+BENCHMARK(CryptoNoteHeaderBlobArchive, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CryptoNoteHeaderBlob, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeserializeBlockHeader, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockHeaderHash, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeserializedBlockHeaderHash, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,66 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <checkqueue.h>
+#include <common/system.h>
+#include <consensus/params.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <vector>
+
+static const size_t HEADERS = 32;
+static const unsigned int QUEUE_BATCH_SIZE = 8;
+
+// Verify the RandomX proof of work of a batch of headers on the PoW check
+// queue, as HasValidProofOfWork does for a headers message.
+static void CheckHeadersPoWParallel(benchmark::Bench& bench)
+{
+    Consensus::Params params;
+    params.powLimit = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    FastRandomContext rng(true);
+    const uint256 seed_hash = rng.rand256();
+    std::vector<CBlockHeader> headers(HEADERS);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        CBlockHeader& header = headers[i];
+        header.nVersion = 0x20000000;
+        header.hashPrevBlock = rng.rand256();
+        header.hashMerkleRoot = rng.rand256();
+        header.nTime = 1600000000 + i;
+        header.nBits = 0x207fffff;
+        header.nNonce = 100000 + i;
+        header.cnHeader.major_version = RX_BLOCK_VERSION;
+        header.cnHeader.timestamp = header.nTime;
+        header.cnHeader.prev_id = header.GetOriginalBlockHash();
+        header.cnHeader.merkle_root = rng.rand256();
+        header.cnHeader.nTxes = 1;
+        // "Mine" the header, so that no check fails and cuts the batch short.
+        while (!CPoWCheck(header, seed_hash, params)()) {
+            ++header.cnHeader.nonce;
+        }
+    }
+
+    // The main thread should be counted to prevent thread oversubscription, and
+    // to decrease the variance of benchmark results.
+    CCheckQueue<CPoWCheck> queue{QUEUE_BATCH_SIZE, GetNumCores() - 1, "powcheck"};
+
+    bench.batch(HEADERS).unit("header").run([&] {
+        std::vector<CPoWCheck> checks;
+        checks.reserve(headers.size());
+        for (const auto& header : headers) {
+            checks.emplace_back(header, seed_hash, params);
+        }
+        CCheckQueueControl<CPoWCheck> control(&queue);
+        control.Add(std::move(checks));
+        bool ok = control.Wait();
+        assert(ok);
+    });
+}
+
+BENCHMARK(CheckHeadersPoWParallel, benchmark::PriorityLevel::HIGH);
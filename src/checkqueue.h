@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <string>
 #include <vector>
 
 /**
@@ -127,13 +128,13 @@ public:
     Mutex m_control_mutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num)
+    explicit CCheckQueue(unsigned int batch_size, int worker_threads_num, const std::string& thread_name = "scriptch")
         : nBatchSize(batch_size)
     {
         m_worker_threads.reserve(worker_threads_num);
         for (int n = 0; n < worker_threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
+            m_worker_threads.emplace_back([this, n, thread_name]() {
+                util::ThreadRename(strprintf("%s.%i", thread_name, n));
                 Loop(false /* worker thread */);
             });
         }
@@ -96,3 +96,7 @@ void rx_seedheights(const uint64_t height, uint64_t *seed_height, uint64_t *next
 int is_a_seed_height(const uint64_t height);
 void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash, const void *data, size_t length, char *hash, int miners, int is_alt);
 void rx_reorg(const uint64_t split_height);
+void rx_set_fast_verify(const int threads);
+/* Returns 0 once after a dataset couldn't be allocated and fast verification was turned off. */
+int rx_prepare_fast_verify(const uint64_t seedheight, const char *seedhash);
+void rx_stop_fast_verify(void);
@@ -145,6 +145,7 @@ int is_a_seed_height(const uint64_t height) {
 }
 
 typedef struct seedinfo {
+  randomx_dataset *si_dataset;
   randomx_cache *si_cache;
   unsigned long si_start;
   unsigned long si_count;
@@ -152,7 +153,7 @@ typedef struct seedinfo {
 
 static CTHR_THREAD_RTYPE rx_seedthread(void *arg) {
   seedinfo *si = arg;
-  randomx_init_dataset(rx_dataset, si->si_cache, si->si_start, si->si_count);
+  randomx_init_dataset(si->si_dataset, si->si_cache, si->si_start, si->si_count);
   CTHR_THREAD_RETURN;
 }
 
@@ -172,11 +173,13 @@ static void rx_initdata(randomx_cache *rs_cache, const int miners, const uint64_
       local_abort("Couldn't allocate RandomX mining threadlist");
     }
     for (i=0; i<miners-1; i++) {
+      si[i].si_dataset = rx_dataset;
       si[i].si_cache = rs_cache;
       si[i].si_start = start;
       si[i].si_count = delta;
       start += delta;
     }
+    si[i].si_dataset = rx_dataset;
     si[i].si_cache = rs_cache;
     si[i].si_start = start;
     si[i].si_count = randomx_dataset_item_count() - start;
@@ -195,6 +198,261 @@ static void rx_initdata(randomx_cache *rs_cache, const int miners, const uint64_
   rx_dataset_height = seedheight;
 }
 
+/*
+ * Fast (full dataset) verification.
+ *
+ * When enabled with rx_set_fast_verify, verification hashes (miners == 0)
+ * run on a full-memory VM if the dataset of their seed is ready, and fall
+ * back to the light cache otherwise.  There are two datasets, one per seed
+ * epoch parity like rx_s, so that the dataset of the next epoch can be built
+ * in the background (rx_prepare_fast_verify) while the current one is in use.
+ */
+enum {
+  RX_FAST_EMPTY = 0,
+  RX_FAST_BUILDING,
+  RX_FAST_READY,
+};
+
+typedef struct rx_fast_state {
+  randomx_dataset *fs_dataset;
+  uint64_t fs_height;
+  char fs_hash[HASH_SIZE];
+  int fs_state;
+  int fs_users;     /* hashes currently running on fs_dataset */
+  int fs_pending;   /* a build of fs_pending_hash is requested */
+  uint64_t fs_pending_height;
+  char fs_pending_hash[HASH_SIZE];
+} rx_fast_state;
+
+static CTHR_MUTEX_TYPE rx_fast_mutex = CTHR_MUTEX_INIT;
+static rx_fast_state rx_fast[2];
+static int rx_fast_threads;           /* 0 if fast verification is disabled */
+static int rx_fast_stop;
+static int rx_fast_failed;            /* a dataset couldn't be allocated, not reported yet */
+static int rx_fast_builder_running;
+static int rx_fast_builder_started;
+static CTHR_THREAD_TYPE rx_fast_builder;
+static randomx_cache *rx_fast_cache;  /* only used by the builder */
+static THREADV randomx_vm *rx_fast_vm = NULL;
+static THREADV randomx_dataset *rx_fast_vm_dataset = NULL;
+
+static rx_fast_state *rx_fast_slot(const uint64_t seedheight) {
+  return &rx_fast[(seedheight & SEEDHASH_EPOCH_BLOCKS) != 0];
+}
+
+static void rx_fast_sleep(void) {
+#ifdef _WIN32
+  Sleep(1);
+#else
+  usleep(1000);
+#endif
+}
+
+/* Build a dataset in slices, so that rx_stop_fast_verify need not wait for a whole build. */
+static int rx_fast_initdata(randomx_dataset *dataset, randomx_cache *cache, const int threads) {
+  const unsigned long total = randomx_dataset_item_count();
+  const unsigned long slice = total / 32 + 1;
+  unsigned long start;
+  seedinfo *si;
+  CTHR_THREAD_TYPE *st;
+  int i, stop = 0;
+  si = malloc(threads * sizeof(seedinfo));
+  st = malloc(threads * sizeof(CTHR_THREAD_TYPE));
+  if (si == NULL || st == NULL) {
+    free(si);
+    free(st);
+    return 0;
+  }
+  for (start = 0; start < total && !stop; start += slice) {
+    const unsigned long count = total - start < slice ? total - start : slice;
+    const unsigned long delta = count / threads;
+    for (i=0; i<threads; i++) {
+      si[i].si_dataset = dataset;
+      si[i].si_cache = cache;
+      si[i].si_start = start + i * delta;
+      si[i].si_count = i == threads - 1 ? count - i * delta : delta;
+    }
+    for (i=1; i<threads; i++)
+      CTHR_THREAD_CREATE(st[i], rx_seedthread, &si[i]);
+    randomx_init_dataset(dataset, cache, si[0].si_start, si[0].si_count);
+    for (i=1; i<threads; i++)
+      CTHR_THREAD_JOIN(st[i]);
+    CTHR_MUTEX_LOCK(rx_fast_mutex);
+    stop = rx_fast_stop;
+    CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+  }
+  free(st);
+  free(si);
+  return !stop;
+}
+
+static CTHR_THREAD_RTYPE rx_fast_build_thread(void *arg) {
+  randomx_flags flags = enabled_flags() & ~disabled_flags();
+  (void)arg;
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  while (!rx_fast_stop) {
+    rx_fast_state *fs = NULL;
+    uint64_t height;
+    char hash[HASH_SIZE];
+    int threads, ok = 0, failed = 0, i;
+    /* Earlier epochs first: they are needed before the later ones. */
+    for (i=0; i<2; i++) {
+      if (rx_fast[i].fs_pending && (fs == NULL || rx_fast[i].fs_pending_height < fs->fs_pending_height))
+        fs = &rx_fast[i];
+    }
+    if (fs == NULL)
+      break;
+    fs->fs_pending = 0;
+    height = fs->fs_pending_height;
+    memcpy(hash, fs->fs_pending_hash, HASH_SIZE);
+    fs->fs_state = RX_FAST_BUILDING;
+    fs->fs_height = height;
+    memcpy(fs->fs_hash, hash, HASH_SIZE);
+    /* Wait for the hashes still running on the previous dataset of this slot. */
+    while (fs->fs_users > 0) {
+      CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+      rx_fast_sleep();
+      CTHR_MUTEX_LOCK(rx_fast_mutex);
+    }
+    threads = rx_fast_threads;
+    CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+
+    if (fs->fs_dataset == NULL) {
+      fs->fs_dataset = randomx_alloc_dataset(RANDOMX_FLAG_LARGE_PAGES);
+      if (fs->fs_dataset == NULL)
+        fs->fs_dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+    }
+    if (rx_fast_cache == NULL) {
+      rx_fast_cache = randomx_alloc_cache(flags | RANDOMX_FLAG_LARGE_PAGES);
+      if (rx_fast_cache == NULL)
+        rx_fast_cache = randomx_alloc_cache(flags);
+    }
+    if (fs->fs_dataset == NULL || rx_fast_cache == NULL) {
+      failed = 1;
+    } else if (threads > 0) {
+      randomx_init_cache(rx_fast_cache, hash, HASH_SIZE);
+      ok = rx_fast_initdata(fs->fs_dataset, rx_fast_cache, threads);
+    }
+
+    CTHR_MUTEX_LOCK(rx_fast_mutex);
+    fs->fs_state = ok && fs->fs_height == height ? RX_FAST_READY : RX_FAST_EMPTY;
+    if (failed) {
+      /* Verify on the light cache from now on; rx_prepare_fast_verify reports it. */
+      rx_fast_failed = 1;
+      rx_fast_threads = 0;
+      for (i=0; i<2; i++)
+        rx_fast[i].fs_pending = 0;
+    }
+  }
+  rx_fast_builder_running = 0;
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+  CTHR_THREAD_RETURN;
+}
+
+void rx_set_fast_verify(const int threads) {
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  rx_fast_threads = (disabled_flags() & RANDOMX_FLAG_FULL_MEM) ? 0 : threads;
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+}
+
+int rx_prepare_fast_verify(const uint64_t seedheight, const char *seedhash) {
+  rx_fast_state *fs = rx_fast_slot(seedheight);
+  int ret = 1;
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  if (rx_fast_failed) {
+    rx_fast_failed = 0;
+    ret = 0;
+  }
+  if (rx_fast_threads == 0 || rx_fast_stop)
+    goto out;
+  /* Nothing to do if that dataset is already built, being built or requested. */
+  if (fs->fs_state != RX_FAST_EMPTY && fs->fs_height == seedheight && !memcmp(fs->fs_hash, seedhash, HASH_SIZE))
+    goto out;
+  if (fs->fs_pending && fs->fs_pending_height == seedheight && !memcmp(fs->fs_pending_hash, seedhash, HASH_SIZE))
+    goto out;
+  fs->fs_pending = 1;
+  fs->fs_pending_height = seedheight;
+  memcpy(fs->fs_pending_hash, seedhash, HASH_SIZE);
+  if (!rx_fast_builder_running) {
+    /* The previous builder is done with its work, so this does not block. */
+    if (rx_fast_builder_started)
+      CTHR_THREAD_JOIN(rx_fast_builder);
+    rx_fast_builder_running = 1;
+    rx_fast_builder_started = 1;
+    CTHR_THREAD_CREATE(rx_fast_builder, rx_fast_build_thread, NULL);
+  }
+out:
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+  return ret;
+}
+
+void rx_stop_fast_verify(void) {
+  int i;
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  rx_fast_stop = 1;
+  rx_fast_threads = 0;
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+  if (rx_fast_builder_started) {
+    CTHR_THREAD_JOIN(rx_fast_builder);
+    rx_fast_builder_started = 0;
+  }
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  for (i=0; i<2; i++) {
+    rx_fast[i].fs_state = RX_FAST_EMPTY;
+    rx_fast[i].fs_pending = 0;
+    while (rx_fast[i].fs_users > 0) {
+      CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+      rx_fast_sleep();
+      CTHR_MUTEX_LOCK(rx_fast_mutex);
+    }
+    if (rx_fast[i].fs_dataset != NULL) {
+      randomx_release_dataset(rx_fast[i].fs_dataset);
+      rx_fast[i].fs_dataset = NULL;
+    }
+  }
+  if (rx_fast_cache != NULL) {
+    randomx_release_cache(rx_fast_cache);
+    rx_fast_cache = NULL;
+  }
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+}
+
+/* Hash on the full dataset of the seed if it is ready. Returns 0 if it is not. */
+static int rx_fast_hash(const uint64_t seedheight, const char *seedhash, const void *data, size_t length, char *hash) {
+  rx_fast_state *fs = rx_fast_slot(seedheight);
+  randomx_dataset *dataset;
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  if (fs->fs_state != RX_FAST_READY || fs->fs_height != seedheight || memcmp(fs->fs_hash, seedhash, HASH_SIZE)) {
+    CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+    return 0;
+  }
+  fs->fs_users++;
+  dataset = fs->fs_dataset;
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+
+  if (rx_fast_vm == NULL) {
+    randomx_flags flags = (enabled_flags() & ~disabled_flags()) | RANDOMX_FLAG_FULL_MEM;
+    if (flags & RANDOMX_FLAG_JIT)
+      flags |= RANDOMX_FLAG_SECURE & ~disabled_flags();
+    rx_fast_vm = randomx_create_vm(flags | RANDOMX_FLAG_LARGE_PAGES, NULL, dataset);
+    if (rx_fast_vm == NULL)
+      rx_fast_vm = randomx_create_vm(flags, NULL, dataset);
+    if (rx_fast_vm == NULL)
+      rx_fast_vm = randomx_create_vm(RANDOMX_FLAG_DEFAULT | RANDOMX_FLAG_FULL_MEM, NULL, dataset);
+  } else if (rx_fast_vm_dataset != dataset) {
+    randomx_vm_set_dataset(rx_fast_vm, dataset);
+  }
+  if (rx_fast_vm != NULL) {
+    rx_fast_vm_dataset = dataset;
+    randomx_calculate_hash(rx_fast_vm, data, length, hash);
+  }
+
+  CTHR_MUTEX_LOCK(rx_fast_mutex);
+  fs->fs_users--;
+  CTHR_MUTEX_UNLOCK(rx_fast_mutex);
+  return rx_fast_vm != NULL;
+}
+
 void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash, const void *data, size_t length,
   char *hash, int miners, int is_alt) {
   uint64_t s_height = rx_seedheight(mainheight);
@@ -203,6 +461,9 @@ void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const ch
   rx_state *rx_sp;
   randomx_cache *cache;
 
+  if (!miners && !is_alt && rx_fast_hash(seedheight, seedhash, data, length, hash))
+    return;
+
   CTHR_MUTEX_LOCK(rx_mutex);
 
   /* if alt block but with same seed as mainchain, no need for alt cache */
@@ -305,6 +566,11 @@ void rx_slow_hash_free_state(void) {
     randomx_destroy_vm(rx_vm);
     rx_vm = NULL;
   }
+  if (rx_fast_vm != NULL) {
+    randomx_destroy_vm(rx_fast_vm);
+    rx_fast_vm = NULL;
+    rx_fast_vm_dataset = NULL;
+  }
 }
 
 void rx_stop_mining(void) {
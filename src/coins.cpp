@@ -9,6 +9,7 @@
 #include <consensus/consensus.h>
 #include <logging.h>
 #include <random.h>
+#include <script/keva.h>
 #include <util/trace.h>
 
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
@@ -16,16 +17,23 @@ uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
 bool CCoinsView::GetNamespace(const valtype &nameSpace, CKevaData &data) const { return false; }
 bool CCoinsView::GetName(const valtype &nameSpace, const valtype &key, CKevaData &data) const { return false; }
-bool CCoinsView::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const { return false; }
+std::vector<std::optional<CKevaData>> CCoinsView::GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    std::vector<std::optional<CKevaData>> result(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        CKevaData data;
+        if (GetName(std::get<0>(names[i]), std::get<1>(names[i]), data)) result[i] = std::move(data);
+    }
+    return result;
+}
+bool CCoinsView::GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const { return false; }
+bool CCoinsView::GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const { return false; }
 CKevaIterator* CCoinsView::IterateKeys(const valtype& nameSpace) const { assert (false); }
 CKevaIterator* CCoinsView::IterateAssociatedNamespaces(const valtype& nameSpace) const { assert (false); }
+std::unique_ptr<CCoinsView> CCoinsView::GetKevaSnapshot() const { return nullptr; }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase) { return false; }
 std::unique_ptr<CCoinsViewCursor> CCoinsView::Cursor() const { return nullptr; }
-bool CCoinsView::ValidateKevaDB() const {
-    // TODO: return false, and implement it in txdb.cpp.
-    // Need to figure out what to check.
-    return true;
-}
+std::unique_ptr<CKevaViewCursor> CCoinsView::KevaCursor() const { return nullptr; }
+bool CCoinsView::ValidateKevaDB() const { return true; }
 
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 {
@@ -44,14 +52,26 @@ bool CCoinsViewBacked::GetNamespace(const valtype &nameSpace, CKevaData &data) c
 bool CCoinsViewBacked::GetName(const valtype &nameSpace, const valtype &key, CKevaData &data) const {
     return base->GetName(nameSpace, key, data);
 }
-bool CCoinsViewBacked::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const {
-    return base->GetNamesForHeight(nHeight, names);
+std::vector<std::optional<CKevaData>> CCoinsViewBacked::GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    return base->GetNames(names);
+}
+void CCoinsViewBacked::PrefetchNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    base->PrefetchNames(names);
+}
+bool CCoinsViewBacked::GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const {
+    return base->GetKeysSinceHeight(nameSpace, nMinHeight, keys);
+}
+bool CCoinsViewBacked::GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const {
+    return base->GetNamesSinceHeight(nMinHeight, names);
 }
 CKevaIterator* CCoinsViewBacked::IterateKeys(const valtype& nameSpace) const { return base->IterateKeys(nameSpace); }
 CKevaIterator* CCoinsViewBacked::IterateAssociatedNamespaces(const valtype& nameSpace) const { return base->IterateAssociatedNamespaces(nameSpace); }
+std::unique_ptr<CCoinsView> CCoinsViewBacked::GetKevaSnapshot() const { return base->GetKevaSnapshot(); }
 void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase) { return base->BatchWrite(mapCoins, hashBlock, names, erase); }
 std::unique_ptr<CCoinsViewCursor> CCoinsViewBacked::Cursor() const { return base->Cursor(); }
+std::unique_ptr<CKevaViewCursor> CCoinsViewBacked::KevaCursor() const { return base->KevaCursor(); }
+bool CCoinsViewBacked::ValidateKevaDB() const { return base->ValidateKevaDB(); }
 size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
 CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
@@ -60,7 +80,11 @@ CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
 {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage + cacheNames.DynamicMemoryUsage();
+}
+
+size_t CCoinsViewCache::KevaChangesMemoryUsage() const {
+    return cacheNames.DynamicMemoryUsage();
 }
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
@@ -202,10 +226,7 @@ void CCoinsViewCache::SetBestBlock(const uint256 &hashBlockIn) {
 }
 
 bool CCoinsViewCache::GetNamespace(const valtype &nameSpace, CKevaData &data) const {
-    if (cacheNames.GetNamespace(nameSpace, data)) {
-        return true;
-    }
-    return base->GetNamespace(nameSpace, data);
+    return GetName(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data);
 }
 
 bool CCoinsViewCache::GetName(const valtype &nameSpace, const valtype &key, CKevaData &data) const {
@@ -214,20 +235,99 @@ bool CCoinsViewCache::GetName(const valtype &nameSpace, const valtype &key, CKev
     if (cacheNames.get(nameSpace, key, data))
         return true;
 
-    /* Note: This does not attempt to cache name queries.  The cache
-       only keeps track of changes!  */
+    /* cacheNames only keeps track of changes.  Confirmed entries of the
+       base view are remembered in the (bounded) read cache, if enabled.  */
+    bool found;
+    if (kevaReadCache.get(nameSpace, key, found, data))
+        return found;
 
-    return base->GetName(nameSpace, key, data);
+    found = base->GetName(nameSpace, key, data);
+    if (found) {
+        kevaReadCache.set(nameSpace, key, data);
+    } else {
+        kevaReadCache.setMissing(nameSpace, key);
+    }
+    return found;
+}
+
+std::vector<std::optional<CKevaData>> CCoinsViewCache::GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    std::vector<std::optional<CKevaData>> result(names.size());
+
+    /* Resolve what we can from the changes and the read cache, and read
+       the rest from the base view with a single call.  */
+    std::vector<size_t> missingPos;
+    std::vector<CKevaCache::NamespaceKeyType> missing;
+    for (size_t i = 0; i < names.size(); ++i) {
+        const auto& [nameSpace, key] = names[i];
+        CKevaData data;
+        bool found;
+        if (cacheNames.isDeleted(nameSpace, key))
+            continue;
+        if (cacheNames.get(nameSpace, key, data)) {
+            result[i] = std::move(data);
+        } else if (kevaReadCache.get(nameSpace, key, found, data)) {
+            if (found) result[i] = std::move(data);
+        } else {
+            missingPos.push_back(i);
+            missing.push_back(names[i]);
+        }
+    }
+    if (missing.empty())
+        return result;
+
+    std::vector<std::optional<CKevaData>> found = base->GetNames(missing);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (found[i]) {
+            kevaReadCache.set(std::get<0>(missing[i]), std::get<1>(missing[i]), *found[i]);
+        } else {
+            kevaReadCache.setMissing(std::get<0>(missing[i]), std::get<1>(missing[i]));
+        }
+        result[missingPos[i]] = std::move(found[i]);
+    }
+    return result;
 }
 
-bool CCoinsViewCache::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const {
+void CCoinsViewCache::PrefetchNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    std::vector<CKevaCache::NamespaceKeyType> missing;
+    for (const auto& [nameSpace, key] : names) {
+        CKevaData data;
+        if (cacheNames.isDeleted(nameSpace, key) || cacheNames.get(nameSpace, key, data) || kevaReadCache.has(nameSpace, key))
+            continue;
+        missing.emplace_back(nameSpace, key);
+    }
+    if (missing.empty())
+        return;
+    if (!kevaReadCache.isEnabled()) {
+        base->PrefetchNames(missing);
+        return;
+    }
+
+    const std::vector<std::optional<CKevaData>> found = base->GetNames(missing);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (found[i]) {
+            kevaReadCache.set(std::get<0>(missing[i]), std::get<1>(missing[i]), *found[i]);
+        } else {
+            kevaReadCache.setMissing(std::get<0>(missing[i]), std::get<1>(missing[i]));
+        }
+    }
+}
+
+bool CCoinsViewCache::GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const {
     /* Query the base view first, and then apply the cached changes (if
        there are any).  */
 
-    if (!base->GetNamesForHeight(nHeight, names))
+    if (!base->GetKeysSinceHeight(nameSpace, nMinHeight, keys))
         return false;
 
-    cacheNames.updateNamesForHeight(nHeight, names);
+    cacheNames.updateKeysSinceHeight(nameSpace, nMinHeight, keys);
+    return true;
+}
+
+bool CCoinsViewCache::GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const {
+    if (!base->GetNamesSinceHeight(nMinHeight, names))
+        return false;
+
+    cacheNames.updateNamesSinceHeight(nMinHeight, names);
     return true;
 }
 
@@ -239,13 +339,41 @@ CKevaIterator* CCoinsViewCache::IterateAssociatedNamespaces(const valtype& nameS
     return cacheNames.IterateAssociatedNamespaces(base->IterateAssociatedNamespaces(nameSpace));
 }
 
+namespace {
+
+/** Keva snapshot of a cache: a copy of its changes on top of a snapshot of its base.  */
+class CKevaSnapshotCache final : public CCoinsViewCache
+{
+private:
+    const std::unique_ptr<CCoinsView> m_base;
+
+public:
+    CKevaSnapshotCache(std::unique_ptr<CCoinsView> base, const CKevaCache& changes)
+        : CCoinsViewCache(base.get()), m_base(std::move(base))
+    {
+        cacheNames = changes;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<CCoinsView> CCoinsViewCache::GetKevaSnapshot() const {
+    std::unique_ptr<CCoinsView> baseSnapshot = base->GetKevaSnapshot();
+    if (!baseSnapshot)
+        return nullptr;
+    return std::make_unique<CKevaSnapshotCache>(std::move(baseSnapshot), cacheNames);
+}
+
 /* undo is set if the change is due to disconnecting blocks / going back in
    time.  The ordinary case (!undo) means that we update the name normally,
    going forward in time.  This is important for keeping track of the
    name history.  */
-void CCoinsViewCache::SetKeyValue(const valtype &nameSpace, const valtype &key, const CKevaData& data, bool undo)
+void CCoinsViewCache::SetKeyValue(const valtype &nameSpace, const valtype &key, const CKevaData& data, bool undo,
+                                  std::optional<unsigned> oldHeight)
 {
-    cacheNames.set(nameSpace, key, data);
+    kevaReadCache.remove(nameSpace, key);
+    cacheNames.set(nameSpace, key, data, oldHeight);
+    kevaGroupCache.setKey(nameSpace, key, &data);
 
     // Handle namespace association.
     valtype associdateNamespace;
@@ -258,6 +386,7 @@ void CCoinsViewCache::SetKeyValue(const valtype &nameSpace, const valtype &key,
         return;
     }
     cacheNames.associateNamespaces(nameSpace, associdateNamespace, data);
+    kevaGroupCache.associate(associdateNamespace, nameSpace, &data);
 }
 
 void CCoinsViewCache::DeleteKey(const valtype &nameSpace, const valtype &key) {
@@ -265,7 +394,9 @@ void CCoinsViewCache::DeleteKey(const valtype &nameSpace, const valtype &key) {
     if (!GetName(nameSpace, key, oldData)) {
         assert(false);
     }
-    cacheNames.remove(nameSpace, key);
+    kevaReadCache.remove(nameSpace, key);
+    cacheNames.remove(nameSpace, key, oldData.getHeight());
+    kevaGroupCache.setKey(nameSpace, key, nullptr);
 
     // Handle namespace association.
     valtype associdateNamespace;
@@ -278,6 +409,7 @@ void CCoinsViewCache::DeleteKey(const valtype &nameSpace, const valtype &key) {
         return;
     }
     cacheNames.disassociateNamespaces(nameSpace, associdateNamespace);
+    kevaGroupCache.associate(associdateNamespace, nameSpace, nullptr);
 }
 
 bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn, const CKevaCache &names, bool erase) {
@@ -349,10 +481,61 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
         }
     }
     hashBlock = hashBlockIn;
+    kevaReadCache.removeChanges(names);
+    kevaGroupCache.applyChanges(names);
     cacheNames.apply(names);
     return true;
 }
 
+void CCoinsViewCache::SetKevaCacheSize(size_t max_bytes) {
+    kevaReadCache.setMaxSize(max_bytes);
+}
+
+size_t CCoinsViewCache::KevaCacheMemoryUsage() const {
+    return kevaReadCache.dynamicMemoryUsage();
+}
+
+void CCoinsViewCache::SetKevaGroupCacheSize(size_t max_bytes) {
+    kevaGroupCache.setMaxSize(max_bytes);
+}
+
+bool CCoinsViewCache::GetCachedNamespaceGroup(const valtype& nameSpace, CKevaGroup& group) const {
+    return kevaGroupCache.get(nameSpace, group);
+}
+
+void CCoinsViewCache::CacheNamespaceGroup(const valtype& nameSpace, const CKevaGroup& group) const {
+    kevaGroupCache.set(nameSpace, group);
+}
+
+CKevaGroup CCoinsViewCache::GetNamespaceGroup(const valtype& nameSpace) const {
+    CKevaGroup group;
+    if (GetCachedNamespaceGroup(nameSpace, group))
+        return group;
+
+    group = BuildNamespaceGroup(*this, nameSpace);
+    CacheNamespaceGroup(nameSpace, group);
+    return group;
+}
+
+CKevaGroup BuildNamespaceGroup(const CCoinsView& view, const valtype& nameSpace) {
+    CKevaGroup group;
+    valtype key;
+    CKevaData data;
+    std::unique_ptr<CKevaIterator> iterKeys(view.IterateKeys(nameSpace));
+    while (iterKeys->next(key, data)) {
+        valtype other;
+        if (CKevaCache::getAssociateNamespaces(key, other))
+            group.joined.emplace(key, std::make_pair(std::move(other), data));
+    }
+
+    valtype member;
+    std::unique_ptr<CKevaIterator> iterMembers(view.IterateAssociatedNamespaces(nameSpace));
+    while (iterMembers->next(member, data)) {
+        group.members.emplace(member, data);
+    }
+    return group;
+}
+
 bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock, cacheNames, /*erase=*/true);
     if (fOk) {
@@ -381,6 +564,9 @@ bool CCoinsViewCache::Sync()
             ++it;
         }
     }
+    // The keva changes are now part of the base view, so there is no
+    // need to keep (and account for) them here any longer.
+    if (fOk) cacheNames.clear();
     return fOk;
 }
 
@@ -440,6 +626,7 @@ void CCoinsViewCache::SanityCheck() const
         recomputed_usage += entry.coin.DynamicMemoryUsage();
     }
     assert(recomputed_usage == cachedCoinsUsage);
+    cacheNames.SanityCheck();
 }
 
 static const size_t MIN_TRANSACTION_OUTPUT_WEIGHT = WITNESS_SCALE_FACTOR * ::GetSerializeSize(CTxOut());
@@ -20,7 +20,9 @@
 #include <stdint.h>
 
 #include <functional>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -169,6 +171,21 @@ private:
     uint256 hashBlock;
 };
 
+/** Cursor for iterating over the keva entries and namespace associations of a CoinsView */
+class CKevaViewCursor
+{
+public:
+    virtual ~CKevaViewCursor() {}
+
+    //! Get the current record.  association is set if it is a namespace
+    //! association rather than a keva entry.
+    virtual bool GetKey(bool& association, valtype& nameSpace, valtype& key) const = 0;
+    virtual bool GetValue(CKevaData& data) const = 0;
+
+    virtual bool Valid() const = 0;
+    virtual void Next() = 0;
+};
+
 /** Abstract view on the open txout dataset. */
 class CCoinsView
 {
@@ -201,8 +218,21 @@ public:
     // Get a name (if it exists)
     virtual bool GetName(const valtype& nameSpace, const valtype& key, CKevaData& data) const;
 
-    // Query for names that were updated at the given height
-    virtual bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const;
+    // Get many names at once, e.g. all names touched by a block.  The result
+    // holds the data of each name, or nullopt if it does not exist.
+    virtual std::vector<std::optional<CKevaData>> GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const;
+
+    // Hint that the given names are about to be read, so that a view with a
+    // keva read cache can load them in one batch.  Does nothing by default.
+    virtual void PrefetchNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {}
+
+    // Query for the keys of a namespace that were last updated at or after
+    // the given height.  Returns false if the view has no height index.
+    virtual bool GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const;
+
+    // Query for the names (in any namespace) that were last updated at or
+    // after the given height.  Returns false if the view has no height index.
+    virtual bool GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const;
 
     // Get a key iterator.
     virtual CKevaIterator* IterateKeys(const valtype& nameSpace) const;
@@ -210,6 +240,12 @@ public:
     // Get the associated namespace iterator.
     virtual CKevaIterator* IterateAssociatedNamespaces(const valtype& nameSpace) const;
 
+    //! Get a read-only view of the current keva state that is not affected
+    //! by later changes to this view or its backends, so that it can be
+    //! used without holding cs_main.  Only its keva methods may be used.
+    //! Returns nullptr if this is not supported.
+    virtual std::unique_ptr<CCoinsView> GetKevaSnapshot() const;
+
     //! Do a bulk modification (multiple Coin changes + BestBlock change).
     //! The passed mapCoins can be modified.
     virtual bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase = true);
@@ -217,7 +253,12 @@ public:
     //! Get a cursor to iterate over the whole state
     virtual std::unique_ptr<CCoinsViewCursor> Cursor() const;
 
-    // Validate the name database.
+    //! Get a cursor to iterate over the whole keva state: all keva entries,
+    //! followed by all namespace associations.
+    virtual std::unique_ptr<CKevaViewCursor> KevaCursor() const;
+
+    //! Validate the keva database.  Changes held in caches above the
+    //! database are not seen, so they should be flushed first.
     virtual bool ValidateKevaDB() const;
 
     //! As we use CCoinsViews polymorphically, have a virtual destructor
@@ -242,12 +283,18 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool GetNamespace(const valtype& nameSpace, CKevaData& data) const override;
     bool GetName(const valtype& nameSpace, const valtype& key, CKevaData& data) const override;
-    bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const override;
+    std::vector<std::optional<CKevaData>> GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override;
+    void PrefetchNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override;
+    bool GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const override;
+    bool GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const override;
     CKevaIterator* IterateKeys(const valtype& nameSpace) const override;
     CKevaIterator* IterateAssociatedNamespaces(const valtype& nameSpace) const override;
+    std::unique_ptr<CCoinsView> GetKevaSnapshot() const override;
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
+    std::unique_ptr<CKevaViewCursor> KevaCursor() const override;
+    bool ValidateKevaDB() const override;
     size_t EstimateSize() const override;
 };
 
@@ -268,6 +315,18 @@ protected:
     mutable CCoinsMap cacheCoins;
     mutable CKevaCache cacheNames;
 
+    /**
+     * Read cache of confirmed keva entries of the base view.  This is
+     * disabled (zero-sized) unless enabled with SetKevaCacheSize.
+     */
+    mutable CKevaReadCache kevaReadCache;
+
+    /**
+     * Namespace groups of recently queried namespaces in this view.  This
+     * is disabled (zero-sized) unless enabled with SetKevaGroupCacheSize.
+     */
+    mutable CKevaGroupCache kevaGroupCache;
+
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage{0};
 
@@ -286,18 +345,59 @@ public:
     void SetBestBlock(const uint256 &hashBlock);
     bool GetNamespace(const valtype &nameSpace, CKevaData& data) const override;
     bool GetName(const valtype &nameSpace, const valtype &key, CKevaData& data) const override;
-    bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const override;
+    std::vector<std::optional<CKevaData>> GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override;
+    bool GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const override;
+    bool GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const override;
     CKevaIterator* IterateKeys(const valtype& nameSpace) const override;
     CKevaIterator* IterateAssociatedNamespaces(const valtype& nameSpace) const override;
+    std::unique_ptr<CCoinsView> GetKevaSnapshot() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override {
         throw std::logic_error("CCoinsViewCache cursor iteration not supported.");
     }
+    std::unique_ptr<CKevaViewCursor> KevaCursor() const override {
+        throw std::logic_error("CCoinsViewCache cursor iteration not supported.");
+    }
 
-    /* Changes to the name database.  */
-    void SetKeyValue(const valtype &nameSpace, const valtype &key, const CKevaData &data, bool undo);
+    /* Changes to the name database.  oldHeight is the height of the data
+       that is replaced in this view, or nullopt if the key does not exist;
+       the callers know it already, and passing it on spares the flush a
+       database read to update the height index.  */
+    void SetKeyValue(const valtype &nameSpace, const valtype &key, const CKevaData &data, bool undo,
+                     std::optional<unsigned> oldHeight);
     void DeleteKey(const valtype &nameSpace, const valtype &key);
 
+    //! Set the memory budget (in bytes) of the read cache for keva entries of the base view.
+    void SetKevaCacheSize(size_t max_bytes);
+
+    //! Load the given names from the base view into the keva read cache with
+    //! a single GetNames call, so that applying the keva operations of a
+    //! block does not read them one by one.  Names changed in this cache
+    //! are skipped.  If the read cache is disabled, the remaining names are
+    //! passed on to the base view, so that prefetching through a temporary
+    //! cache on top of the tip fills the tip's read cache.
+    void PrefetchNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override;
+
+    //! Calculate the size of the keva read cache (in bytes)
+    size_t KevaCacheMemoryUsage() const;
+
+    //! Set the memory budget (in bytes) of the cache of namespace groups.
+    void SetKevaGroupCacheSize(size_t max_bytes);
+
+    //! Get the namespace group of a namespace in this view: the namespaces
+    //! it joined with its "_g:" keys, and those that joined it.  If the
+    //! group is not cached, this scans all keys of the namespace once.
+    CKevaGroup GetNamespaceGroup(const valtype& nameSpace) const;
+
+    //! Get the namespace group of a namespace only if it is cached.
+    bool GetCachedNamespaceGroup(const valtype& nameSpace, CKevaGroup& group) const;
+
+    //! Cache the namespace group of a namespace.  The group must match the
+    //! current state of this view, e.g. built with BuildNamespaceGroup from a
+    //! snapshot taken at the current best block; cached groups are kept up to
+    //! date with later changes.
+    void CacheNamespaceGroup(const valtype& nameSpace, const CKevaGroup& group) const;
+
     /**
      * Check if we have the given utxo already loaded in this cache.
      * The semantics are the same as HaveCoin(), but no calls to
@@ -365,9 +465,12 @@ public:
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
-    //! Calculate the size of the cache (in bytes)
+    //! Calculate the size of the cache (in bytes), including the pending keva changes
     size_t DynamicMemoryUsage() const;
 
+    //! Calculate the size of the pending keva changes (in bytes)
+    size_t KevaChangesMemoryUsage() const;
+
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
@@ -403,6 +506,10 @@ void AddCoins(CCoinsViewCache& cache, const CTransaction& tx, int nHeight, bool
 //! lookups to database, so it should be used with care.
 const Coin& AccessByTxid(const CCoinsViewCache& cache, const Txid& txid);
 
+//! Build the namespace group of a namespace by scanning all its keys in a
+//! view, which can be a keva snapshot so that no lock needs to be held.
+CKevaGroup BuildNamespaceGroup(const CCoinsView& view, const valtype& nameSpace);
+
 /**
  * This is a minimally invasive approach to shutdown on LevelDB read errors from the
  * chainstate, while keeping user interface out of the common library, which is shared
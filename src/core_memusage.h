@@ -8,6 +8,7 @@
 #include <primitives/transaction.h>
 #include <primitives/block.h>
 #include <memusage.h>
+#include <script/keva.h>
 
 static inline size_t RecursiveDynamicUsage(const CScript& script) {
     return memusage::DynamicUsage(script);
@@ -29,6 +30,14 @@ static inline size_t RecursiveDynamicUsage(const CTxOut& out) {
     return RecursiveDynamicUsage(out.scriptPubKey);
 }
 
+static inline size_t RecursiveDynamicUsage(const CTransaction::KevaOutputs& keva_outputs) {
+    size_t mem = memusage::DynamicUsage(keva_outputs);
+    for (const auto& [n, op] : keva_outputs) {
+        mem += op.DynamicMemoryUsage();
+    }
+    return mem;
+}
+
 static inline size_t RecursiveDynamicUsage(const CTransaction& tx) {
     size_t mem = memusage::DynamicUsage(tx.vin) + memusage::DynamicUsage(tx.vout);
     for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); it++) {
@@ -37,6 +46,9 @@ static inline size_t RecursiveDynamicUsage(const CTransaction& tx) {
     for (std::vector<CTxOut>::const_iterator it = tx.vout.begin(); it != tx.vout.end(); it++) {
         mem += RecursiveDynamicUsage(*it);
     }
+    if (const auto& keva_outputs = tx.GetSharedKevaOutputs()) {
+        mem += memusage::DynamicUsage(keva_outputs) + RecursiveDynamicUsage(*keva_outputs);
+    }
     return mem;
 }
 
@@ -134,12 +134,17 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBOptions& db_options)
 {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
     options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    if (db_options.write_buffer_bytes > 0) {
+        options.write_buffer_size = db_options.write_buffer_bytes;
+    }
+    if (db_options.bloom_filter_bits > 0) {
+        options.filter_policy = leveldb::NewBloomFilterPolicy(db_options.bloom_filter_bits);
+    }
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -226,7 +231,7 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     DBContext().iteroptions.verify_checksums = true;
     DBContext().iteroptions.fill_cache = false;
     DBContext().syncoptions.sync = true;
-    DBContext().options = GetOptions(params.cache_bytes);
+    DBContext().options = GetOptions(params.cache_bytes, params.options);
     DBContext().options.create_if_missing = true;
     if (params.memory_only) {
         DBContext().penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -335,11 +340,31 @@ std::vector<unsigned char> CDBWrapper::CreateObfuscateKey() const
     return ret;
 }
 
-std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key) const
+class CDBWrapper::Snapshot
+{
+public:
+    leveldb::DB* const pdb;
+    const leveldb::Snapshot* const snapshot;
+
+    Snapshot(leveldb::DB* db) : pdb{db}, snapshot{db->GetSnapshot()} {}
+    ~Snapshot() { pdb->ReleaseSnapshot(snapshot); }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+};
+
+std::shared_ptr<const CDBWrapper::Snapshot> CDBWrapper::GetSnapshot() const
+{
+    return std::make_shared<const Snapshot>(DBContext().pdb);
+}
+
+std::optional<std::string> CDBWrapper::ReadImpl(Span<const std::byte> key, const Snapshot* snapshot) const
 {
     leveldb::Slice slKey(CharCast(key.data()), key.size());
     std::string strValue;
-    leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
+    leveldb::ReadOptions options{DBContext().readoptions};
+    if (snapshot) options.snapshot = snapshot->snapshot;
+    leveldb::Status status = DBContext().pdb->Get(options, slKey, &strValue);
     if (!status.ok()) {
         if (status.IsNotFound())
             return std::nullopt;
@@ -390,9 +415,11 @@ struct CDBIterator::IteratorImpl {
 CDBIterator::CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl> _piter) : parent(_parent),
                                                                                             m_impl_iter(std::move(_piter)) {}
 
-CDBIterator* CDBWrapper::NewIterator()
+CDBIterator* CDBWrapper::NewIterator(const Snapshot* snapshot)
 {
-    return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(DBContext().iteroptions))};
+    leveldb::ReadOptions options{DBContext().iteroptions};
+    if (snapshot) options.snapshot = snapshot->snapshot;
+    return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(options))};
 }
 
 void CDBIterator::SeekImpl(Span<const std::byte> key)
@@ -27,6 +27,10 @@ static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Bits per key of the bloom filter, or 0 to disable it.
+    int bloom_filter_bits = 10;
+    //! Size of the write buffer in bytes, or 0 to use a quarter of the cache size.
+    size_t write_buffer_bytes = 0;
 };
 
 //! Application-specific storage settings.
@@ -205,7 +209,15 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
-    std::optional<std::string> ReadImpl(Span<const std::byte> key) const;
+public:
+    /**
+     * Consistent read-only state of the database at the time it was taken
+     * with GetSnapshot().  It must not outlive the database.
+     */
+    class Snapshot;
+
+private:
+    std::optional<std::string> ReadImpl(Span<const std::byte> key, const Snapshot* snapshot) const;
     bool ExistsImpl(Span<const std::byte> key) const;
     size_t EstimateSizeImpl(Span<const std::byte> key1, Span<const std::byte> key2) const;
     auto& DBContext() const LIFETIMEBOUND { return *Assert(m_db_context); }
@@ -217,13 +229,14 @@ public:
     CDBWrapper(const CDBWrapper&) = delete;
     CDBWrapper& operator=(const CDBWrapper&) = delete;
 
+    //! Read a value, from the given snapshot if set.
     template <typename K, typename V>
-    bool Read(const K& key, V& value) const
+    bool Read(const K& key, V& value, const Snapshot* snapshot = nullptr) const
     {
         DataStream ssKey{};
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
-        std::optional<std::string> strValue{ReadImpl(ssKey)};
+        std::optional<std::string> strValue{ReadImpl(ssKey, snapshot)};
         if (!strValue) {
             return false;
         }
@@ -275,7 +288,12 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
-    CDBIterator* NewIterator();
+    //! Create an iterator, over the given snapshot if set.
+    CDBIterator* NewIterator(const Snapshot* snapshot = nullptr);
+
+    //! Take a snapshot of the current state of the database.  Reads and
+    //! iterators using it do not see later writes.
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
 
     /**
      * Return true if the database managed by this class contains no entries.
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <headerssync.h>
+#include <crypto/hash-ops.h>
 #include <logging.h>
 #include <pow.h>
 #include <util/check.h>
@@ -44,6 +45,13 @@ HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus
     // could try again, if necessary, to sync a longer chain).
     m_max_commitments = 6*(Ticks<std::chrono::seconds>(NodeClock::now() - NodeSeconds{std::chrono::seconds{chain_start->GetMedianTimePast()}}) + MAX_FUTURE_BLOCK_TIME) / HEADER_COMMITMENT_PERIOD;
 
+    // The seeds of the first headers may be at or before the chain start.
+    for (int64_t height = crypto::rx_seedheight(chain_start->nHeight + 1); height <= chain_start->nHeight; ++height) {
+        if (crypto::is_a_seed_height(height)) {
+            m_seed_hashes.emplace(height, Assert(chain_start->GetAncestor(height))->GetBlockHash());
+        }
+    }
+
     LogPrint(BCLog::NET, "Initial headers sync started with peer=%d: height=%i, max_commitments=%i, min_work=%s\n", m_id, m_current_height, m_max_commitments, m_minimum_required_work.ToString());
 }
 
@@ -60,6 +68,7 @@ void HeadersSyncState::Finalize()
     m_redownload_buffer_first_prev_hash.SetNull();
     m_process_all_remaining_headers = false;
     m_current_height = 0;
+    m_seed_hashes.clear();
 
     m_download_state = State::FINAL;
 }
@@ -210,6 +219,9 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
     m_current_chain_work += GetBlockProof(CBlockIndex(current));
     m_last_header_received = current;
     m_current_height = next_height;
+    if (crypto::is_a_seed_height(next_height)) {
+        m_seed_hashes[next_height] = current.GetHash();
+    }
 
     return true;
 }
@@ -275,6 +287,10 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     m_redownloaded_headers.emplace_back(header);
     m_redownload_buffer_last_height = next_height;
     m_redownload_buffer_last_hash = header.GetHash();
+    // The seeds seen during PRESYNC are replaced as the chain is redownloaded.
+    if (crypto::is_a_seed_height(next_height)) {
+        m_seed_hashes[next_height] = m_redownload_buffer_last_hash;
+    }
 
     return true;
 }
@@ -295,6 +311,15 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance()
     return ret;
 }
 
+std::optional<std::map<uint64_t, uint256>> HeadersSyncState::GetSeedHashes(const uint256& prev_hash) const
+{
+    if ((m_download_state == State::PRESYNC && prev_hash == m_last_header_received.GetHash()) ||
+        (m_download_state == State::REDOWNLOAD && prev_hash == m_redownload_buffer_last_hash)) {
+        return m_seed_hashes;
+    }
+    return std::nullopt;
+}
+
 CBlockLocator HeadersSyncState::NextHeadersRequestLocator() const
 {
     Assume(m_download_state != State::FINAL);
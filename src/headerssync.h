@@ -15,6 +15,8 @@
 #include <util/hasher.h>
 
 #include <deque>
+#include <map>
+#include <optional>
 #include <vector>
 
 // A compressed CBlockHeader, which leaves out the prevhash
@@ -131,6 +133,11 @@ public:
     /** Return the amount of work in the chain received during the PRESYNC phase. */
     arith_uint256 GetPresyncWork() const { return m_current_chain_work; }
 
+    /** Return the RandomX seed block hashes, by height, of the chain being
+     *  synced, if headers following prev_hash continue it (see
+     *  GetHeadersSeedHashes). */
+    std::optional<std::map<uint64_t, uint256>> GetSeedHashes(const uint256& prev_hash) const;
+
     /** Construct a HeadersSyncState object representing a headers sync via this
      *  download-twice mechanism).
      *
@@ -246,6 +253,11 @@ private:
     /** Height of m_last_header_received */
     int64_t m_current_height{0};
 
+    /** Hashes of the blocks at RandomX seed heights of the chain being synced,
+     *  from m_chain_start on, so that the proof of work of the next headers
+     *  can be checked before they are in the block index. */
+    std::map<uint64_t, uint256> m_seed_hashes;
+
     /** During phase 2 (REDOWNLOAD), we buffer redownloaded headers in memory
      *  until enough commitments have been verified; those are stored in
      *  m_redownloaded_headers */
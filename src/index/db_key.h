@@ -0,0 +1,125 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KEVACOIN_INDEX_DB_KEY_H
+#define KEVACOIN_INDEX_DB_KEY_H
+
+#include <dbwrapper.h>
+#include <interfaces/chain.h>
+#include <logging.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <ios>
+#include <string>
+#include <utility>
+
+/**
+ * Keys and helpers shared by the indexes that store one value per block,
+ * both by height for the active chain and by hash for blocks that were
+ * disconnected in a reorg.
+ */
+namespace index_util {
+
+static constexpr uint8_t DB_BLOCK_HASH{'s'};
+static constexpr uint8_t DB_BLOCK_HEIGHT{'t'};
+
+struct DBHeightKey {
+    int height;
+
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHashKey {
+    uint256 block_hash;
+
+    explicit DBHashKey(const uint256& hash_in) : block_hash(hash_in) {}
+
+    SERIALIZE_METHODS(DBHashKey, obj)
+    {
+        uint8_t prefix{DB_BLOCK_HASH};
+        READWRITE(prefix);
+        if (prefix != DB_BLOCK_HASH) {
+            throw std::ios_base::failure("Invalid format for index DB hash key");
+        }
+
+        READWRITE(obj.block_hash);
+    }
+};
+
+/**
+ * Copy the values of the blocks from start_height to stop_height from the
+ * height index to the hash index, so that they can still be found once the
+ * height index entries are overwritten by a reorg.
+ */
+template <typename DBVal>
+[[nodiscard]] bool CopyHeightIndexToHashIndex(CDBIterator& db_it, CDBBatch& batch,
+                                              const std::string& index_name,
+                                              int start_height, int stop_height)
+{
+    DBHeightKey key{start_height};
+    db_it.Seek(key);
+
+    for (int height = start_height; height <= stop_height; ++height) {
+        if (!db_it.GetKey(key) || key.height != height) {
+            LogError("%s: unexpected key in %s: expected (%c, %d)\n",
+                     __func__, index_name, DB_BLOCK_HEIGHT, height);
+            return false;
+        }
+
+        std::pair<uint256, DBVal> value;
+        if (!db_it.GetValue(value)) {
+            LogError("%s: unable to read value in %s at key (%c, %d)\n",
+                     __func__, index_name, DB_BLOCK_HEIGHT, height);
+            return false;
+        }
+
+        batch.Write(DBHashKey(value.first), std::move(value.second));
+
+        db_it.Next();
+    }
+    return true;
+}
+
+template <typename DBVal>
+bool LookUpOne(const CDBWrapper& db, const interfaces::BlockKey& block, DBVal& result)
+{
+    // First check if the result is stored under the height index and the value
+    // there matches the block hash. This should be the case if the block is on
+    // the active chain.
+    std::pair<uint256, DBVal> read_out;
+    if (!db.Read(DBHeightKey(block.height), read_out)) {
+        return false;
+    }
+    if (read_out.first == block.hash) {
+        result = std::move(read_out.second);
+        return true;
+    }
+
+    // If value at the height index corresponds to an different block, the
+    // result will be stored in the hash index.
+    return db.Read(DBHashKey(block.hash), result);
+}
+
+} // namespace index_util
+
+#endif // KEVACOIN_INDEX_DB_KEY_H
@@ -0,0 +1,177 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/kevahistoryindex.h>
+
+#include <common/args.h>
+#include <keva/common.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <script/keva.h>
+#include <serialize.h>
+
+/* History entries, keyed by namespace, key, height and sequence number.  */
+constexpr uint8_t DB_KEVA_HISTORY{'h'};
+/* Per height list of the history entries added by the block at that height.  */
+constexpr uint8_t DB_BLOCK_KEYS{'k'};
+
+std::unique_ptr<KevaHistoryIndex> g_keva_history_index;
+
+namespace {
+
+struct HistoryKey {
+    uint8_t prefix{DB_KEVA_HISTORY};
+    valtype nameSpace;
+    valtype key;
+    uint32_t height{0};
+    uint32_t seq{0};
+
+    SERIALIZE_METHODS(HistoryKey, obj)
+    {
+        // Big endian, so that the versions of a key are sorted by height.
+        READWRITE(obj.prefix, obj.nameSpace, obj.key,
+                  Using<BigEndianFormatter<4>>(obj.height), Using<BigEndianFormatter<4>>(obj.seq));
+    }
+};
+
+struct HistoryValue {
+    COutPoint outpoint;
+    bool deleted{false};
+    valtype value;
+
+    SERIALIZE_METHODS(HistoryValue, obj) { READWRITE(obj.outpoint, obj.deleted, obj.value); }
+};
+
+struct BlockKeysKey {
+    uint8_t prefix{DB_BLOCK_KEYS};
+    uint32_t height{0};
+
+    SERIALIZE_METHODS(BlockKeysKey, obj) { READWRITE(obj.prefix, Using<BigEndianFormatter<4>>(obj.height)); }
+};
+
+/** The (namespace, key) pairs of the history entries of one block, in seq order.  */
+using BlockKeys = std::vector<std::pair<valtype, valtype>>;
+
+} // namespace
+
+/** Access to the keva history index database (indexes/kevahistory/) */
+class KevaHistoryIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Write the history entries of the block at the given height, replacing
+    /// whatever was stored for that height before (e.g. if the index was not
+    /// committed before a restart).
+    [[nodiscard]] bool WriteBlock(uint32_t height, const std::vector<std::pair<HistoryKey, HistoryValue>>& entries);
+
+    /// Erase the history entries of the blocks in (new_height, current_height].
+    [[nodiscard]] bool EraseBlocks(uint32_t new_height, uint32_t current_height);
+};
+
+KevaHistoryIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "kevahistory", n_cache_size, f_memory, f_wipe)
+{}
+
+bool KevaHistoryIndex::DB::WriteBlock(uint32_t height, const std::vector<std::pair<HistoryKey, HistoryValue>>& entries)
+{
+    CDBBatch batch(*this);
+    BlockKeys keys;
+    if (Read(BlockKeysKey{.height = height}, keys)) {
+        for (uint32_t seq = 0; seq < keys.size(); ++seq) {
+            batch.Erase(HistoryKey{.nameSpace = keys[seq].first, .key = keys[seq].second, .height = height, .seq = seq});
+        }
+        keys.clear();
+    }
+    keys.reserve(entries.size());
+    for (const auto& [key, value] : entries) {
+        batch.Write(key, value);
+        keys.emplace_back(key.nameSpace, key.key);
+    }
+    if (keys.empty()) {
+        batch.Erase(BlockKeysKey{.height = height});
+    } else {
+        batch.Write(BlockKeysKey{.height = height}, keys);
+    }
+    return WriteBatch(batch);
+}
+
+bool KevaHistoryIndex::DB::EraseBlocks(uint32_t new_height, uint32_t current_height)
+{
+    CDBBatch batch(*this);
+    for (uint32_t height = current_height; height > new_height; --height) {
+        BlockKeys keys;
+        if (!Read(BlockKeysKey{.height = height}, keys)) continue;
+        for (uint32_t seq = 0; seq < keys.size(); ++seq) {
+            batch.Erase(HistoryKey{.nameSpace = keys[seq].first, .key = keys[seq].second, .height = height, .seq = seq});
+        }
+        batch.Erase(BlockKeysKey{.height = height});
+    }
+    return WriteBatch(batch);
+}
+
+KevaHistoryIndex::KevaHistoryIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "kevahistoryindex"), m_db(std::make_unique<KevaHistoryIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+KevaHistoryIndex::~KevaHistoryIndex() = default;
+
+bool KevaHistoryIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    assert(block.data);
+    std::vector<std::pair<HistoryKey, HistoryValue>> entries;
+    for (const auto& tx : block.data->vtx) {
+        if (!tx->IsKevacoin()) continue;
+        for (const auto& [i, op] : tx->GetKevaOutputs()) {
+            HistoryKey key{.nameSpace = op.getOpNamespace(), .height = static_cast<uint32_t>(block.height),
+                           .seq = static_cast<uint32_t>(entries.size())};
+            HistoryValue value{.outpoint = COutPoint(tx->GetHash(), i)};
+            if (op.isNamespaceRegistration()) {
+                key.key = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
+                value.value = op.getOpNamespaceDisplayName();
+            } else {
+                key.key = op.getOpKey();
+                value.deleted = op.isDelete();
+                if (!value.deleted) value.value = op.getOpValue();
+            }
+            entries.emplace_back(std::move(key), std::move(value));
+        }
+    }
+    return m_db->WriteBlock(block.height, entries);
+}
+
+bool KevaHistoryIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    return m_db->EraseBlocks(new_tip.height, current_tip.height);
+}
+
+BaseIndex::DB& KevaHistoryIndex::GetDB() const { return *m_db; }
+
+bool KevaHistoryIndex::FindHistory(const valtype& nameSpace, const valtype& key, std::pair<uint32_t, uint32_t> start,
+                                   size_t count, std::vector<KevaHistoryEntry>& entries) const
+{
+    std::unique_ptr<CDBIterator> it{m_db->NewIterator()};
+    it->Seek(HistoryKey{.nameSpace = nameSpace, .key = key, .height = start.first, .seq = start.second});
+    for (; it->Valid(); it->Next()) {
+        HistoryKey db_key;
+        if (!it->GetKey(db_key) || db_key.prefix != DB_KEVA_HISTORY
+            || db_key.nameSpace != nameSpace || db_key.key != key) {
+            return false;
+        }
+        if (entries.size() >= count) return true;
+
+        HistoryValue value;
+        if (!it->GetValue(value)) {
+            LogError("%s: Cannot read history entry\n", __func__);
+            return false;
+        }
+        entries.push_back(KevaHistoryEntry{
+            .height = db_key.height,
+            .seq = db_key.seq,
+            .outpoint = value.outpoint,
+            .deleted = value.deleted,
+            .value = std::move(value.value)});
+    }
+    return false;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KEVACOIN_INDEX_KEVAHISTORYINDEX_H
+#define KEVACOIN_INDEX_KEVAHISTORYINDEX_H
+
+#include <index/base.h>
+#include <primitives/transaction.h>
+
+#include <cstdint>
+#include <vector>
+
+typedef std::vector<unsigned char> valtype;
+
+static constexpr bool DEFAULT_KEVAHISTORYINDEX{false};
+
+/** A single confirmed operation on a keva key.  */
+struct KevaHistoryEntry {
+    //! Height of the block containing the operation.
+    uint32_t height{0};
+    //! Position of the operation among the keva operations of its block.
+    uint32_t seq{0};
+    //! Output carrying the operation.
+    COutPoint outpoint;
+    //! Whether the key was deleted rather than set.
+    bool deleted{false};
+    //! The new value (empty for deletions).
+    valtype value;
+};
+
+/**
+ * KevaHistoryIndex records every confirmed put and delete of each keva
+ * (namespace, key) pair, including namespace registrations as puts of the
+ * display name key, so that the history of a key can be read without
+ * rescanning the block chain.
+ */
+class KevaHistoryIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit KevaHistoryIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~KevaHistoryIndex() override;
+
+    /// Look up the history of a key, oldest operation first.
+    ///
+    /// @param[in]   nameSpace  The namespace.
+    /// @param[in]   key  The key.
+    /// @param[in]   start  Only return operations at or after this (height, seq).
+    /// @param[in]   count  Maximum number of operations to return.
+    /// @param[out]  entries  The operations found.
+    /// @return  true if there are more operations after the returned ones
+    bool FindHistory(const valtype& nameSpace, const valtype& key, std::pair<uint32_t, uint32_t> start,
+                     size_t count, std::vector<KevaHistoryEntry>& entries) const;
+};
+
+/// The global keva history index. May be null.
+extern std::unique_ptr<KevaHistoryIndex> g_keva_history_index;
+
+#endif // KEVACOIN_INDEX_KEVAHISTORYINDEX_H
@@ -0,0 +1,227 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/kevastatsindex.h>
+
+#include <common/args.h>
+#include <crypto/muhash.h>
+#include <index/db_key.h>
+#include <keva/main.h>
+#include <kernel/coinstats.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <serialize.h>
+#include <undo.h>
+#include <validation.h>
+
+using index_util::CopyHeightIndexToHashIndex;
+using index_util::DBHashKey;
+using index_util::DBHeightKey;
+using index_util::LookUpOne;
+using kernel::ApplyKevaEntryHash;
+using kernel::CKevaStats;
+using kernel::RemoveKevaEntryHash;
+
+static constexpr uint8_t DB_MUHASH{'M'};
+
+namespace {
+
+struct DBVal {
+    uint256 muhash;
+    uint64_t entries_count;
+
+    SERIALIZE_METHODS(DBVal, obj) { READWRITE(obj.muhash, obj.entries_count); }
+};
+
+} // namespace
+
+std::unique_ptr<KevaStatsIndex> g_keva_stats_index;
+
+KevaStatsIndex::KevaStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "kevastatsindex")
+{
+    fs::path path{gArgs.GetDataDirNet() / "indexes" / "kevastats"};
+    fs::create_directories(path);
+
+    m_db = std::make_unique<KevaStatsIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+bool KevaStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // The genesis block has no undo data, and no keva operations.
+    if (block.height > 0) {
+        const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+        CBlockUndo block_undo;
+        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+            return false;
+        }
+
+        assert(block.data);
+        for (const auto& change : GetKevaEntryChanges(*block.data, block_undo, block.height)) {
+            if (change.oldData) {
+                RemoveKevaEntryHash(m_muhash, change.nameSpace, change.key, *change.oldData);
+                --m_entries_count;
+            }
+            if (change.newData) {
+                ApplyKevaEntryHash(m_muhash, change.nameSpace, change.key, *change.newData);
+                ++m_entries_count;
+            }
+        }
+    }
+
+    std::pair<uint256, DBVal> value;
+    value.first = block.hash;
+    value.second.entries_count = m_entries_count;
+    m_muhash.Finalize(value.second.muhash);
+
+    // Intentionally do not update DB_MUHASH here so it stays in sync with
+    // DB_BEST_BLOCK, and the index is not corrupted if there is an unclean shutdown.
+    return m_db->Write(DBHeightKey(block.height), value);
+}
+
+bool KevaStatsIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    CDBBatch batch(*m_db);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+
+    // During a reorg, we need to copy all hash digests for blocks that are
+    // getting disconnected from the height index to the hash index so we can
+    // still find them when the height index entries are overwritten.
+    if (!CopyHeightIndexToHashIndex<DBVal>(*db_it, batch, m_name, new_tip.height, current_tip.height)) {
+        return false;
+    }
+
+    if (!m_db->WriteBatch(batch)) return false;
+
+    {
+        LOCK(cs_main);
+        const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+        const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+
+        do {
+            CBlock block;
+
+            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *iter_tip)) {
+                LogError("%s: Failed to read block %s from disk\n",
+                         __func__, iter_tip->GetBlockHash().ToString());
+                return false;
+            }
+
+            if (!ReverseBlock(block, iter_tip)) {
+                return false; // failure cause logged internally
+            }
+
+            iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+        } while (new_tip_index != iter_tip);
+    }
+
+    return true;
+}
+
+std::optional<CKevaStats> KevaStatsIndex::LookUpStats(const CBlockIndex& block_index) const
+{
+    CKevaStats stats{block_index.nHeight, block_index.GetBlockHash()};
+    stats.index_used = true;
+
+    DBVal entry;
+    if (!LookUpOne(*m_db, {block_index.GetBlockHash(), block_index.nHeight}, entry)) {
+        return std::nullopt;
+    }
+
+    stats.muhash = entry.muhash;
+    stats.entries_count = entry.entries_count;
+
+    return stats;
+}
+
+bool KevaStatsIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
+{
+    if (!m_db->Read(DB_MUHASH, m_muhash)) {
+        // Check that the cause of the read failure is that the key does not
+        // exist. Any other errors indicate database corruption or a disk
+        // failure, and starting the index would cause further corruption.
+        if (m_db->Exists(DB_MUHASH)) {
+            LogError("%s: Cannot read current %s state; index may be corrupted\n",
+                     __func__, GetName());
+            return false;
+        }
+    }
+
+    if (block) {
+        DBVal entry;
+        if (!LookUpOne(*m_db, *block, entry)) {
+            LogError("%s: Cannot read current %s state; index may be corrupted\n",
+                     __func__, GetName());
+            return false;
+        }
+
+        uint256 out;
+        m_muhash.Finalize(out);
+        if (entry.muhash != out) {
+            LogError("%s: Cannot read current %s state; index may be corrupted\n",
+                     __func__, GetName());
+            return false;
+        }
+
+        m_entries_count = entry.entries_count;
+    }
+
+    return true;
+}
+
+bool KevaStatsIndex::CustomCommit(CDBBatch& batch)
+{
+    // DB_MUHASH should always be committed in a batch together with DB_BEST_BLOCK
+    // to prevent an inconsistent state of the DB.
+    batch.Write(DB_MUHASH, m_muhash);
+    return true;
+}
+
+// Reverse a single block as part of a reorg
+bool KevaStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block is never disconnected.
+    assert(pindex->nHeight > 0);
+
+    CBlockUndo block_undo;
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+
+    std::pair<uint256, DBVal> read_out;
+    if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+        return false;
+    }
+
+    uint256 expected_block_hash{pindex->pprev->GetBlockHash()};
+    if (read_out.first != expected_block_hash) {
+        LogPrintf("WARNING: previous block header belongs to unexpected block %s; expected %s\n",
+                  read_out.first.ToString(), expected_block_hash.ToString());
+
+        if (!m_db->Read(DBHashKey(expected_block_hash), read_out)) {
+            LogError("%s: previous block header not found; expected %s\n",
+                     __func__, expected_block_hash.ToString());
+            return false;
+        }
+    }
+
+    for (const auto& change : GetKevaEntryChanges(block, block_undo, pindex->nHeight)) {
+        if (change.newData) {
+            RemoveKevaEntryHash(m_muhash, change.nameSpace, change.key, *change.newData);
+            --m_entries_count;
+        }
+        if (change.oldData) {
+            ApplyKevaEntryHash(m_muhash, change.nameSpace, change.key, *change.oldData);
+            ++m_entries_count;
+        }
+    }
+
+    // Check that the rolled back internal values are consistent with the DB read out
+    uint256 out;
+    m_muhash.Finalize(out);
+    Assert(read_out.second.muhash == out);
+    Assert(m_entries_count == read_out.second.entries_count);
+
+    return true;
+}
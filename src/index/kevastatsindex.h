@@ -0,0 +1,62 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef KEVACOIN_INDEX_KEVASTATSINDEX_H
+#define KEVACOIN_INDEX_KEVASTATSINDEX_H
+
+#include <crypto/muhash.h>
+#include <index/base.h>
+
+#include <cstdint>
+#include <optional>
+
+class CBlockIndex;
+class CDBBatch;
+namespace kernel {
+struct CKevaStats;
+}
+
+static constexpr bool DEFAULT_KEVASTATSINDEX{false};
+
+/**
+ * KevaStatsIndex maintains a MuHash of the keva entries after every block,
+ * updated incrementally from the block and its undo data, so that the keva
+ * state commitment of any block is available without scanning the keva
+ * database.
+ */
+class KevaStatsIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    MuHash3072 m_muhash;
+    uint64_t m_entries_count{0};
+
+    [[nodiscard]] bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+
+    bool CustomCommit(CDBBatch& batch) override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+public:
+    // Constructs the index, which becomes available to be queried.
+    explicit KevaStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Look up the keva stats for a specific block using CBlockIndex
+    std::optional<kernel::CKevaStats> LookUpStats(const CBlockIndex& block_index) const;
+};
+
+/// The global keva state hash object.
+extern std::unique_ptr<KevaStatsIndex> g_keva_stats_index;
+
+#endif // KEVACOIN_INDEX_KEVASTATSINDEX_H
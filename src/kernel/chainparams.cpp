@@ -236,7 +236,7 @@ public:
         };
     }
 
-    int DefaultCheckKevaDB() const
+    int DefaultCheckKevaDB() const override
     {
         return -1;
     }
@@ -347,7 +347,7 @@ public:
         };
     }
 
-    int DefaultCheckKevaDB() const
+    int DefaultCheckKevaDB() const override
     {
         return -1;
     }
@@ -477,7 +477,7 @@ public:
         m_is_mockable_chain = false;
     }
 
-    int DefaultCheckKevaDB() const
+    int DefaultCheckKevaDB() const override
     {
         return -1;
     }
@@ -622,9 +622,9 @@ public:
         bech32_hrp = "rkva";
     }
 
-    int DefaultCheckKevaDB() const
+    int DefaultCheckKevaDB() const override
     {
-        return 0;
+        return -1;
     }
 
     /**
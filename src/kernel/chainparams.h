@@ -98,8 +98,8 @@ public:
     const CBlock& GenesisBlock() const { return genesis; }
     /** Default value for -checkmempool and -checkblockindex argument */
     bool DefaultConsistencyChecks() const { return fDefaultConsistencyChecks; }
-    // /** Default value for -checkkevadb argument */
-    // virtual int DefaultCheckKevaDB() const = 0;
+    /** Default value for -checkkevadb argument */
+    virtual int DefaultCheckKevaDB() const = 0;
     /** If this chain is exclusively used for testing */
     bool IsTestChain() const { return m_chain_type != ChainType::MAIN; }
     /** If this chain allows time to be mocked */
@@ -164,6 +164,8 @@ public:
     static std::unique_ptr<const CChainParams> Main();
     static std::unique_ptr<const CChainParams> TestNet();
 
+    virtual ~CChainParams() = default;
+
 protected:
     CChainParams() {}
 
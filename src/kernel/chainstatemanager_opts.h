@@ -22,6 +22,7 @@ class ValidationSignals;
 
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
+static constexpr bool DEFAULT_TRUST_CHECKED_POW{false};
 
 namespace kernel {
 
@@ -41,6 +42,11 @@ struct ChainstateManagerOpts {
     std::optional<uint256> assumed_valid_block{};
     //! If the tip is older than this, the node is considered to be in initial block download.
     std::chrono::seconds max_tip_age{DEFAULT_MAX_TIP_AGE};
+    //! Whether to skip recomputing the proof of work of blocks that were
+    //! already verified, i.e. blocks marked BLOCK_POW_CHECKED and blocks
+    //! reindexed from our own block files that are ancestors of the assumed
+    //! valid block (see IsTrustedBlockFilePoW).
+    bool trust_checked_pow{DEFAULT_TRUST_CHECKED_POW};
     DBOptions block_tree_db{};
     DBOptions coins_db{};
     CoinsViewOptions coins_view{};
@@ -98,6 +98,33 @@ static void ApplyHash(T& hash_obj, const Txid& hash, const std::map<uint32_t, Co
     }
 }
 
+//! The keva state is hashed after the coins, so that the hash of a UTXO set
+//! without keva entries is unaffected by it.  The same warning as for
+//! ApplyHash applies.
+static void ApplyKevaHash(HashWriter& ss, bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+    ss << association << nameSpace << key << data;
+}
+
+static void ApplyKevaHash(MuHash3072& muhash, bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data) {}
+static void ApplyKevaHash(std::nullptr_t, bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data) {}
+
+//! The keva state commitment of the kevastatsindex.  Namespace associations
+//! are derived from the entries, and not committed to.
+void ApplyKevaEntryHash(MuHash3072& muhash, const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+    DataStream ss{};
+    ss << nameSpace << key << data;
+    muhash.Insert(MakeUCharSpan(ss));
+}
+
+void RemoveKevaEntryHash(MuHash3072& muhash, const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+    DataStream ss{};
+    ss << nameSpace << key << data;
+    muhash.Remove(MakeUCharSpan(ss));
+}
+
 static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -117,6 +144,8 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
 {
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
+    // Created together with the coins cursor, so that both see the same state.
+    std::unique_ptr<CKevaViewCursor> keva_cursor(view->KevaCursor());
 
     Txid prevkey;
     std::map<uint32_t, Coin> outputs;
@@ -144,6 +173,20 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         ApplyHash(hash_obj, prevkey, outputs);
     }
 
+    for (; keva_cursor && keva_cursor->Valid(); keva_cursor->Next()) {
+        if (interruption_point) interruption_point();
+        bool association;
+        valtype nameSpace;
+        valtype key;
+        CKevaData data;
+        if (!keva_cursor->GetKey(association, nameSpace, key) || !keva_cursor->GetValue(data)) {
+            LogError("%s: unable to read keva value\n", __func__);
+            return false;
+        }
+        ApplyKevaHash(hash_obj, association, nameSpace, key, data);
+        stats.keva_count++;
+    }
+
     FinalizeHash(hash_obj, stats);
 
     stats.nDiskSize = view->EstimateSize();
@@ -179,6 +222,35 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
     return stats;
 }
 
+std::optional<CKevaStats> ComputeKevaStats(CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point)
+{
+    // The view is only written with cs_main held, so the cursor and the best
+    // block are consistent.
+    std::unique_ptr<CKevaViewCursor> cursor;
+    CBlockIndex* pindex = WITH_LOCK(::cs_main, cursor = view->KevaCursor(); return blockman.LookupBlockIndex(view->GetBestBlock()));
+    if (!cursor) return std::nullopt;
+    CKevaStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
+
+    MuHash3072 muhash;
+    for (; cursor->Valid(); cursor->Next()) {
+        if (interruption_point) interruption_point();
+        bool association;
+        valtype nameSpace;
+        valtype key;
+        CKevaData data;
+        if (!cursor->GetKey(association, nameSpace, key) || !cursor->GetValue(data)) {
+            LogError("%s: unable to read keva value\n", __func__);
+            return std::nullopt;
+        }
+        // Entries come first, and the associations are not committed to.
+        if (association) break;
+        ApplyKevaEntryHash(muhash, nameSpace, key, data);
+        stats.entries_count++;
+    }
+    muhash.Finalize(stats.muhash);
+    return stats;
+}
+
 static void FinalizeHash(HashWriter& ss, CCoinsStats& stats)
 {
     stats.hashSerialized = ss.GetHash();
@@ -13,8 +13,10 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <vector>
 
 class CCoinsView;
+class CKevaData;
 class Coin;
 class COutPoint;
 class CScript;
@@ -22,6 +24,8 @@ namespace node {
 class BlockManager;
 } // namespace node
 
+typedef std::vector<unsigned char> valtype;
+
 namespace kernel {
 enum class CoinStatsHashType {
     HASH_SERIALIZED,
@@ -43,6 +47,9 @@ struct CCoinsStats {
     //! The number of coins contained.
     uint64_t coins_count{0};
 
+    //! The number of keva entries and namespace associations contained.
+    uint64_t keva_count{0};
+
     //! Signals if the coinstatsindex was used to retrieve the statistics.
     bool index_used{false};
 
@@ -77,6 +84,28 @@ void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& co
 void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+
+/** Statistics about the keva entries (excluding namespace associations). */
+struct CKevaStats {
+    int nHeight{0};
+    uint256 hashBlock{};
+    //! The number of keva entries contained.
+    uint64_t entries_count{0};
+    //! MuHash of all keva entries.
+    uint256 muhash{};
+
+    //! Signals if the kevastatsindex was used to retrieve the statistics.
+    bool index_used{false};
+
+    CKevaStats() = default;
+    CKevaStats(int block_height, const uint256& block_hash) : nHeight(block_height), hashBlock(block_hash) {}
+};
+
+void ApplyKevaEntryHash(MuHash3072& muhash, const valtype& nameSpace, const valtype& key, const CKevaData& data);
+void RemoveKevaEntryHash(MuHash3072& muhash, const valtype& nameSpace, const valtype& key, const CKevaData& data);
+
+//! Calculate the keva statistics by a full scan of the keva entries of a view.
+std::optional<CKevaStats> ComputeKevaStats(CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
 } // namespace kernel
 
 #endif // KEVACOIN_KERNEL_COINSTATS_H
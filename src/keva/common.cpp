@@ -8,9 +8,33 @@
 
 #include <keva/common.h>
 // #include <base58.h>
+#include <core_memusage.h>
+#include <crypto/siphash.h>
 #include <key_io.h>
+#include <memusage.h>
+#include <random.h>
 #include <script/keva.h>
 
+#include <cassert>
+
+
+/* ************************************************************************** */
+/* SaltedKevaKeyHasher.  */
+
+SaltedKevaKeyHasher::SaltedKevaKeyHasher()
+  : k0(GetRand<uint64_t>()), k1(GetRand<uint64_t>())
+{}
+
+size_t SaltedKevaKeyHasher::operator() (const std::pair<valtype, valtype>& name) const
+{
+  /* Prefix the namespace by its length, so that the boundary between
+     namespace and key is unambiguous.  */
+  return CSipHasher(k0, k1)
+            .Write(name.first.size())
+            .Write(name.first)
+            .Write(name.second)
+            .Finalize();
+}
 
 /* ************************************************************************** */
 /* CKevaData.  */
@@ -126,7 +150,7 @@ void CCacheKeyIterator::advanceBaseIterator()
 void CCacheKeyIterator::seek(const valtype& start)
 {
   auto &entries = isAssociation ? cache.associations : cache.entries;
-  cacheIter = entries.lower_bound(std::make_tuple(nameSpace, start));
+  cacheIter = entries.lower_bound(CKevaCache::NamespaceKeyRef(nameSpace, start));
   base->seek(start);
 
   baseHasMore = true;
@@ -138,14 +162,7 @@ bool CCacheKeyIterator::next(valtype& key, CKevaData& data)
   /* Exit early if no more data is available in either the cache
      nor the base iterator.  */
   auto &entries = isAssociation ? cache.associations : cache.entries;
-  bool endOfCacheNamespace = false;
-  if (cacheIter != entries.end()) {
-    valtype curNameSpace = std::get<0>(cacheIter->first);
-    if (curNameSpace != nameSpace) {
-      endOfCacheNamespace = true;
-    }
-  }
-  bool noMoreCache = (cacheIter == entries.end()) || endOfCacheNamespace;
+  const bool noMoreCache = (cacheIter == entries.end()) || std::get<0>(cacheIter->first) != nameSpace;
   if (!baseHasMore && noMoreCache) {
     return false;
   }
@@ -154,7 +171,7 @@ bool CCacheKeyIterator::next(valtype& key, CKevaData& data)
   bool useBase = false;
   if (!baseHasMore) {
     useBase = false;
-  } else if (cacheIter == entries.end()) {
+  } else if (noMoreCache) {
     useBase = true;
   } else {
     if (baseKey == std::get<1>(cacheIter->first)) {
@@ -171,8 +188,8 @@ bool CCacheKeyIterator::next(valtype& key, CKevaData& data)
     } else {
       assert(baseKey != std::get<1>(cacheIter->first));
 
-      CKevaCache::KeyComparator cmp;
-      useBase = cmp(std::make_tuple(nameSpace, baseKey), cacheIter->first);
+      useBase = CKevaCache::KeyComparator::less(nameSpace, baseKey,
+                                                std::get<0>(cacheIter->first), std::get<1>(cacheIter->first));
     }
   }
 
@@ -194,7 +211,7 @@ bool CCacheKeyIterator::next(valtype& key, CKevaData& data)
 
 bool CKevaCache::get(const valtype& nameSpace, const valtype& key, CKevaData& data) const
 {
-  const EntryMap::const_iterator i = entries.find(std::make_tuple(nameSpace, key));
+  const EntryMap::const_iterator i = entries.find(NamespaceKeyRef(nameSpace, key));
   if (i == entries.end())
     return false;
 
@@ -207,40 +224,44 @@ bool CKevaCache::GetNamespace(const valtype& nameSpace, CKevaData& data) const
   return get(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data);
 }
 
-void CKevaCache::setNamespace(const valtype& nameSpace, const CKevaData& data)
+void CKevaCache::setNamespace(const valtype& nameSpace, const CKevaData& data, std::optional<unsigned> oldHeight)
 {
-  set(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data);
+  set(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data, oldHeight);
 }
 
-void CKevaCache::set(const valtype& nameSpace, const valtype& key, const CKevaData& data)
+void CKevaCache::set(const valtype& nameSpace, const valtype& key, const CKevaData& data,
+                     std::optional<unsigned> oldHeight)
 {
-  auto name = std::make_tuple(nameSpace, key);
-  const std::set<NamespaceKeyType>::iterator di = deleted.find(name);
-  if (di != deleted.end()) {
-    deleted.erase(di);
-  }
-
-  const EntryMap::iterator ei = entries.find(name);
-  if (ei != entries.end())
-    ei->second = data;
-  else
-    entries.insert(std::make_pair(name, data));
+  const NamespaceKeyRef name(nameSpace, key);
+  recordOldHeight(name, oldHeight);
+  eraseName(deleted, name);
+  setEntry(entries, name, data);
 }
 
-void CKevaCache::remove(const valtype& nameSpace, const valtype& key)
+void CKevaCache::remove(const valtype& nameSpace, const valtype& key, std::optional<unsigned> oldHeight)
 {
-  auto name = std::make_tuple(nameSpace, key);
-  const EntryMap::iterator ei = entries.find(name);
-  if (ei != entries.end()) {
-    entries.erase(ei);
-  }
+  const NamespaceKeyRef name(nameSpace, key);
+  recordOldHeight(name, oldHeight);
+  eraseEntry(entries, name);
+  insertName(deleted, name);
+}
 
-  deleted.insert(name);
+std::optional<unsigned> CKevaCache::getOldHeight(const NamespaceKeyType& name) const
+{
+  const auto it = oldHeights.find(name);
+  if (it == oldHeights.end())
+    return std::nullopt;
+  return it->second;
 }
 
 /* If the value is an associated namespace (_A_N...), return the namespace */
 bool CKevaCache::getAssociateNamespaces(const valtype& value, valtype& nameSpace)
 {
+  /* Most keys are not associations, reject them before copying.  */
+  const std::string& prefix = CKevaData::ASSOCIATE_PREFIX;
+  if (value.size() < prefix.size() || !std::equal(prefix.begin(), prefix.end(), value.begin())) {
+    return false;
+  }
   std::string valueStr = ValtypeToString(value);
   if (valueStr.rfind(CKevaData::ASSOCIATE_PREFIX, 0) != 0) {
     return false;
@@ -254,29 +275,115 @@ bool CKevaCache::getAssociateNamespaces(const valtype& value, valtype& nameSpace
 
 void CKevaCache::associateNamespaces(const valtype& nameSpace, const valtype& nameSpaceOther, const CKevaData& data)
 {
-  auto name = std::make_tuple(nameSpaceOther, nameSpace);
-  const std::set<NamespaceKeyType>::iterator di = disassociations.find(name);
-  if (di != disassociations.end()) {
-    disassociations.erase(di);
+  const NamespaceKeyRef name(nameSpaceOther, nameSpace);
+  eraseName(disassociations, name);
+  setEntry(associations, name, data);
+}
+
+void CKevaCache::disassociateNamespaces(const valtype& nameSpace, const valtype& nameSpaceOther)
+{
+  const NamespaceKeyRef name(nameSpaceOther, nameSpace);
+  eraseEntry(associations, name);
+  insertName(disassociations, name);
+}
+
+size_t CKevaCache::keyUsage(const NamespaceKeyType& name)
+{
+  return memusage::DynamicUsage(std::get<0>(name)) + memusage::DynamicUsage(std::get<1>(name));
+}
+
+size_t CKevaCache::dataUsage(const CKevaData& data)
+{
+  return memusage::DynamicUsage(data.getValue()) + RecursiveDynamicUsage(data.getAddress());
+}
+
+/* Construct an owning copy of a namespace/key view.  This is only done
+   when a new element is actually inserted.  */
+static CKevaCache::NamespaceKeyType MakeNamespaceKey(const CKevaCache::NamespaceKeyRef& name)
+{
+  return std::make_tuple(valtype(name.first.begin(), name.first.end()),
+                         valtype(name.second.begin(), name.second.end()));
+}
+
+void CKevaCache::insertName(NameSet& names, const NamespaceKeyRef& name)
+{
+  auto it = names.lower_bound(name);
+  if (it != names.end() && !names.key_comp()(name, *it)) {
+    return;
   }
+  it = names.emplace_hint(it, MakeNamespaceKey(name));
+  cachedUsage += keyUsage(*it);
+}
 
-  const NamespaceMap::iterator ei = associations.find(name);
-  if (ei != associations.end()) {
-    ei->second = data;
+void CKevaCache::eraseName(NameSet& names, const NamespaceKeyRef& name)
+{
+  const auto it = names.find(name);
+  if (it != names.end()) {
+    cachedUsage -= keyUsage(*it);
+    names.erase(it);
+  }
+}
+
+void CKevaCache::setEntry(EntryMap& map, const NamespaceKeyRef& name, const CKevaData& data)
+{
+  auto it = map.lower_bound(name);
+  if (it != map.end() && !map.key_comp()(name, it->first)) {
+    cachedUsage -= dataUsage(it->second);
+    it->second = data;
   } else {
-    associations.insert(std::make_pair(name, data));
+    it = map.emplace_hint(it, MakeNamespaceKey(name), data);
+    cachedUsage += keyUsage(it->first);
   }
+  cachedUsage += dataUsage(it->second);
 }
 
-void CKevaCache::disassociateNamespaces(const valtype& nameSpace, const valtype& nameSpaceOther)
+void CKevaCache::eraseEntry(EntryMap& map, const NamespaceKeyRef& name)
 {
-  auto name = std::make_tuple(nameSpaceOther, nameSpace);
-  const NamespaceMap::iterator ei = associations.find(name);
-  if (ei != associations.end()) {
-    associations.erase(ei);
+  const auto it = map.find(name);
+  if (it != map.end()) {
+    cachedUsage -= keyUsage(it->first) + dataUsage(it->second);
+    map.erase(it);
   }
+}
 
-  disassociations.insert(name);
+void CKevaCache::recordOldHeight(const NamespaceKeyRef& name, std::optional<unsigned> oldHeight)
+{
+  /* Once a name is changed, oldHeight describes the changed data of this
+     cache rather than the underlying view.  */
+  if (!oldHeight || entries.count(name) > 0 || deleted.count(name) > 0)
+    return;
+  const auto [it, inserted] = oldHeights.emplace(MakeNamespaceKey(name), *oldHeight);
+  if (inserted)
+    cachedUsage += keyUsage(it->first);
+}
+
+size_t CKevaCache::DynamicMemoryUsage() const
+{
+  return memusage::DynamicUsage(entries) + memusage::DynamicUsage(deleted)
+          + memusage::DynamicUsage(associations) + memusage::DynamicUsage(disassociations)
+          + memusage::DynamicUsage(oldHeights) + cachedUsage;
+}
+
+void CKevaCache::SanityCheck() const
+{
+  size_t recomputedUsage = 0;
+  for (const auto& [name, data] : entries) {
+    recomputedUsage += keyUsage(name) + dataUsage(data);
+  }
+  for (const auto& [name, data] : associations) {
+    recomputedUsage += keyUsage(name) + dataUsage(data);
+  }
+  for (const auto& name : deleted) {
+    recomputedUsage += keyUsage(name);
+  }
+  for (const auto& name : disassociations) {
+    recomputedUsage += keyUsage(name);
+  }
+  for (const auto& [name, height] : oldHeights) {
+    assert(entries.count(name) > 0 || deleted.count(name) > 0);
+    recomputedUsage += keyUsage(name);
+  }
+  assert(recomputedUsage == cachedUsage);
 }
 
 CKevaIterator* CKevaCache::iterateKeys(CKevaIterator* base) const
@@ -289,28 +396,321 @@ CKevaIterator* CKevaCache::IterateAssociatedNamespaces(CKevaIterator* base) cons
   return new CCacheKeyIterator(*this, base, true);
 }
 
-void CKevaCache::updateNamesForHeight(unsigned nHeight,
-                                  std::set<valtype>& names) const
+void CKevaCache::updateKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight,
+                                       std::set<valtype>& keys) const
+{
+  /* Seek to the first cached change of the namespace.  The empty key
+     sorts before all others.  */
+  const NamespaceKeyRef first(nameSpace, Span<const unsigned char>());
+
+  for (auto i = entries.lower_bound(first);
+       i != entries.end() && std::get<0>(i->first) == nameSpace; ++i) {
+    if (i->second.getHeight() >= nMinHeight) {
+      keys.insert(std::get<1>(i->first));
+    } else {
+      keys.erase(std::get<1>(i->first));
+    }
+  }
+
+  for (auto i = deleted.lower_bound(first);
+       i != deleted.end() && std::get<0>(*i) == nameSpace; ++i) {
+    keys.erase(std::get<1>(*i));
+  }
+}
+
+void CKevaCache::updateNamesSinceHeight(unsigned nMinHeight,
+                                        std::set<NamespaceKeyType>& names) const
 {
-  /* Seek in the map of cached entries to the first one corresponding
-     to our height.  */
+  for (const auto& [name, data] : entries) {
+    if (data.getHeight() >= nMinHeight) {
+      names.insert(name);
+    } else {
+      names.erase(name);
+    }
+  }
+
+  for (const auto& name : deleted) {
+    names.erase(name);
+  }
 }
 
 void CKevaCache::apply(const CKevaCache& cache)
 {
+  /* The old heights recorded by cache are relative to this cache, so they
+     are only taken over for names that this cache did not change yet.  */
   for (EntryMap::const_iterator i = cache.entries.begin(); i != cache.entries.end(); ++i) {
-    set(std::get<0>(i->first), std::get<1>(i->first), i->second);
+    set(std::get<0>(i->first), std::get<1>(i->first), i->second, cache.getOldHeight(i->first));
   }
 
   for (NamespaceMap::const_iterator i = cache.associations.begin(); i != cache.associations.end(); ++i) {
     associateNamespaces(std::get<1>(i->first), std::get<0>(i->first), i->second);
   }
 
-  for (std::set<NamespaceKeyType>::const_iterator i = cache.deleted.begin(); i != cache.deleted.end(); ++i) {
-    remove(std::get<0>(*i), std::get<1>(*i));
+  for (NameSet::const_iterator i = cache.deleted.begin(); i != cache.deleted.end(); ++i) {
+    remove(std::get<0>(*i), std::get<1>(*i), cache.getOldHeight(*i));
   }
 
-  for (std::set<NamespaceKeyType>::const_iterator i = cache.disassociations.begin(); i != cache.disassociations.end(); ++i) {
+  for (NameSet::const_iterator i = cache.disassociations.begin(); i != cache.disassociations.end(); ++i) {
     disassociateNamespaces(std::get<1>(*i), std::get<0>(*i));
   }
 }
+
+/* ************************************************************************** */
+/* CKevaReadCache.  */
+
+size_t CKevaReadCache::entryUsage(const NamespaceKeyType& name, const Entry& entry)
+{
+  size_t usage = memusage::DynamicUsage(name.first) + memusage::DynamicUsage(name.second);
+  if (entry.found) {
+    usage += memusage::DynamicUsage(entry.data.getValue());
+    usage += RecursiveDynamicUsage(entry.data.getAddress());
+  }
+  return usage;
+}
+
+void CKevaReadCache::erase(EntryMap::iterator it)
+{
+  innerUsage -= entryUsage(it->first, it->second);
+  lru.erase(it->second.lru);
+  entries.erase(it);
+}
+
+void CKevaReadCache::trim()
+{
+  while (!lru.empty() && dynamicMemoryUsage() > maxBytes) {
+    erase(entries.find(*lru.back()));
+  }
+}
+
+void CKevaReadCache::insert(const valtype& nameSpace, const valtype& key, bool found, const CKevaData* data)
+{
+  if (maxBytes == 0) {
+    return;
+  }
+
+  auto [it, inserted] = entries.try_emplace(std::make_pair(nameSpace, key));
+  if (inserted) {
+    lru.push_front(&it->first);
+    it->second.lru = lru.begin();
+  } else {
+    innerUsage -= entryUsage(it->first, it->second);
+    lru.splice(lru.begin(), lru, it->second.lru);
+  }
+
+  it->second.found = found;
+  it->second.data = found ? *data : CKevaData();
+  innerUsage += entryUsage(it->first, it->second);
+  trim();
+}
+
+void CKevaReadCache::setMaxSize(size_t maxSize)
+{
+  maxBytes = maxSize;
+  if (maxBytes == 0) {
+    clear();
+  }
+  trim();
+}
+
+bool CKevaReadCache::get(const valtype& nameSpace, const valtype& key, bool& found, CKevaData& data)
+{
+  if (entries.empty()) {
+    return false;
+  }
+
+  const auto it = entries.find(std::make_pair(nameSpace, key));
+  if (it == entries.end()) {
+    return false;
+  }
+
+  lru.splice(lru.begin(), lru, it->second.lru);
+  found = it->second.found;
+  if (found) {
+    data = it->second.data;
+  }
+  return true;
+}
+
+bool CKevaReadCache::has(const valtype& nameSpace, const valtype& key) const
+{
+  return !entries.empty() && entries.count(std::make_pair(nameSpace, key)) > 0;
+}
+
+void CKevaReadCache::set(const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+  insert(nameSpace, key, true, &data);
+}
+
+void CKevaReadCache::setMissing(const valtype& nameSpace, const valtype& key)
+{
+  insert(nameSpace, key, false, nullptr);
+}
+
+void CKevaReadCache::remove(const valtype& nameSpace, const valtype& key)
+{
+  if (entries.empty()) {
+    return;
+  }
+
+  const auto it = entries.find(std::make_pair(nameSpace, key));
+  if (it != entries.end()) {
+    erase(it);
+  }
+}
+
+void CKevaReadCache::removeChanges(const CKevaCache& changes)
+{
+  for (const auto& [name, data] : changes.entries) {
+    remove(std::get<0>(name), std::get<1>(name));
+  }
+  for (const auto& name : changes.deleted) {
+    remove(std::get<0>(name), std::get<1>(name));
+  }
+}
+
+size_t CKevaReadCache::dynamicMemoryUsage() const
+{
+  return memusage::DynamicUsage(entries) + memusage::DynamicUsage(lru) + innerUsage;
+}
+
+/* ************************************************************************** */
+/* CKevaGroupCache.  */
+
+size_t CKevaGroupCache::entryUsage(const valtype& nameSpace, const CKevaGroup& group)
+{
+  size_t usage = memusage::DynamicUsage(nameSpace) + memusage::DynamicUsage(group.joined)
+                  + memusage::DynamicUsage(group.members);
+  for (const auto& [key, joined] : group.joined) {
+    usage += memusage::DynamicUsage(key) + memusage::DynamicUsage(joined.first)
+              + CKevaCache::dataUsage(joined.second);
+  }
+  for (const auto& [member, data] : group.members) {
+    usage += memusage::DynamicUsage(member) + CKevaCache::dataUsage(data);
+  }
+  return usage;
+}
+
+void CKevaGroupCache::erase(EntryMap::iterator it)
+{
+  innerUsage -= entryUsage(it->first, it->second.group);
+  lru.erase(it->second.lru);
+  entries.erase(it);
+}
+
+void CKevaGroupCache::trim()
+{
+  while (!lru.empty() && dynamicMemoryUsage() > maxBytes) {
+    erase(entries.find(*lru.back()));
+  }
+}
+
+template<typename F>
+void CKevaGroupCache::update(const valtype& nameSpace, F&& change)
+{
+  const auto it = entries.find(nameSpace);
+  if (it == entries.end()) {
+    return;
+  }
+
+  innerUsage -= entryUsage(it->first, it->second.group);
+  change(it->second.group);
+  innerUsage += entryUsage(it->first, it->second.group);
+  trim();
+}
+
+void CKevaGroupCache::setMaxSize(size_t maxSize)
+{
+  maxBytes = maxSize;
+  if (maxBytes == 0) {
+    clear();
+  }
+  trim();
+}
+
+bool CKevaGroupCache::get(const valtype& nameSpace, CKevaGroup& group)
+{
+  const auto it = entries.find(nameSpace);
+  if (it == entries.end()) {
+    return false;
+  }
+
+  lru.splice(lru.begin(), lru, it->second.lru);
+  group = it->second.group;
+  return true;
+}
+
+void CKevaGroupCache::set(const valtype& nameSpace, const CKevaGroup& group)
+{
+  if (maxBytes == 0) {
+    return;
+  }
+
+  auto [it, inserted] = entries.try_emplace(nameSpace);
+  if (inserted) {
+    lru.push_front(&it->first);
+    it->second.lru = lru.begin();
+  } else {
+    innerUsage -= entryUsage(it->first, it->second.group);
+    lru.splice(lru.begin(), lru, it->second.lru);
+  }
+
+  it->second.group = group;
+  innerUsage += entryUsage(it->first, it->second.group);
+  trim();
+}
+
+void CKevaGroupCache::setKey(const valtype& nameSpace, const valtype& key, const CKevaData* data)
+{
+  valtype other;
+  if (entries.empty() || !CKevaCache::getAssociateNamespaces(key, other)) {
+    return;
+  }
+
+  update(nameSpace, [&](CKevaGroup& group) {
+    if (data) {
+      group.joined[key] = std::make_pair(other, *data);
+    } else {
+      group.joined.erase(key);
+    }
+  });
+}
+
+void CKevaGroupCache::associate(const valtype& nameSpace, const valtype& nameSpaceOther, const CKevaData* data)
+{
+  if (entries.empty()) {
+    return;
+  }
+
+  update(nameSpace, [&](CKevaGroup& group) {
+    if (data) {
+      group.members[nameSpaceOther] = *data;
+    } else {
+      group.members.erase(nameSpaceOther);
+    }
+  });
+}
+
+void CKevaGroupCache::applyChanges(const CKevaCache& changes)
+{
+  if (entries.empty()) {
+    return;
+  }
+
+  for (const auto& [name, data] : changes.entries) {
+    setKey(std::get<0>(name), std::get<1>(name), &data);
+  }
+  for (const auto& [name, data] : changes.associations) {
+    associate(std::get<0>(name), std::get<1>(name), &data);
+  }
+  for (const auto& name : changes.deleted) {
+    setKey(std::get<0>(name), std::get<1>(name), nullptr);
+  }
+  for (const auto& name : changes.disassociations) {
+    associate(std::get<0>(name), std::get<1>(name), nullptr);
+  }
+}
+
+size_t CKevaGroupCache::dynamicMemoryUsage() const
+{
+  return memusage::DynamicUsage(entries) + memusage::DynamicUsage(lru) + innerUsage;
+}
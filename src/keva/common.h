@@ -14,18 +14,24 @@
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <span.h>
 
+#include <algorithm>
+#include <cstring>
+#include <list>
 #include <map>
+#include <optional>
 #include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 class CKevaScript;
 class CDBBatch;
+class CDBWrapper;
 
 typedef std::vector<unsigned char> valtype;
 
-/** Whether or not name history is enabled.  */
-extern bool fNameHistory;
-
 /**
  * Construct a valtype (e. g., name) from a string.
  * @param str The string input.
@@ -46,6 +52,29 @@ inline std::string ValtypeToString(const valtype& val)
   return std::string(val.begin(), val.end());
 }
 
+/* ************************************************************************** */
+/* SaltedKevaKeyHasher.  */
+
+/**
+ * Salted hasher for (namespace, key) pairs.  This is used for the hash
+ * maps that index keva entries in memory.
+ */
+class SaltedKevaKeyHasher
+{
+
+private:
+
+  /** Salt.  */
+  const uint64_t k0, k1;
+
+public:
+
+  SaltedKevaKeyHasher();
+
+  size_t operator() (const std::pair<valtype, valtype>& name) const;
+
+};
+
 /* ************************************************************************** */
 /* CKevaData.  */
 
@@ -166,76 +195,6 @@ public:
 
 };
 
-/* ************************************************************************** */
-/* CNameHistory.  */
-
-/**
- * Keep track of a name's history.  This is a stack of old CKevaData
- * objects that have been obsoleted.
- */
-class CNameHistory
-{
-
-private:
-
-  /** The actual data.  */
-  std::vector<CKevaData> data;
-
-public:
-
-  // SERIALIZE_METHODS(CNameHistory, obj) { READWRITE(obj.data); }
-  ADD_SERIALIZE_METHODS;
-
-  template<typename Stream, typename Operation>
-  inline void SerializationOp(Stream& s, Operation ser_action)
-  {
-    READWRITE(data);
-  }
-
-  /**
-   * Check if the stack is empty.  This is used to decide when to fully
-   * delete an entry in the database.
-   * @return True iff the data stack is empty.
-   */
-  inline bool empty() const
-  {
-    return data.empty();
-  }
-
-  /**
-   * Access the data in a read-only way.
-   * @return The data stack.
-   */
-  inline const std::vector<CKevaData>& getData() const
-  {
-    return data;
-  }
-
-  /**
-   * Push a new entry onto the data stack.  The new entry's height should
-   * be at least as high as the stack top entry's.  If not, fail.
-   * @param entry The new entry to push onto the stack.
-   */
-  inline void push(const CKevaData& entry)
-  {
-    assert (data.empty() || data.back().getHeight() <= entry.getHeight());
-    data.push_back(entry);
-  }
-
-  /**
-   * Pop the top entry off the stack.  This is used when undoing name
-   * changes.  The name's new value is passed as argument and should
-   * match the removed entry.  If not, fail.
-   * @param entry The name's value after undoing.
-   */
-  inline void pop(const CKevaData& entry)
-  {
-    assert (!data.empty() && data.back() == entry);
-    data.pop_back();
-  }
-
-};
-
 /* ************************************************************************** */
 /* CKevaIterator.  */
 
@@ -287,33 +246,76 @@ public:
 class CKevaCache
 {
 
+public:
+
+  typedef std::tuple<valtype, valtype> NamespaceKeyType;
+
+  /**
+   * Non-owning view of a namespace/key pair.  This can be used to look up
+   * entries without copying the namespace and key into a NamespaceKeyType.
+   */
+  typedef std::pair<Span<const unsigned char>, Span<const unsigned char>> NamespaceKeyRef;
+
 private:
 
   /**
    * Special comparator class for names that compares by length first.
    * This is used to sort the cache entry map in the same way as the
-   * database is sorted.
+   * database is sorted.  It is transparent, so that the containers can
+   * be searched with a NamespaceKeyRef, and never copies or allocates.
    */
   class KeyComparator
   {
+  private:
+
+    /* Compare two byte strings lexicographically, like operator< on
+       valtype does, returning <0, 0 or >0.  */
+    static inline int compareBytes(Span<const unsigned char> a, Span<const unsigned char> b)
+    {
+      const size_t len = std::min(a.size(), b.size());
+      if (len > 0) {
+        const int cmp = std::memcmp(a.data(), b.data(), len);
+        if (cmp != 0) {
+          return cmp;
+        }
+      }
+      if (a.size() == b.size()) {
+        return 0;
+      }
+      return a.size() < b.size() ? -1 : 1;
+    }
+
   public:
-    inline bool operator() (const std::tuple<valtype, valtype> a,
-                            const std::tuple<valtype, valtype> b) const
+
+    using is_transparent = void;
+
+    static inline bool less(Span<const unsigned char> nsA, Span<const unsigned char> keyA,
+                            Span<const unsigned char> nsB, Span<const unsigned char> keyB)
     {
       // This is how namespace/key pairs are sorted in database.
-      auto nsA = std::get<0>(a);
-      auto nsB = std::get<0>(b);
-      if (nsA == nsB) {
-        auto aKey = std::get<1>(a);
-        auto bKey = std::get<1>(b);
-        uint32_t aKeySize = aKey.size();
-        uint32_t bKeySize = bKey.size();
-        if (aKeySize == bKeySize) {
-          return aKey < bKey;
-        }
-        return aKeySize < bKeySize;
+      const int nsCmp = compareBytes(nsA, nsB);
+      if (nsCmp != 0) {
+        return nsCmp < 0;
       }
-      return nsA < nsB;
+      if (keyA.size() != keyB.size()) {
+        return keyA.size() < keyB.size();
+      }
+      return compareBytes(keyA, keyB) < 0;
+    }
+
+    inline bool operator() (const NamespaceKeyType& a, const NamespaceKeyType& b) const
+    {
+      return less(std::get<0>(a), std::get<1>(a), std::get<0>(b), std::get<1>(b));
+    }
+
+    inline bool operator() (const NamespaceKeyType& a, const NamespaceKeyRef& b) const
+    {
+      return less(std::get<0>(a), std::get<1>(a), b.first, b.second);
+    }
+
+    inline bool operator() (const NamespaceKeyRef& a, const NamespaceKeyType& b) const
+    {
+      return less(a.first, a.second, std::get<0>(b), std::get<1>(b));
     }
   };
 
@@ -323,11 +325,15 @@ public:
    * Type of name entry map.  This is public because it is also used
    * by the unit tests.
    */
-  typedef std::map<std::tuple<valtype, valtype>, CKevaData, KeyComparator> EntryMap;
+  typedef std::map<NamespaceKeyType, CKevaData, KeyComparator> EntryMap;
 
-  typedef std::tuple<valtype, valtype> NamespaceKeyType;
+  typedef std::map<NamespaceKeyType, CKevaData, KeyComparator> NamespaceMap;
+
+  /** Type of the sets of deleted names and disassociated namespaces.  */
+  typedef std::set<NamespaceKeyType, KeyComparator> NameSet;
 
-  typedef std::map<std::tuple<valtype, valtype>, CKevaData, KeyComparator> NamespaceMap;
+  /** Type of the map of heights of changed names in the base view.  */
+  typedef std::map<NamespaceKeyType, unsigned, KeyComparator> HeightMap;
 
 private:
 
@@ -335,15 +341,57 @@ private:
   EntryMap entries;
 
   /** Deleted names.  */
-  std::set<NamespaceKeyType> deleted;
+  NameSet deleted;
 
   /** Namespace association.  */
   NamespaceMap associations;
 
   /** Namespace disassociations.  */
-  std::set<NamespaceKeyType> disassociations;
+  NameSet disassociations;
+
+  /**
+   * For the changed (set or deleted) names that exist in the underlying
+   * view, the height of their data there.  It is recorded on the first
+   * change of a name, so that the old height index record can be dropped
+   * when the change is written to the database without reading the old
+   * entry back.
+   */
+  HeightMap oldHeights;
+
+  /**
+   * Dynamic memory usage of the namespaces, keys and data held by the
+   * containers above, excluding the container nodes themselves.  This is
+   * kept up to date incrementally, like CCoinsViewCache::cachedCoinsUsage.
+   */
+  size_t cachedUsage{0};
 
   friend class CCacheKeyIterator;
+  friend class CKevaReadCache;
+  friend class CKevaGroupCache;
+
+  /* Memory usage of the heap data of a namespace/key pair.  */
+  static size_t keyUsage(const NamespaceKeyType& name);
+
+  /* Memory usage of the heap data of an entry's data.  */
+  static size_t dataUsage(const CKevaData& data);
+
+  /* Add a name to one of the sets, keeping track of the memory usage.  */
+  void insertName(NameSet& names, const NamespaceKeyRef& name);
+
+  /* Remove a name from one of the sets, keeping track of the memory usage.  */
+  void eraseName(NameSet& names, const NamespaceKeyRef& name);
+
+  /* Insert or update an entry of one of the maps, keeping track of the
+     memory usage.  */
+  void setEntry(EntryMap& map, const NamespaceKeyRef& name, const CKevaData& data);
+
+  /* Remove an entry from one of the maps, keeping track of the memory
+     usage.  */
+  void eraseEntry(EntryMap& map, const NamespaceKeyRef& name);
+
+  /* Record the height a name has in the underlying view, unless the name
+     was already changed in this cache (and its old height recorded).  */
+  void recordOldHeight(const NamespaceKeyRef& name, std::optional<unsigned> oldHeight);
 
 public:
 
@@ -353,8 +401,17 @@ public:
     deleted.clear();
     associations.clear();
     disassociations.clear();
+    oldHeights.clear();
+    cachedUsage = 0;
   }
 
+  /* Total dynamic memory usage of the cached changes.  */
+  size_t DynamicMemoryUsage() const;
+
+  /* Recompute the memory usage from scratch and check it against the
+     incrementally tracked value.  Fails with an assertion on mismatch.  */
+  void SanityCheck() const;
+
   /**
    * Check if the cache is "clean" (no cached changes).  This also
    * performs internal checks and fails with an assertion if the
@@ -373,15 +430,13 @@ public:
   /* See if the given name is marked as deleted.  */
   inline bool isDeleted(const valtype& nameSpace, const valtype& key) const
   {
-    auto name = std::make_tuple(nameSpace, key);
-    return (deleted.count(name) > 0);
+    return (deleted.count(NamespaceKeyRef(nameSpace, key)) > 0);
   }
 
   /* See if the given namespaces are disassociated.  */
   inline bool isDisassociated(const valtype& nameSpace, const valtype& nameSpaceOther) const
   {
-    auto name = std::make_tuple(nameSpace, nameSpaceOther);
-    return (disassociations.count(name) > 0);
+    return (disassociations.count(NamespaceKeyRef(nameSpace, nameSpaceOther)) > 0);
   }
 
   /* Try to get a name's associated data.  This looks only
@@ -391,16 +446,24 @@ public:
   bool GetNamespace(const valtype& nameSpace, CKevaData& data) const;
 
   /* Insert (or update) a name.  If it is marked as "deleted", this also
-     removes the "deleted" mark.  */
-  void set(const valtype& nameSpace, const valtype& key, const CKevaData& data);
+     removes the "deleted" mark.  oldHeight is the height of the data it
+     replaces in the view this cache is on top of, or nullopt if the name
+     does not exist there.  */
+  void set(const valtype& nameSpace, const valtype& key, const CKevaData& data,
+           std::optional<unsigned> oldHeight);
 
-  void setNamespace(const valtype& nameSpace, const CKevaData& data);
+  void setNamespace(const valtype& nameSpace, const CKevaData& data, std::optional<unsigned> oldHeight);
 
-  /* Delete a name.  If it is in the "entries" set also, remove it there.  */
-  void remove(const valtype& nameSpace, const valtype& key);
+  /* Delete a name.  If it is in the "entries" set also, remove it there.
+     oldHeight is as for set.  */
+  void remove(const valtype& nameSpace, const valtype& key, std::optional<unsigned> oldHeight);
+
+  /* Height of a changed name in the underlying view, or nullopt if it
+     does not exist there (or was not changed).  */
+  std::optional<unsigned> getOldHeight(const NamespaceKeyType& name) const;
 
   /* If the value is an associated namespace (_A_N...), return the namespace */
-  bool getAssociateNamespaces(const valtype& value, valtype& nameSpace);
+  static bool getAssociateNamespaces(const valtype& value, valtype& nameSpace);
 
   /* Associate nameSpace with nameSpaceOther */
   void associateNamespaces(const valtype& nameSpace, const valtype& nameSpaceOther, const CKevaData& data);
@@ -416,18 +479,254 @@ public:
   // Get the associated namespace iterator.
   CKevaIterator* IterateAssociatedNamespaces(CKevaIterator* base) const;
 
-  /* Query the cached changes to the expire index.  In particular,
-     for a given height and a given set of names that were indexed to
-     this update height, apply possible changes to the set that
-     are represented by the cached expire index changes.  */
-  void updateNamesForHeight(unsigned nHeight, std::set<valtype>& names) const;
+  /* Query the cached changes to the height index.  In particular, for a
+     given namespace and the set of its keys that the base view has indexed
+     as updated at or after nMinHeight, add the keys updated since then
+     according to the cache and remove those that the cache has deleted or
+     set to data from before nMinHeight.  */
+  void updateKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight,
+                             std::set<valtype>& keys) const;
+
+  /* Same as updateKeysSinceHeight, but for names of all namespaces.  */
+  void updateNamesSinceHeight(unsigned nMinHeight,
+                              std::set<NamespaceKeyType>& names) const;
 
   /* Apply all the changes in the passed-in record on top of this one.  */
   void apply(const CKevaCache& cache);
 
-  /* Write all cached changes to a database batch update object.  */
+  /* Write all cached changes to a database batch update object, including
+     the height index records of the changed names.  */
   void writeBatch(CDBBatch& batch) const;
 
 };
 
+/* ************************************************************************** */
+/* CKevaReadCache.  */
+
+/**
+ * Bounded read-through cache of confirmed keva entries.  This remembers
+ * the result of lookups in the backing database, including negative
+ * results, and evicts the least recently used entries once the configured
+ * memory budget is exceeded.  It must only ever hold data that matches
+ * the backing view, so all changes written on top of it have to be
+ * invalidated with remove() or removeChanges().
+ */
+class CKevaReadCache
+{
+
+private:
+
+  typedef std::pair<valtype, valtype> NamespaceKeyType;
+
+  struct Entry
+  {
+    /** Whether the key exists.  If not, data is unused.  */
+    bool found;
+    CKevaData data;
+    /** Position in the LRU list.  */
+    std::list<const NamespaceKeyType*>::iterator lru;
+  };
+
+  typedef std::unordered_map<NamespaceKeyType, Entry, SaltedKevaKeyHasher> EntryMap;
+
+  /** Cached entries.  */
+  EntryMap entries;
+
+  /** Keys of the cached entries, most recently used first.  */
+  std::list<const NamespaceKeyType*> lru;
+
+  /** Memory budget in bytes.  Zero disables the cache.  */
+  size_t maxBytes;
+
+  /** Dynamic memory usage of the keys and data held by the entries.  */
+  size_t innerUsage;
+
+  /* Memory usage of the heap data of a single entry.  */
+  static size_t entryUsage(const NamespaceKeyType& name, const Entry& entry);
+
+  /* Drop an entry.  */
+  void erase(EntryMap::iterator it);
+
+  /* Evict least recently used entries until we are within budget.  */
+  void trim();
+
+  /* Insert or overwrite an entry.  */
+  void insert(const valtype& nameSpace, const valtype& key, bool found, const CKevaData* data);
+
+public:
+
+  explicit CKevaReadCache(size_t maxSize = 0) : maxBytes(maxSize), innerUsage(0) {}
+
+  /**
+   * Change the memory budget, evicting entries if necessary.
+   * @param maxSize The new budget in bytes.  Zero disables the cache.
+   */
+  void setMaxSize(size_t maxSize);
+
+  /* Whether the cache has a nonzero memory budget.  */
+  inline bool isEnabled() const
+  {
+    return maxBytes > 0;
+  }
+
+  /* Whether a key is cached (positively or negatively).  */
+  bool has(const valtype& nameSpace, const valtype& key) const;
+
+  /**
+   * Look up a key in the cache.
+   * @param nameSpace The namespace.
+   * @param key The key.
+   * @param found Set to whether the key exists, if it is cached.
+   * @param data Set to the key's data, if it is cached and exists.
+   * @return True iff the key is cached (positively or negatively).
+   */
+  bool get(const valtype& nameSpace, const valtype& key, bool& found, CKevaData& data);
+
+  /* Remember the data of an existing key.  */
+  void set(const valtype& nameSpace, const valtype& key, const CKevaData& data);
+
+  /* Remember that a key does not exist.  */
+  void setMissing(const valtype& nameSpace, const valtype& key);
+
+  /* Forget a key.  */
+  void remove(const valtype& nameSpace, const valtype& key);
+
+  /* Forget all keys that are changed or deleted by the given changes.  */
+  void removeChanges(const CKevaCache& changes);
+
+  inline void clear()
+  {
+    entries.clear();
+    lru.clear();
+    innerUsage = 0;
+  }
+
+  inline size_t size() const
+  {
+    return entries.size();
+  }
+
+  /* Total dynamic memory usage of the cache.  */
+  size_t dynamicMemoryUsage() const;
+
+};
+
+/* ************************************************************************** */
+/* CKevaGroupCache.  */
+
+/**
+ * The namespace group of a namespace, in both directions: the namespaces it
+ * joined with its own "_g:" keys, and the namespaces that joined it.
+ */
+struct CKevaGroup
+{
+  /** The namespace's "_g:" keys, with the namespace and data of each.  */
+  std::map<valtype, std::pair<valtype, CKevaData>> joined;
+
+  /** The namespaces that joined this one, with their association data.  */
+  std::map<valtype, CKevaData> members;
+};
+
+/**
+ * Bounded cache of the namespace groups of recently queried namespaces,
+ * so that they can be looked up without scanning all keys of a namespace.
+ * Like CKevaReadCache it evicts the least recently used namespaces once
+ * the memory budget is exceeded.  Unlike the read cache it holds the state
+ * of the view it belongs to, so all changes made to that view have to be
+ * applied to it with setKey(), associate() or applyChanges().
+ */
+class CKevaGroupCache
+{
+
+private:
+
+  struct Entry
+  {
+    CKevaGroup group;
+    /** Position in the LRU list.  */
+    std::list<const valtype*>::iterator lru;
+  };
+
+  typedef std::map<valtype, Entry> EntryMap;
+
+  /** Cached groups, by namespace.  */
+  EntryMap entries;
+
+  /** Namespaces of the cached groups, most recently used first.  */
+  std::list<const valtype*> lru;
+
+  /** Memory budget in bytes.  Zero disables the cache.  */
+  size_t maxBytes;
+
+  /** Dynamic memory usage of the namespaces and groups held.  */
+  size_t innerUsage;
+
+  /* Memory usage of the heap data of a single entry.  */
+  static size_t entryUsage(const valtype& nameSpace, const CKevaGroup& group);
+
+  /* Drop an entry.  */
+  void erase(EntryMap::iterator it);
+
+  /* Evict least recently used entries until we are within budget.  */
+  void trim();
+
+  /* Change the group of a namespace, if it is cached.  */
+  template<typename F>
+  void update(const valtype& nameSpace, F&& change);
+
+public:
+
+  explicit CKevaGroupCache(size_t maxSize = 0) : maxBytes(maxSize), innerUsage(0) {}
+
+  /**
+   * Change the memory budget, evicting entries if necessary.
+   * @param maxSize The new budget in bytes.  Zero disables the cache.
+   */
+  void setMaxSize(size_t maxSize);
+
+  /* Whether the cache has a nonzero memory budget.  */
+  inline bool isEnabled() const
+  {
+    return maxBytes > 0;
+  }
+
+  /**
+   * Look up the group of a namespace.
+   * @param nameSpace The namespace.
+   * @param group Set to the namespace's group, if it is cached.
+   * @return True iff the group is cached.
+   */
+  bool get(const valtype& nameSpace, CKevaGroup& group);
+
+  /* Remember the complete group of a namespace.  */
+  void set(const valtype& nameSpace, const CKevaGroup& group);
+
+  /* Record that a key was set (data is non-null) or deleted.  Only "_g:"
+     keys of cached namespaces change anything.  */
+  void setKey(const valtype& nameSpace, const valtype& key, const CKevaData* data);
+
+  /* Record that nameSpaceOther joined nameSpace (data is non-null) or
+     left it.  */
+  void associate(const valtype& nameSpace, const valtype& nameSpaceOther, const CKevaData* data);
+
+  /* Apply all changes of a cache written on top of the view.  */
+  void applyChanges(const CKevaCache& changes);
+
+  inline void clear()
+  {
+    entries.clear();
+    lru.clear();
+    innerUsage = 0;
+  }
+
+  inline size_t size() const
+  {
+    return entries.size();
+  }
+
+  /* Total dynamic memory usage of the cache.  */
+  size_t dynamicMemoryUsage() const;
+
+};
+
 #endif // H_KEVACOIN_NAMES_COMMON
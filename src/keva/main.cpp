@@ -18,6 +18,7 @@
 #include <dbwrapper.h>
 #include <logging.h>
 #include <logging/timer.h>
+#include <primitives/block.h>
 #include <script/interpreter.h>
 #include <script/keva.h>
 #include <txmempool.h>
@@ -26,6 +27,8 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
+
 
 /* ************************************************************************** */
 /* CKevaTxUndo.  */
@@ -37,7 +40,7 @@ void CKevaTxUndo::fromOldState(const valtype& nameSpace, const valtype& key, con
   isNew = !view.GetName(nameSpace, key, oldData);
 }
 
-void CKevaTxUndo::apply(CCoinsViewCache& view) const
+void CKevaTxUndo::apply(CCoinsViewCache& view, unsigned nHeight) const
 {
   if (isNew) {
     CKevaData oldData;
@@ -45,7 +48,8 @@ void CKevaTxUndo::apply(CCoinsViewCache& view) const
       view.DeleteKey(nameSpace, key);
     }
   } else {
-    view.SetKeyValue(nameSpace, key, oldData, true);
+    /* The data that is undone was set by the block being disconnected.  */
+    view.SetKeyValue(nameSpace, key, oldData, true, nHeight);
   }
 }
 
@@ -57,79 +61,129 @@ void CKevaMemPool::addUnchecked(const uint256& hash, const CKevaScript& kevaOp)
   AssertLockHeld (pool.cs);
   if (kevaOp.isNamespaceRegistration()) {
     const valtype& nameSpace = kevaOp.getOpNamespace();
-    listUnconfirmedNamespaces.push_back(std::make_tuple(hash, nameSpace, kevaOp.getOpNamespaceDisplayName()));
+    const uint64_t seq = nextSequence++;
+    unconfirmedNamespaces.emplace(seq, std::make_tuple(hash, nameSpace, kevaOp.getOpNamespaceDisplayName()));
+    txidIndex[hash].push_back(seq);
+    return;
   }
 
-  if (kevaOp.getKevaOp() == OP_KEVA_PUT) {
-    const valtype& nameSpace = kevaOp.getOpNamespace();
-    listUnconfirmedKeyValues.push_back(std::make_tuple(hash, nameSpace, kevaOp.getOpKey(), kevaOp.getOpValue()));
+  if (!kevaOp.isAnyUpdate()) {
+    return;
   }
 
-  if (kevaOp.getKevaOp() == OP_KEVA_DELETE) {
-    const valtype& nameSpace = kevaOp.getOpNamespace();
-    const valtype& empty = ValtypeFromString("");
-    listUnconfirmedKeyValues.push_back(std::make_tuple(hash, nameSpace, kevaOp.getOpKey(), empty));
+  /* A deletion is recorded as an empty value.  */
+  const valtype& nameSpace = kevaOp.getOpNamespace();
+  const valtype& key = kevaOp.getOpKey();
+  const uint64_t seq = nextSequence++;
+  unconfirmedKeyValues.emplace(seq, std::make_tuple(hash, nameSpace, key, kevaOp.isDelete() ? valtype() : kevaOp.getOpValue()));
+  keyValueIndex[std::make_pair(nameSpace, key)].insert(seq);
+  namespaceIndex[nameSpace].insert(seq);
+  txidIndex[hash].push_back(seq);
+
+  valtype groupNamespace;
+  if (CKevaCache::getAssociateNamespaces(key, groupNamespace)) {
+    groupIndex[nameSpace].emplace(key, std::move(groupNamespace));
   }
 }
 
 bool CKevaMemPool::getUnconfirmedKeyValue(const valtype& nameSpace, const valtype& key, valtype& value) const {
-  bool found = false;
-  for (auto entry : listUnconfirmedKeyValues) {
-    auto ns = std::get<1>(entry);
-    auto k = std::get<2>(entry);
-    if (ns == nameSpace && key == k) {
-      value = std::get<3>(entry);
-      found = true;
-    }
+  const auto mi = keyValueIndex.find(std::make_pair(nameSpace, key));
+  if (mi == keyValueIndex.end()) {
+    return false;
   }
-  return found;
+  /* The latest pending operation wins.  */
+  assert(!mi->second.empty());
+  const auto ei = unconfirmedKeyValues.find(*mi->second.rbegin());
+  assert(ei != unconfirmedKeyValues.end());
+  value = std::get<3>(ei->second);
+  return true;
 }
 
-void CKevaMemPool::getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) {
-  bool matchNamespace = nameSpace.size() > 0;
-  for (auto entry : listUnconfirmedKeyValues) {
-    auto txid = std::get<0>(entry);
-    auto n = std::get<1>(entry);
-    auto k = std::get<2>(entry);
-    auto v = std::get<3>(entry);
-    if (!matchNamespace) {
-      keyValueList.push_back(std::make_tuple(n, k, v, txid));
-    } else if (n == nameSpace) {
-      keyValueList.push_back(std::make_tuple(n, k, v, txid));
+void CKevaMemPool::getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) const {
+  if (nameSpace.empty()) {
+    for (const auto& [seq, entry] : unconfirmedKeyValues) {
+      keyValueList.push_back(std::make_tuple(std::get<1>(entry), std::get<2>(entry), std::get<3>(entry), std::get<0>(entry)));
     }
+    return;
+  }
+
+  const auto mi = namespaceIndex.find(nameSpace);
+  if (mi == namespaceIndex.end()) {
+    return;
+  }
+  for (const uint64_t seq : mi->second) {
+    const auto& entry = unconfirmedKeyValues.at(seq);
+    keyValueList.push_back(std::make_tuple(std::get<1>(entry), std::get<2>(entry), std::get<3>(entry), std::get<0>(entry)));
+  }
+}
+
+void CKevaMemPool::getUnconfirmedGroupKeys(const valtype& nameSpace, std::vector<std::tuple<valtype, valtype, valtype>>& groupKeys) const {
+  const auto gi = groupIndex.find(nameSpace);
+  if (gi == groupIndex.end()) {
+    return;
+  }
+  for (const auto& [key, groupNamespace] : gi->second) {
+    valtype value;
+    const bool found = getUnconfirmedKeyValue(nameSpace, key, value);
+    assert(found);
+    groupKeys.emplace_back(key, groupNamespace, std::move(value));
   }
 }
 
 void CKevaMemPool::getUnconfirmedNamespaceList(std::vector<std::tuple<valtype, valtype, uint256>>& nameSpaces) const {
-  for (auto entry : listUnconfirmedNamespaces) {
-    auto txid = std::get<0>(entry);
-    auto ns = std::get<1>(entry);
-    auto displayName = std::get<2>(entry);
-    nameSpaces.push_back(std::make_tuple(ns, displayName, txid));
+  for (const auto& [seq, entry] : unconfirmedNamespaces) {
+    nameSpaces.push_back(std::make_tuple(std::get<1>(entry), std::get<2>(entry), std::get<0>(entry)));
   }
 }
 
+void CKevaMemPool::removeKeyValue(uint64_t seq)
+{
+  const auto ei = unconfirmedKeyValues.find(seq);
+  if (ei == unconfirmedKeyValues.end()) {
+    return;
+  }
+  const valtype& nameSpace = std::get<1>(ei->second);
+  const valtype& key = std::get<2>(ei->second);
+
+  const auto ki = keyValueIndex.find(std::make_pair(nameSpace, key));
+  assert(ki != keyValueIndex.end());
+  ki->second.erase(seq);
+  if (ki->second.empty()) {
+    keyValueIndex.erase(ki);
+
+    const auto gi = groupIndex.find(nameSpace);
+    if (gi != groupIndex.end()) {
+      gi->second.erase(key);
+      if (gi->second.empty()) {
+        groupIndex.erase(gi);
+      }
+    }
+  }
+
+  const auto ni = namespaceIndex.find(nameSpace);
+  assert(ni != namespaceIndex.end());
+  ni->second.erase(seq);
+  if (ni->second.empty()) {
+    namespaceIndex.erase(ni);
+  }
+
+  unconfirmedKeyValues.erase(ei);
+}
+
 void CKevaMemPool::remove(const uint256& hash)
 {
   AssertLockHeld(pool.cs);
-  bool removed = false;
-
-  for (auto iter = listUnconfirmedNamespaces.begin(); iter != listUnconfirmedNamespaces.end(); ++iter) {
-    if (std::get<0>(*iter) == hash) {
-      listUnconfirmedNamespaces.erase(iter);
-      removed = true;
-      break;
-    }
+  const auto ti = txidIndex.find(hash);
+  if (ti == txidIndex.end()) {
+    return;
   }
-  
-  if (!removed) {
-    for (auto iter = listUnconfirmedKeyValues.begin(); iter != listUnconfirmedKeyValues.end(); ++iter) {
-      if (std::get<0>(*iter) == hash) {
-        listUnconfirmedKeyValues.erase(iter);
-        break;
-        }
+
+  for (const uint64_t seq : ti->second) {
+    if (unconfirmedNamespaces.erase(seq) == 0) {
+      removeKeyValue(seq);
     }
   }
+  txidIndex.erase(ti);
 }
 
 void CKevaMemPool::removeConflicts(const CTransaction& tx)
@@ -156,10 +210,7 @@ bool CKevaMemPool::checkTx(const CTransaction& tx, const CBlockIndex* activeChai
     return true;
   }
 
-  for (const auto& txout : tx.vout) {
-    const CKevaScript nameOp(txout.scriptPubKey);
-    if (!nameOp.isKevaOp())
-      continue;
+  for (const auto& [n, nameOp] : tx.GetKevaOutputs()) {
     switch (nameOp.getKevaOp()) {
       case OP_KEVA_NAMESPACE:
       {
@@ -226,29 +277,40 @@ void CNameConflictTracker::AddConflictedEntry(CTransactionRef txRemoved)
 
 /* ************************************************************************** */
 
-CKevaNotifier::CKevaNotifier(ValidationSignals* signals) {
-  this->signals = signals;
-}
+CKevaNotifier::CKevaNotifier(ValidationSignals* s)
+  : signals(s && s->HasKevaListeners() ? s : nullptr)
+{}
 
-void CKevaNotifier::KevaNamespaceCreated(const CTransaction& tx, int nHeight, const std::string& nameSpace) {
-  if (signals) {
-    CTransactionRef ptx = MakeTransactionRef(tx);
-    signals->KevaNamespaceCreated(ptx, nHeight, nameSpace);
-  }
+void CKevaNotifier::KevaApplied(const CTransactionRef& tx, unsigned n, int nHeight)
+{
+  if (signals)
+    operations.push_back(Operation{tx, n, nHeight});
 }
 
-void CKevaNotifier::KevaUpdated(const CTransaction& tx, int nHeight, const std::string& nameSpace, const std::string& key, const std::string& value) {
-  if (signals) {
-    CTransactionRef ptx = MakeTransactionRef(tx);
-    signals->KevaUpdated(ptx, nHeight, nameSpace, key, value);
-  }
-}
+void CKevaNotifier::Flush()
+{
+  if (!signals || operations.empty())
+    return;
 
-void CKevaNotifier::KevaDeleted(const CTransaction& tx, int nHeight, const std::string& nameSpace, const std::string& key) {
-  if (signals) {
-    CTransactionRef ptx = MakeTransactionRef(tx);
-    signals->KevaDeleted(ptx, nHeight, nameSpace, key);
-  }
+  signals->CallFunctionInValidationInterfaceQueue(
+    [signals = signals, operations = std::move(operations)] {
+      for (const Operation& operation : operations) {
+        const CTransaction::KevaOutputs& kevaOutputs = operation.tx->GetKevaOutputs();
+        const auto it = std::find_if(kevaOutputs.begin(), kevaOutputs.end(),
+                                     [&](const auto& out) { return out.first == operation.n; });
+        assert(it != kevaOutputs.end());
+        const CKevaScript& op = it->second;
+        const std::string nameSpace = EncodeBase58Check(op.getOpNamespace());
+        if (op.isNamespaceRegistration()) {
+          signals->KevaNamespaceCreated(operation.tx, operation.nHeight, nameSpace);
+        } else if (op.isDelete()) {
+          signals->KevaDeleted(operation.tx, operation.nHeight, nameSpace, ValtypeToString(op.getOpKey()));
+        } else {
+          signals->KevaUpdated(operation.tx, operation.nHeight, nameSpace, ValtypeToString(op.getOpKey()), ValtypeToString(op.getOpValue()));
+        }
+      }
+    });
+  operations.clear();
 }
 
 /* ************************************************************************** */
@@ -288,19 +350,12 @@ bool CheckKevaTransaction(const CTransaction& tx, unsigned nHeight, const CCoins
     }
   }
 
-  int nameOut = -1;
-  CKevaScript nameOpOut;
-  for (unsigned i = 0; i < tx.vout.size(); ++i) {
-    const CKevaScript op(tx.vout[i].scriptPubKey);
-    if (op.isKevaOp()) {
-      if (nameOut != -1) {
-        LogError("%s: multiple keva outputs from transaction for %s", __func__, txid);
-        return state.Invalid(TxValidationResult::TX_NOT_STANDARD, strprintf("%s: multiple keva outputs from transaction %s", __func__, txid));
-      }
-      nameOut = i;
-      nameOpOut = op;
-    }
+  const CTransaction::KevaOutputs& kevaOutputs = tx.GetKevaOutputs();
+  if (kevaOutputs.size() > 1) {
+    LogError("%s: multiple keva outputs from transaction for %s", __func__, txid);
+    return state.Invalid(TxValidationResult::TX_NOT_STANDARD, strprintf("%s: multiple keva outputs from transaction %s", __func__, txid));
   }
+  const int nameOut = kevaOutputs.empty() ? -1 : kevaOutputs.front().first;
 
   /*
     Check that no keva inputs/outputs are present for a non-Kevacoin tx.
@@ -326,6 +381,7 @@ bool CheckKevaTransaction(const CTransaction& tx, unsigned nHeight, const CCoins
     LogError("%s: Kevacoin tx %s has no keva outputs", __func__, txid);
     return state.Invalid(TxValidationResult::TX_NOT_STANDARD, strprintf("%s: Kevacoin tx %s has no keva outputs %s", __func__, txid));
   }
+  const CKevaScript& nameOpOut = kevaOutputs.front().second;
 
   /* Reject "greedy names".  */
   if (tx.vout[nameOut].nValue < KEVA_LOCKED_AMOUNT) {
@@ -412,9 +468,93 @@ bool CheckKevaTransaction(const CTransaction& tx, unsigned nHeight, const CCoins
   return true;
 }
 
-void ApplyKevaTransaction(const CTransaction& tx, int nHeight,
+std::optional<COutPoint> FindKevaOutput(const CTransaction& tx)
+{
+  if (!tx.IsKevacoin())
+    return std::nullopt;
+
+  const CTransaction::KevaOutputs& kevaOutputs = tx.GetKevaOutputs();
+  if (kevaOutputs.empty())
+    return std::nullopt;
+  return COutPoint(tx.GetHash(), kevaOutputs.front().first);
+}
+
+std::vector<CKevaCache::NamespaceKeyType> GetKevaBlockNames(const CBlock& block)
+{
+  std::set<CKevaCache::NamespaceKeyType> names;
+  for (const auto& tx : block.vtx) {
+    if (!tx->IsKevacoin())
+      continue;
+    for (const auto& [n, op] : tx->GetKevaOutputs()) {
+      if (op.isNamespaceRegistration()) {
+        names.emplace(op.getOpNamespace(), ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY));
+      } else if (op.isAnyUpdate()) {
+        names.emplace(op.getOpNamespace(), op.getOpKey());
+      }
+    }
+  }
+  return {names.begin(), names.end()};
+}
+
+std::vector<CKevaCache::NamespaceKeyType> GetKevaUndoNames(const CBlockUndo& undo)
+{
+  /* Restoring the old data of a name overwrites it without a lookup, only
+     the names created by the block are read to be deleted.  */
+  std::set<CKevaCache::NamespaceKeyType> names;
+  for (const auto& opUndo : undo.vkevaundo) {
+    if (opUndo.isNewName())
+      names.emplace(opUndo.getNamespace(), opUndo.getKey());
+  }
+  return {names.begin(), names.end()};
+}
+
+std::vector<CKevaEntryChange> GetKevaEntryChanges(const CBlock& block, const CBlockUndo& undo, int nHeight)
+{
+  std::map<CKevaCache::NamespaceKeyType, CKevaEntryChange> changes;
+
+  /* The first undo entry of a name holds its state before the block.  */
+  for (const auto& opUndo : undo.vkevaundo) {
+    CKevaEntryChange change{opUndo.getNamespace(), opUndo.getKey(), std::nullopt, std::nullopt};
+    if (!opUndo.isNewName())
+      change.oldData = opUndo.getOldData();
+    changes.try_emplace({opUndo.getNamespace(), opUndo.getKey()}, std::move(change));
+  }
+
+  /* The last operation on a name determines its state after the block.  */
+  for (const auto& tx : block.vtx) {
+    if (!tx->IsKevacoin())
+      continue;
+    for (const auto& [i, op] : tx->GetKevaOutputs()) {
+      const valtype key = op.isNamespaceRegistration()
+          ? ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY) : op.getOpKey();
+      auto it = changes.find({op.getOpNamespace(), key});
+      if (it == changes.end()) {
+        /* Every operation records undo data.  */
+        continue;
+      }
+      if (op.isDelete()) {
+        it->second.newData.reset();
+      } else {
+        CKevaData data;
+        data.fromScript(nHeight, COutPoint(tx->GetHash(), i), op);
+        it->second.newData = std::move(data);
+      }
+    }
+  }
+
+  std::vector<CKevaEntryChange> result;
+  result.reserve(changes.size());
+  for (auto& [name, change] : changes) {
+    if (change.oldData != change.newData)
+      result.push_back(std::move(change));
+  }
+  return result;
+}
+
+void ApplyKevaTransaction(const CTransactionRef& ptx, int nHeight,
                         CCoinsViewCache& view, CBlockUndo& undo, CKevaNotifier& notifier)
 {
+  const CTransaction& tx = *ptx;
   // unsigned int nHeight = pindex.nHeight;
   assert (nHeight != MEMPOOL_HEIGHT);
   if (!tx.IsKevacoin())
@@ -423,11 +563,7 @@ void ApplyKevaTransaction(const CTransaction& tx, int nHeight,
   /* Changes are encoded in the outputs.  We don't have to do any checks,
      so simply apply all these.  */
 
-  for (unsigned i = 0; i < tx.vout.size(); ++i) {
-    const CKevaScript op(tx.vout[i].scriptPubKey);
-    if (!op.isKevaOp()) {
-      continue;
-    }
+  for (const auto& [i, op] : tx.GetKevaOutputs()) {
     if (op.isNamespaceRegistration()) {
       const valtype& nameSpace = op.getOpNamespace();
       const valtype& displayName = op.getOpNamespaceDisplayName();
@@ -442,8 +578,8 @@ void ApplyKevaTransaction(const CTransaction& tx, int nHeight,
 
       CKevaData data;
       data.fromScript(nHeight, COutPoint(tx.GetHash(), i), op);
-      view.SetKeyValue(nameSpace, key, data, false);
-      notifier.KevaNamespaceCreated(tx, nHeight, EncodeBase58Check(nameSpace));
+      view.SetKeyValue(nameSpace, key, data, false, opUndo.getOldHeight());
+      notifier.KevaApplied(ptx, i, nHeight);
     } else if (op.isAnyUpdate()) {
       const valtype& nameSpace = op.getOpNamespace();
       const valtype& key = op.getOpKey();
@@ -459,49 +595,77 @@ void ApplyKevaTransaction(const CTransaction& tx, int nHeight,
         CKevaData oldData;
         if (view.GetName(nameSpace, key, oldData)) {
           view.DeleteKey(nameSpace, key);
-          notifier.KevaDeleted(tx, nHeight, EncodeBase58Check(nameSpace), ValtypeToString(key));
+          notifier.KevaApplied(ptx, i, nHeight);
         }
       } else {
         data.fromScript(nHeight, COutPoint(tx.GetHash(), i), op);
-        view.SetKeyValue(nameSpace, key, data, false);
-        notifier.KevaUpdated(tx, nHeight, EncodeBase58Check(nameSpace), ValtypeToString(key), ValtypeToString(data.getValue()));
+        view.SetKeyValue(nameSpace, key, data, false, opUndo.getOldHeight());
+        notifier.KevaApplied(ptx, i, nHeight);
       }
     }
   }
 }
 
-void CheckNameDB(bool disconnect)
+void CheckNameDB(Chainstate& chainstate, bool disconnect)
 {
-  // const int option = gArgs.GetArg("-checkkevadb", Params().DefaultCheckKevaDB());
-  const std::string option = gArgs.GetArg("-checkkevadb", "");
-  CChain chain;
+  AssertLockHeld(cs_main);
+  const int option = gArgs.GetIntArg("-checkkevadb", Params().DefaultCheckKevaDB());
 
-  if (option == "")
-    return; 
+  if (option == -1)
+    return;
 
-  assert (option != "");
-  if (option != "")
+  assert (option >= 0);
+  if (option != 0)
     {
-      if (disconnect || chain.Height() % (option != ""))
+      if (disconnect || chainstate.m_chain.Height() % option != 0)
         return;
     }
 
-  // m_view->Flush();
-  // const bool ok = m_view->ValidateKevaDB();
-  const bool ok = true;
+  /* The check reads the database, so all changes must be written first.  */
+  chainstate.ForceFlushStateToDisk();
+  const bool ok = chainstate.CoinsTip().ValidateKevaDB();
 
-  /* The DB is inconsistent (mismatch between UTXO set and names DB) between
-     (roughly) blocks 139,000 and 180,000.  This is caused by libcoin's
-     "name stealing" bug.  For instance, d/postmortem is removed from
-     the UTXO set shortly after registration (when it is used to steal
-     names), but it remains in the name DB until it expires.  */
   if (!ok)
     {
-      const unsigned nHeight = chain.Height();
-      LogPrintf("ERROR: %s : name database is inconsistent\n", __func__);
-      if (nHeight >= 139000 && nHeight <= 180000)
-        LogPrintf("This is expected due to 'name stealing'.\n");
-      else
-        assert (false);
+      LogPrintf("ERROR: %s : keva database is inconsistent at height %d\n",
+                __func__, chainstate.m_chain.Height());
+      assert (false);
     }
 }
+
+std::vector<CKevaLookup> LookupKevaEntries(ChainstateManager& chainman, const CTxMemPool* mempool,
+                                           const std::vector<CKevaCache::NamespaceKeyType>& names,
+                                           int& height, uint256& tipHash)
+{
+  std::vector<CKevaLookup> result(names.size());
+
+  /* Pending values take precedence, only the others are read from disk.  */
+  std::vector<size_t> missingPos;
+  std::vector<CKevaCache::NamespaceKeyType> missing;
+  std::vector<std::optional<valtype>> pending(names.size());
+  if (mempool)
+    pending = mempool->getUnconfirmedKeyValues(names);
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (pending[i]) {
+      result[i].unconfirmed = std::move(pending[i]);
+    } else {
+      missingPos.push_back(i);
+      missing.push_back(names[i]);
+    }
+  }
+
+  /* A bounded number of point lookups is cheap enough to do on the tip
+     directly, a snapshot would copy all of its unflushed changes.  */
+  std::vector<std::optional<CKevaData>> found;
+  {
+    LOCK(cs_main);
+    height = chainman.ActiveHeight();
+    tipHash = chainman.ActiveTip()->GetBlockHash();
+    if (!missing.empty())
+      found = chainman.ActiveChainstate().CoinsTip().GetNames(missing);
+  }
+
+  for (size_t i = 0; i < missing.size(); ++i)
+    result[missingPos[i]].confirmed = std::move(found[i]);
+  return result;
+}
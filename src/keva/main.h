@@ -18,14 +18,20 @@
 #include <script/keva.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/hasher.h>
 
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 
+class CBlock;
 class CBlockUndo;
+class Chainstate;
+class ChainstateManager;
 class CCoinsView;
 class CCoinsViewCache;
 class CTxMemPool;
@@ -97,8 +103,37 @@ public:
   /**
    * Apply the undo to the chain state given.
    * @param view The chain state to update ("undo").
+   * @param nHeight The height of the block that is disconnected.
    */
-  void apply(CCoinsViewCache& view) const;
+  void apply(CCoinsViewCache& view, unsigned nHeight) const;
+
+  inline const valtype& getNamespace() const
+  {
+    return nameSpace;
+  }
+
+  inline const valtype& getKey() const
+  {
+    return key;
+  }
+
+  inline bool isNewName() const
+  {
+    return isNew;
+  }
+
+  inline const CKevaData& getOldData() const
+  {
+    return oldData;
+  }
+
+  /* Height of the overwritten data, or nullopt for a new name.  */
+  inline std::optional<unsigned> getOldHeight() const
+  {
+    if (isNew)
+      return std::nullopt;
+    return oldData.getHeight();
+  }
 
 };
 
@@ -116,41 +151,81 @@ class CKevaMemPool
 
 private:
 
+  /** Type of a (namespace, key) pair used as index key.  */
+  typedef std::pair<valtype, valtype> NamespaceKeyType;
+
   /** The parent mempool object.  Used to, e. g., remove conflicting tx.  */
   CTxMemPool& pool;
 
   /**
-   * Pending/unconfirmed namespaces.
+   * Sequence number assigned to the next added entry.  Entries are kept
+   * sorted by it, so that iteration follows the order of insertion.
+   */
+  uint64_t nextSequence;
+
+  /**
+   * Pending/unconfirmed namespaces, by sequence number.
    * Tuple: txid, namespace, display name
    */
-  std::vector<std::tuple<uint256, valtype, valtype>> listUnconfirmedNamespaces;
+  std::map<uint64_t, std::tuple<uint256, valtype, valtype>> unconfirmedNamespaces;
 
   /**
-   * Pending/unconfirmed key-values.
+   * Pending/unconfirmed key-values, by sequence number.  A deletion is
+   * recorded with an empty value.
    * Tuple: txid, namespace, key, value
    */
-  std::vector<std::tuple<uint256, valtype, valtype, valtype>> listUnconfirmedKeyValues;
+  std::map<uint64_t, std::tuple<uint256, valtype, valtype, valtype>> unconfirmedKeyValues;
+
+  /**
+   * Sequence numbers of the pending operations for each (namespace, key).
+   * The last one is the latest pending operation on that key.
+   */
+  std::unordered_map<NamespaceKeyType, std::set<uint64_t>, SaltedKevaKeyHasher> keyValueIndex;
+
+  /** Sequence numbers of the pending key-values of each namespace.  */
+  std::map<valtype, std::set<uint64_t>> namespaceIndex;
+
+  /** Sequence numbers of the entries added by each transaction.  */
+  std::unordered_map<uint256, std::vector<uint64_t>, SaltedTxidHasher> txidIndex;
+
+  /**
+   * The "_g:" keys with pending operations of each namespace, and the
+   * namespace each of them refers to.  This way pending namespace group
+   * changes are found without decoding all pending keys of a namespace.
+   */
+  std::map<valtype, std::map<valtype, valtype>> groupIndex;
 
   /**
    * Validate that the namespace is the hash of the first TxIn.
    */
   bool validateNamespace(const CTransaction& tx, const valtype& nameSpace, const CBlockIndex* activeChainTip) const;
 
+  /**
+   * Remove the key-value entry with the given sequence number from
+   * all indices.
+   * @param seq The entry's sequence number.
+   */
+  void removeKeyValue(uint64_t seq);
+
 public:
 
   // /**
   //  * Construct with reference to parent mempool.
   //  * @param p The parent pool.
   //  */
-  explicit inline CKevaMemPool(CTxMemPool& p) : pool(p) {}
+  explicit inline CKevaMemPool(CTxMemPool& p) : pool(p), nextSequence(0) {}
 
   /**
    * Clear all data.
    */
   inline void clear()
   {
-    listUnconfirmedNamespaces.clear();
-    listUnconfirmedKeyValues.clear();
+    unconfirmedNamespaces.clear();
+    unconfirmedKeyValues.clear();
+    keyValueIndex.clear();
+    namespaceIndex.clear();
+    txidIndex.clear();
+    groupIndex.clear();
   }
 
   /**
@@ -190,7 +265,16 @@ public:
   bool getUnconfirmedKeyValue(const valtype& nameSpace, const valtype& key, valtype& value) const;
 
   /** Keva get list of unconfirmed key value list. */
-  void getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace);
+  void getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) const;
+
+  /**
+   * Get the pending changes to the namespace group of a namespace.
+   * @param nameSpace The namespace.
+   * @param groupKeys Set to its "_g:" keys with pending operations, as
+   *                  tuples of key, referred namespace and latest pending
+   *                  value (empty for a deletion).
+   */
+  void getUnconfirmedGroupKeys(const valtype& nameSpace, std::vector<std::tuple<valtype, valtype, valtype>>& groupKeys) const;
 
 };
 
@@ -225,18 +309,34 @@ public:
 };
 
 /**
- * Notify Keva transactions. This is for ZMQ notification.
+ * Collect the keva operations applied while connecting a block, for the
+ * keva notifications of the validation interface.  Operations are recorded
+ * as (transaction, output) pairs and only decoded on the background
+ * notification thread, and nothing is recorded at all unless a listener
+ * wants keva notifications.
  */
 class CKevaNotifier
 {
 private:
-    ValidationSignals* signals;
+  struct Operation
+  {
+    CTransactionRef tx;
+    unsigned n;
+    int nHeight;
+  };
+
+  /** The signals to notify, or null if nobody listens.  */
+  ValidationSignals* signals;
+  std::vector<Operation> operations;
 
 public:
-    CKevaNotifier(ValidationSignals*);
-    void KevaNamespaceCreated(const CTransaction& tx, int nHeight, const std::string& nameSpace);
-    void KevaUpdated(const CTransaction& tx, int nHeight, const std::string& nameSpace, const std::string& key, const std::string& value);
-    void KevaDeleted(const CTransaction& tx, int nHeight, const std::string& nameSpace, const std::string& key);
+  explicit CKevaNotifier(ValidationSignals* s);
+
+  /** Record that the keva operation in output n of tx was applied.  */
+  void KevaApplied(const CTransactionRef& tx, unsigned n, int nHeight);
+
+  /** Queue the notifications of the recorded operations.  */
+  void Flush();
 };
 
 /* ************************************************************************** */
@@ -255,14 +355,63 @@ public:
 bool CheckKevaTransaction(const CTransaction& tx, unsigned nHeight, const CCoinsView& view,
                           TxValidationState& state, unsigned flags);
 
+/**
+ * Find the output of a Kevacoin transaction that carries its keva operation.
+ * The next update of the same namespace spends this output.
+ * @param tx The transaction.
+ * @return The keva output, or nullopt if tx has no keva operation.
+ */
+std::optional<COutPoint> FindKevaOutput(const CTransaction& tx);
+
+/**
+ * Collect the names whose state is read when applying the keva operations
+ * of a block, so that they can be prefetched.
+ * @param block The block.
+ * @return The (namespace, key) pairs, without duplicates.
+ */
+std::vector<CKevaCache::NamespaceKeyType> GetKevaBlockNames(const CBlock& block);
+
+/**
+ * Collect the names that are read when undoing the keva operations of a
+ * block, i.e. those created by the block.
+ * @param undo The undo data of the block.
+ * @return The (namespace, key) pairs, without duplicates.
+ */
+std::vector<CKevaCache::NamespaceKeyType> GetKevaUndoNames(const CBlockUndo& undo);
+
+/**
+ * The change of a single keva entry by a block.
+ */
+struct CKevaEntryChange
+{
+  valtype nameSpace;
+  valtype key;
+  /** The entry before the block, or nullopt if it did not exist.  */
+  std::optional<CKevaData> oldData;
+  /** The entry after the block, or nullopt if it does not exist.  */
+  std::optional<CKevaData> newData;
+};
+
+/**
+ * Compute the changes a connected block made to the keva entries, from the
+ * block itself and its undo data.  The new state of each entry is derived
+ * in the same way as by ApplyKevaTransaction.
+ * @param block The block.
+ * @param undo The undo data of the block.
+ * @param nHeight Height of the block.
+ * @return The changed entries, sorted by name.
+ */
+std::vector<CKevaEntryChange> GetKevaEntryChanges(const CBlock& block, const CBlockUndo& undo, int nHeight);
+
 /**
  * Apply the changes of a keva transaction to the database.
- * @param tx The transaction to apply.
- * @param pindex Pointer to the block.
+ * @param ptx The transaction to apply.
+ * @param nHeight Height of the block.
  * @param view The chain state to update.
  * @param undo Record undo information here.
+ * @param notifier Record the applied operations here.
  */
-void ApplyKevaTransaction(const CTransaction& tx, int nHeight,
+void ApplyKevaTransaction(const CTransactionRef& ptx, int nHeight,
                           CCoinsViewCache& view, CBlockUndo& undo, CKevaNotifier& notifier);
 
 /**
@@ -293,9 +442,39 @@ bool UnexpireNames(unsigned nHeight, CBlockUndo& undo,
  * Check the name database consistency.  This calls CCoinsView::ValidateKevaDB,
  * but only if applicable depending on the -checkkevadb setting.  If it fails,
  * this throws an assertion failure.
+ * @param chainstate The chainstate whose keva database to check.
  * @param disconnect Whether we are disconnecting blocks.
  */
-void CheckNameDB(bool disconnect);
+void CheckNameDB(Chainstate& chainstate, bool disconnect);
+
+/** Maximum number of keys looked up by a single LookupKevaEntries call.  */
+static const unsigned MAX_KEVA_LOOKUP_NAMES = 1000;
+
+/**
+ * The current value of a key, as returned by LookupKevaEntries.
+ */
+struct CKevaLookup
+{
+  /** The latest pending value in the mempool (empty for a deletion).  */
+  std::optional<valtype> unconfirmed;
+  /** The confirmed entry, only looked up if there is no pending value.  */
+  std::optional<CKevaData> confirmed;
+};
+
+/**
+ * Look up the current values of many keys at once.  The mempool is locked
+ * once for all keys, and the confirmed entries of the remaining keys are
+ * read from the chain tip in a single cs_main section, in database order.
+ * @param chainman The chainstate manager.
+ * @param mempool The mempool to check for pending values, may be null.
+ * @param names The (namespace, key) pairs to look up.
+ * @param height Set to the height of the chain tip the entries belong to.
+ * @param tipHash Set to the hash of that chain tip.
+ * @return The values, in the order of names.
+ */
+std::vector<CKevaLookup> LookupKevaEntries(ChainstateManager& chainman, const CTxMemPool* mempool,
+                                           const std::vector<CKevaCache::NamespaceKeyType>& names,
+                                           int& height, uint256& tipHash);
 
 template<typename DEP>
 bool DeploymentActiveAt(const CBlockIndex& index, const Consensus::Params& params, DEP dep)
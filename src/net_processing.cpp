@@ -48,6 +48,7 @@
 #include <algorithm>
 #include <atomic>
 #include <future>
+#include <map>
 #include <memory>
 #include <optional>
 #include <typeinfo>
@@ -2561,17 +2562,41 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
 
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
 {
-    // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
-        Misbehaving(peer, 100, "header with invalid proof of work");
-        return false;
-    }
-
     // Are these headers connected to each other?
     if (!CheckHeadersAreContinuous(headers)) {
         Misbehaving(peer, 20, "non-continuous headers sequence");
         return false;
     }
+
+    // The RandomX seeds of the headers are looked up in the block index, or
+    // in the low-work headers sync that these headers continue.
+    std::map<uint64_t, uint256> chain_seeds;
+    bool continues_sync{false};
+    {
+        LOCK(peer.m_headers_sync_mutex);
+        if (peer.m_headers_sync) {
+            if (auto seeds{peer.m_headers_sync->GetSeedHashes(headers[0].hashPrevBlock)}) {
+                chain_seeds = std::move(*seeds);
+                continues_sync = true;
+            }
+        }
+    }
+    const auto seed_hashes{GetHeadersSeedHashes(headers, m_chainman, chain_seeds)};
+    if (!seed_hashes && !continues_sync) {
+        const bool connects{WITH_LOCK(::cs_main, return m_chainman.m_blockman.LookupBlockIndex(headers[0].hashPrevBlock) != nullptr)};
+        if (!connects) {
+            // Headers that don't connect are not accepted below, so their
+            // proof-of-work is checked once the peer sends the missing ones.
+            return true;
+        }
+    }
+
+    // Do these headers have proof-of-work matching what's claimed? Without
+    // the seed blocks it cannot be checked, so such headers are invalid.
+    if (!seed_hashes || !HasValidProofOfWork(headers, *seed_hashes, m_chainman)) {
+        Misbehaving(peer, 100, "header with invalid proof of work");
+        return false;
+    }
     return true;
 }
 
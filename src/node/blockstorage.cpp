@@ -137,6 +137,8 @@ bool BlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, s
                 // While it is technically feasible to verify the PoW, doing so takes several minutes as it
                 // requires recomputing every PoW hash during every Kevacoin startup.
                 // We opt instead to simply trust the data that is on your local disk.
+                // Whether the PoW was verified is kept in nStatus (BLOCK_POW_CHECKED), which lets
+                // -reindex-chainstate skip recomputing it, see -trustcheckedpow.
                 
                 // if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams)) {
                 //     LogError("%s: CheckProofOfWork failed: %s\n", __func__, pindexNew->ToString());
@@ -39,6 +39,8 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
 
     if (auto value{args.GetIntArg("-maxtipage")}) opts.max_tip_age = std::chrono::seconds{*value};
 
+    if (auto value{args.GetBoolArg("-trustcheckedpow")}) opts.trust_checked_pow = *value;
+
     ReadDatabaseArgs(args, opts.block_tree_db);
     ReadDatabaseArgs(args, opts.coins_db);
     ReadCoinsViewArgs(args, opts.coins_view);
@@ -51,7 +53,7 @@ util::Result<void> ApplyArgsManOptions(const ArgsManager& args, ChainstateManage
     }
     // Subtract 1 because the main thread counts towards the par threads.
     opts.worker_threads_num = std::clamp(script_threads - 1, 0, MAX_SCRIPTCHECK_THREADS);
-    LogPrintf("Script verification uses %d additional threads\n", opts.worker_threads_num);
+    LogPrintf("Script and header PoW verification use %d additional threads each\n", opts.worker_threads_num);
 
     return {};
 }
@@ -7,10 +7,18 @@
 #include <common/args.h>
 #include <txdb.h>
 
+#include <algorithm>
+
 namespace node {
 void ReadCoinsViewArgs(const ArgsManager& args, CoinsViewOptions& options)
 {
     if (auto value = args.GetIntArg("-dbbatchsize")) options.batch_write_bytes = *value;
     if (auto value = args.GetIntArg("-dbcrashratio")) options.simulate_crash_ratio = *value;
+    if (auto value = args.GetIntArg("-kevacache")) options.keva_cache_bytes = std::max<int64_t>(*value, 0) << 20;
+    if (auto value = args.GetIntArg("-kevagroupcache")) options.keva_group_cache_bytes = std::max<int64_t>(*value, 0) << 20;
+    options.keva_db = args.GetBoolArg("-kevadb", DEFAULT_KEVA_DB);
+    if (auto value = args.GetIntArg("-kevadbcache")) options.keva_db_cache_bytes = std::max<int64_t>(*value, nMinDbCache) << 20;
+    if (auto value = args.GetIntArg("-kevadbbloombits")) options.keva_db_options.bloom_filter_bits = std::max<int64_t>(*value, 0);
+    if (auto value = args.GetIntArg("-kevadbwritebuffer")) options.keva_db_options.write_buffer_bytes = std::max<int64_t>(*value, 0) << 20;
 }
 } // namespace node
@@ -34,6 +34,8 @@ void ApplyArgsManOptions(const ArgsManager& argsman, MemPoolLimits& mempool_limi
     mempool_limits.descendant_count = argsman.GetIntArg("-limitdescendantcount", mempool_limits.descendant_count);
 
     if (auto vkb = argsman.GetIntArg("-limitdescendantsize")) mempool_limits.descendant_size_vbytes = *vkb * 1'000;
+
+    mempool_limits.keva_chain_count = argsman.GetIntArg("-limitkevachaincount", mempool_limits.keva_chain_count);
 }
 }
 
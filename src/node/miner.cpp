@@ -15,11 +15,14 @@
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
+#include <hash.h>
+#include <keva/main.h>
 #include <logging.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <util/check.h>
 #include <util/moneystr.h>
 #include <util/time.h>
 #include <validation.h>
@@ -100,6 +103,7 @@ void BlockAssembler::resetBlock()
 
     // These counters do not include coinbase tx
     nBlockTx = 0;
+    nBlockKevaOps = 0;
     nFees = 0;
 }
 
@@ -147,6 +151,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     m_last_block_num_txs = nBlockTx;
     m_last_block_weight = nBlockWeight;
+    m_last_block_num_keva_ops = nBlockKevaOps;
 
     // Create coinbase transaction.
     CMutableTransaction coinbaseTx;
@@ -160,7 +165,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblocktemplate->vchCoinbaseCommitment = m_chainstate.m_chainman.GenerateCoinbaseCommitment(*pblock, pindexPrev);
     pblocktemplate->vTxFees[0] = -nFees;
 
-    LogPrintf("CreateNewBlock(): block weight: %u txs: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx, nFees, nBlockSigOpsCost);
+    LogPrintf("CreateNewBlock(): block weight: %u txs: %u keva ops: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx, nBlockKevaOps, nFees, nBlockSigOpsCost);
 
     // Fill in header
     pblock->hashPrevBlock  = pindexPrev->GetBlockHash();
@@ -227,6 +232,7 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     pblocktemplate->vTxSigOpsCost.push_back(iter->GetSigOpCost());
     nBlockWeight += iter->GetTxWeight();
     ++nBlockTx;
+    if (iter->GetTx().IsKevacoin()) ++nBlockKevaOps;
     nBlockSigOpsCost += iter->GetSigOpCost();
     nFees += iter->GetFee();
     inBlock.insert(iter->GetSharedTx()->GetHash());
@@ -280,6 +286,64 @@ void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::ve
     std::sort(sortedEntries.begin(), sortedEntries.end(), CompareTxIterByAncestorCount());
 }
 
+void BlockAssembler::AddKevaChains(const CTxMemPool& mempool, CTxMemPool::setEntries& package, const CFeeRate& packageFeeRate)
+{
+    AssertLockHeld(mempool.cs);
+
+    // Updates of a namespace spend the keva output of the previous update, so
+    // a busy namespace forms a long chain in the mempool.  Instead of letting
+    // each update compete on its own as a new package, take the chain as a
+    // unit: follow the spenders of the keva outputs for as long as the
+    // updates so far pay at least the feerate of the package they extend.
+    std::vector<CTxMemPool::txiter> heads;
+    for (CTxMemPool::txiter it : package) {
+        if (it->GetTx().IsKevacoin()) heads.push_back(it);
+    }
+
+    for (CTxMemPool::txiter head : heads) {
+        std::vector<CTxMemPool::txiter> chain;
+        std::set<Txid> inChain;
+        uint64_t chainSize = 0;
+        CAmount chainFees = 0;
+        int64_t chainSigOpsCost = 0;
+        size_t nAccepted = 0;
+
+        std::optional<COutPoint> kevaOutput = FindKevaOutput(head->GetTx());
+        while (kevaOutput) {
+            const CTransaction* spender = mempool.GetConflictTx(*kevaOutput);
+            if (!spender || inBlock.count(spender->GetHash())) break;
+            CTxMemPool::txiter it = *Assert(mempool.GetIter(spender->GetHash()));
+            if (package.count(it)) break;
+
+            // All other in-mempool parents must already be in the block.
+            bool fParentsIncluded = true;
+            for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                const Txid& parentHash = parent.GetTx().GetHash();
+                if (!inBlock.count(parentHash) && !inChain.count(parentHash)) {
+                    fParentsIncluded = false;
+                    break;
+                }
+            }
+            if (!fParentsIncluded || !IsFinalTx(it->GetTx(), nHeight, m_lock_time_cutoff)) break;
+
+            chainSize += it->GetTxSize();
+            chainFees += it->GetModifiedFee();
+            chainSigOpsCost += it->GetSigOpCost();
+            if (!TestPackage(chainSize, chainSigOpsCost)) break;
+
+            chain.push_back(it);
+            inChain.insert(spender->GetHash());
+            if (chainFees >= packageFeeRate.GetFee(chainSize)) nAccepted = chain.size();
+            kevaOutput = FindKevaOutput(it->GetTx());
+        }
+
+        for (size_t i = 0; i < nAccepted; ++i) {
+            AddToBlock(chain[i]);
+            package.insert(chain[i]);
+        }
+    }
+}
+
 // This transaction selection algorithm orders the mempool based
 // on feerate of a transaction including all unconfirmed ancestors.
 // Since we don't remove transactions from the mempool as we select them
@@ -422,10 +486,90 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
             mapModifiedTx.erase(sortedEntries[i]);
         }
 
+        AddKevaChains(mempool, ancestors, CFeeRate(packageFees, packageSize));
+        for (CTxMemPool::txiter it : ancestors) {
+            mapModifiedTx.erase(it);
+        }
+
         ++nPackagesSelected;
 
         // Update transactions that depend on each of these
         nDescendantsUpdated += UpdatePackagesForAdded(mempool, ancestors, mapModifiedTx);
     }
 }
+/** The merkle branch of the coinbase, which does not depend on the coinbase itself. */
+static std::vector<uint256> CoinbaseMerkleBranch(const CBlock& block)
+{
+    std::vector<uint256> level;
+    level.reserve(block.vtx.size() + 1);
+    for (const auto& tx : block.vtx) {
+        level.push_back(tx->GetHash());
+    }
+    std::vector<uint256> branch;
+    while (level.size() > 1) {
+        branch.push_back(level[1]);
+        if (level.size() & 1) {
+            level.push_back(level.back());
+        }
+        for (size_t i = 0; i < level.size() / 2; ++i) {
+            level[i] = Hash(level[2 * i], level[2 * i + 1]);
+        }
+        level.resize(level.size() / 2);
+    }
+    return branch;
+}
+
+CryptoNoteBlockTemplate MakeCryptoNoteTemplate(CBlock block, int height, const Consensus::Params& params, size_t reserve_size)
+{
+    assert(!block.vtx.empty() && reserve_size <= MAX_CN_RESERVE_SIZE);
+
+    CMutableTransaction coinbase{*block.vtx[0]};
+    coinbase.vin[0].scriptSig = CScript() << height << std::vector<unsigned char>(reserve_size, 0);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    block.nNonce = height;
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+
+    CryptoNoteHeader& cn_header = block.cnHeader;
+    cn_header.major_version = params.GetCryptonoteMajorVersion(height);
+    cn_header.minor_version = 0;
+    cn_header.timestamp = block.nTime;
+    cn_header.nonce = 0;
+    cn_header.merkle_root = block.hashMerkleRoot;
+    cn_header.nTxes = block.vtx.size();
+    cn_header.prev_id = block.GetOriginalBlockHash();
+
+    // The extra nonce ends the scriptSig of the coinbase, which is the first
+    // input of the first transaction of the block.
+    const CTransaction& tx = *block.vtx[0];
+    const CScript& script_sig = tx.vin[0].scriptSig;
+    size_t offset = GetSerializeSize(static_cast<const CBlockHeader&>(block)) + GetSizeOfCompactSize(block.vtx.size());
+    offset += sizeof(tx.nVersion) + (tx.HasWitness() ? 2 : 0) + GetSizeOfCompactSize(tx.vin.size());
+    offset += GetSerializeSize(tx.vin[0].prevout) + GetSizeOfCompactSize(script_sig.size()) + script_sig.size() - reserve_size;
+
+    CryptoNoteBlockTemplate tmpl;
+    tmpl.merkle_branch = CoinbaseMerkleBranch(block);
+    tmpl.block = std::move(block);
+    tmpl.reserve_size = reserve_size;
+    tmpl.reserved_offset = offset;
+    return tmpl;
+}
+
+void SetCryptoNoteNonce(const CryptoNoteBlockTemplate& tmpl, CBlock& block, Span<const unsigned char> extra_nonce, uint32_t nonce)
+{
+    assert(extra_nonce.size() <= tmpl.reserve_size);
+
+    CMutableTransaction coinbase{*tmpl.block.vtx[0]};
+    CScript& script_sig = coinbase.vin[0].scriptSig;
+    std::copy(extra_nonce.begin(), extra_nonce.end(), script_sig.end() - tmpl.reserve_size);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+
+    uint256 merkle_root = block.vtx[0]->GetHash();
+    for (const uint256& hash : tmpl.merkle_branch) {
+        merkle_root = Hash(merkle_root, hash);
+    }
+    block.hashMerkleRoot = merkle_root;
+    block.cnHeader.merkle_root = merkle_root;
+    block.cnHeader.nonce = nonce;
+    block.cnHeader.prev_id = block.GetOriginalBlockHash();
+}
 } // namespace node
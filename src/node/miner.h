@@ -8,6 +8,7 @@
 
 #include <policy/policy.h>
 #include <primitives/block.h>
+#include <span.h>
 #include <txmempool.h>
 
 #include <memory>
@@ -141,6 +142,7 @@ private:
     uint64_t nBlockWeight;
     uint64_t nBlockTx;
     uint64_t nBlockSigOpsCost;
+    uint64_t nBlockKevaOps;
     CAmount nFees;
     std::unordered_set<Txid, SaltedTxidHasher> inBlock;
 
@@ -169,6 +171,7 @@ public:
 
     inline static std::optional<int64_t> m_last_block_num_txs{};
     inline static std::optional<int64_t> m_last_block_weight{};
+    inline static std::optional<int64_t> m_last_block_num_keva_ops{};
 
 private:
     const Options m_options;
@@ -197,6 +200,10 @@ private:
     bool TestPackageTransactions(const CTxMemPool::setEntries& package) const;
     /** Sort the package in an order that is valid to appear in a block */
     void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
+    /** Add the in-mempool namespace updates following the keva outputs of a
+      * just added package, as long as they pay at least packageFeeRate.
+      * The added entries are inserted into package. */
+    void AddKevaChains(const CTxMemPool& mempool, CTxMemPool::setEntries& package, const CFeeRate& packageFeeRate) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -206,6 +213,39 @@ void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
 
 /** Apply -blockmintxfee and -blockmaxweight options from ArgsManager to BlockAssembler options. */
 void ApplyArgsManOptions(const ArgsManager& gArgs, BlockAssembler::Options& options);
+
+/** Default number of extra nonce bytes reserved in CryptoNote templates */
+static constexpr size_t DEFAULT_CN_RESERVE_SIZE{8};
+/** Maximum number of extra nonce bytes, keeping the coinbase scriptSig well below 100 bytes */
+static constexpr size_t MAX_CN_RESERVE_SIZE{64};
+
+/**
+ * A block template in the form used by CryptoNote pool software.  The
+ * coinbase scriptSig ends with reserve_size extra nonce bytes, which are
+ * zero in block and found at reserved_offset of the serialized block.
+ * Changing the extra nonce only requires rehashing the coinbase: the rest
+ * of the merkle tree is summarized by merkle_branch.
+ */
+struct CryptoNoteBlockTemplate
+{
+    CBlock block;
+    std::vector<uint256> merkle_branch;
+    size_t reserve_size{0};
+    size_t reserved_offset{0};
+};
+
+/**
+ * Turn a block from CreateNewBlock into a CryptoNote template: reserve the
+ * extra nonce bytes in the coinbase, set nNonce to the height and fill in the
+ * CryptoNote header.
+ */
+CryptoNoteBlockTemplate MakeCryptoNoteTemplate(CBlock block, int height, const Consensus::Params& params, size_t reserve_size);
+
+/**
+ * Set the extra nonce (zero padded to reserve_size bytes) and the CryptoNote
+ * nonce of a copy of the template block, updating its merkle root and prev_id.
+ */
+void SetCryptoNoteNonce(const CryptoNoteBlockTemplate& tmpl, CBlock& block, Span<const unsigned char> extra_nonce, uint32_t nonce);
 } // namespace node
 
 #endif // KEVACOININ_NODE_MINER_H
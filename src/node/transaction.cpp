@@ -120,19 +120,10 @@ TransactionError BroadcastTransaction(NodeContext& node, const CTransactionRef t
     }
 
     {
-        CKevaScript kevaOp;
-        auto _tx = tx;
-        if (_tx->IsKevacoin()) {
-            for (const auto& txOut : _tx->vout) {
-                const CKevaScript curKevaOp(txOut.scriptPubKey);
-                if (!curKevaOp.isKevaOp()) {
-                    continue;
-                }
-                assert(!kevaOp.isKevaOp());
-                kevaOp = curKevaOp;
-            }
-            assert(kevaOp.isKevaOp());
-            node.mempool->addKevaUnchecked(txid, kevaOp);
+        if (tx->IsKevacoin()) {
+            const CTransaction::KevaOutputs& keva_outputs = tx->GetKevaOutputs();
+            assert(keva_outputs.size() == 1);
+            node.mempool->addKevaUnchecked(txid, keva_outputs.front().second);
         }
     }
 
@@ -15,11 +15,57 @@
 
 #include <cassert>
 #include <cstdio>
+#include <ios>
 #include <optional>
 #include <string>
 
 namespace node {
 
+//! Flags of a keva record in a snapshot.
+static constexpr uint8_t SNAPSHOT_KEVA_ASSOCIATION{1};
+static constexpr uint8_t SNAPSHOT_KEVA_NEW_NAMESPACE{2};
+
+SnapshotKevaWriter::SnapshotKevaWriter(AutoFile& file, uint64_t count) : m_file{file}
+{
+    m_file << SNAPSHOT_KEVA_MAGIC << count;
+}
+
+void SnapshotKevaWriter::Write(bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+    uint8_t flags{association ? SNAPSHOT_KEVA_ASSOCIATION : uint8_t{0}};
+    if (m_namespace != nameSpace) {
+        flags |= SNAPSHOT_KEVA_NEW_NAMESPACE;
+        m_namespace = nameSpace;
+    }
+    m_file << flags;
+    if (flags & SNAPSHOT_KEVA_NEW_NAMESPACE) m_file << nameSpace;
+    m_file << key << data;
+}
+
+SnapshotKevaReader::SnapshotKevaReader(AutoFile& file, uint64_t& count) : m_file{file}
+{
+    m_file >> count;
+}
+
+void SnapshotKevaReader::Read(bool& association, valtype& nameSpace, valtype& key, CKevaData& data)
+{
+    uint8_t flags;
+    m_file >> flags;
+    if (flags & ~(SNAPSHOT_KEVA_ASSOCIATION | SNAPSHOT_KEVA_NEW_NAMESPACE)) {
+        throw std::ios_base::failure("unknown keva record flags");
+    }
+    association = flags & SNAPSHOT_KEVA_ASSOCIATION;
+    if (flags & SNAPSHOT_KEVA_NEW_NAMESPACE) {
+        m_file >> nameSpace;
+        m_namespace = nameSpace;
+    } else if (m_namespace) {
+        nameSpace = *m_namespace;
+    } else {
+        throw std::ios_base::failure("keva record without namespace");
+    }
+    m_file >> key >> data;
+}
+
 bool WriteSnapshotBaseBlockhash(Chainstate& snapshot_chainstate)
 {
     AssertLockHeld(::cs_main);
@@ -6,16 +6,19 @@
 #ifndef KEVACOININ_NODE_UTXO_SNAPSHOT_H
 #define KEVACOININ_NODE_UTXO_SNAPSHOT_H
 
+#include <keva/common.h>
 #include <kernel/cs_main.h>
 #include <serialize.h>
 #include <sync.h>
 #include <uint256.h>
 #include <util/fs.h>
 
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <string_view>
 
+class AutoFile;
 class Chainstate;
 
 namespace node {
@@ -42,6 +45,45 @@ public:
     SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count); }
 };
 
+//! Magic bytes starting the keva section of a snapshot.
+//!
+//! The keva entries and namespace associations of a snapshot follow its
+//! coins, as these magic bytes, the number of records and the records in the
+//! order of CCoinsView::KevaCursor().  Snapshots without any keva records end
+//! after the coins.
+constexpr std::array<uint8_t, 4> SNAPSHOT_KEVA_MAGIC{'k', 'e', 'v', 'a'};
+
+//! Writes the keva records of a snapshot.  The namespace of a record is left
+//! out if it is the same as that of the previous record.
+class SnapshotKevaWriter
+{
+private:
+    AutoFile& m_file;
+    std::optional<valtype> m_namespace;
+
+public:
+    //! Start the keva section with the given number of records.
+    SnapshotKevaWriter(AutoFile& file, uint64_t count);
+
+    void Write(bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data);
+};
+
+//! Reads the keva records written by SnapshotKevaWriter.  Throws
+//! std::ios_base::failure if the data is malformed.
+class SnapshotKevaReader
+{
+private:
+    AutoFile& m_file;
+    std::optional<valtype> m_namespace;
+
+public:
+    //! Continue after the magic bytes, which the caller has already read,
+    //! and read the number of records.
+    SnapshotKevaReader(AutoFile& file, uint64_t& count);
+
+    void Read(bool& association, valtype& nameSpace, valtype& key, CKevaData& data);
+};
+
 //! The file in the snapshot chainstate dir which stores the base blockhash. This is
 //! needed to reconstruct snapshot chainstates on init.
 //!
@@ -7,6 +7,7 @@
 
 #include <arith_uint256.h>
 #include <chain.h>
+#include <logging.h>
 #include <primitives/block.h>
 #include <uint256.h>
 #include <validation.h>
@@ -14,6 +15,11 @@
 #include <crypto/common.h>
 #include <crypto/hash-ops.h>
 
+#include <array>
+#include <atomic>
+#include <limits>
+#include <optional>
+
 #define BEGIN(a)            ((char*)&(a))
 
 extern "C" void cn_slow_hash(const void *data, size_t length, char *hash, int variant, int prehashed, uint64_t height);
@@ -178,7 +184,123 @@ bool PermittedDifficultyTransition(const Consensus::Params& params, int64_t heig
     return true;
 }
 
-static void cn_get_block_hash_by_height(uint64_t seed_height, char cnHash[32])
+namespace {
+
+// As in rx-slow-hash.c.
+constexpr uint64_t SEEDHASH_EPOCH_BLOCKS{2048};
+constexpr uint64_t SEEDHASH_EPOCH_LAG{64};
+
+/**
+ * The RandomX seed block hashes of the active chain, for the last few
+ * epochs.  Written with cs_main held whenever the tip changes, read by
+ * GetPoWHash without taking any lock.  Each slot is a seqlock: a reader that
+ * raced with a write sees the sequence number change and retries.
+ */
+class SeedHashTable
+{
+private:
+    static constexpr size_t SLOTS{4};
+    static constexpr uint64_t NO_HEIGHT{std::numeric_limits<uint64_t>::max()};
+
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint64_t> height{NO_HEIGHT};
+        std::array<std::atomic<uint64_t>, 4> words{};
+    };
+    std::array<Slot, SLOTS> m_slots;
+
+    Slot& GetSlot(uint64_t seed_height) { return m_slots[(seed_height / SEEDHASH_EPOCH_BLOCKS) % SLOTS]; }
+
+    // Only one writer at a time, as all writes happen under cs_main.
+    void Write(Slot& slot, uint64_t seed_height, const uint256& hash)
+    {
+        const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.height.store(seed_height, std::memory_order_relaxed);
+        for (size_t i = 0; i < slot.words.size(); ++i) {
+            slot.words[i].store(ReadLE64(hash.begin() + 8 * i), std::memory_order_relaxed);
+        }
+        slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+public:
+    std::optional<uint256> Get(uint64_t seed_height) const
+    {
+        const Slot& slot = m_slots[(seed_height / SEEDHASH_EPOCH_BLOCKS) % SLOTS];
+        uint64_t height;
+        uint256 hash;
+        while (true) {
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            height = slot.height.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < slot.words.size(); ++i) {
+                WriteLE64(hash.begin() + 8 * i, slot.words[i].load(std::memory_order_relaxed));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) break;
+        }
+        if (height != seed_height) return std::nullopt;
+        return hash;
+    }
+
+    void Set(uint64_t seed_height, const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        if (Get(seed_height) == hash) return;
+        Write(GetSlot(seed_height), seed_height, hash);
+    }
+
+    /** Forget the seed blocks above the given height (all if none), e.g. after they were disconnected.  */
+    void EraseAbove(std::optional<uint64_t> max_height) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        for (Slot& slot : m_slots) {
+            const uint64_t height = slot.height.load(std::memory_order_relaxed);
+            if (height != NO_HEIGHT && (!max_height || height > *max_height)) {
+                Write(slot, NO_HEIGHT, uint256());
+            }
+        }
+    }
+};
+
+SeedHashTable g_seed_hashes;
+
+/** RandomX takes the seed block hash in reverse byte order.  */
+void GetCNSeedHash(const uint256& seed_hash, char cnHash[32])
+{
+    const unsigned char* pHash = seed_hash.begin();
+    for (int j = 31; j >= 0; j--) {
+        cnHash[31 - j] = pHash[j];
+    }
+}
+
+} // namespace
+
+void UpdatePoWSeedHashes(const CBlockIndex* tip)
+{
+    AssertLockHeld(cs_main);
+    if (tip == nullptr) {
+        g_seed_hashes.EraseAbove(std::nullopt);
+        return;
+    }
+    g_seed_hashes.EraseAbove(tip->nHeight);
+    // The seeds of the next block and of the next epoch.
+    const uint64_t next_height = tip->nHeight + 1;
+    for (const uint64_t seed_height : {crypto::rx_seedheight(next_height), crypto::rx_seedheight(next_height + SEEDHASH_EPOCH_LAG)}) {
+        if (const CBlockIndex* seed = tip->GetAncestor(seed_height)) {
+            g_seed_hashes.Set(seed_height, seed->GetBlockHash());
+            // With -randomxfastverify, get the datasets of both epochs built
+            // in the background, so that the epoch switch does not stall.
+            char cnHash[32];
+            GetCNSeedHash(seed->GetBlockHash(), cnHash);
+            if (!crypto::rx_prepare_fast_verify(seed_height, cnHash)) {
+                LogPrintf("Couldn't allocate the RandomX dataset for fast verification, using the light cache instead\n");
+            }
+        }
+    }
+}
+
+// Slow path for the seeds of blocks away from the tip of the active chain.
+static uint256 cn_get_block_hash_by_height(uint64_t seed_height)
 {
     LOCK(cs_main);
     CBlockIndex* pblockindex = g_chainman->ActiveChain()[seed_height];
@@ -188,15 +310,28 @@ static void cn_get_block_hash_by_height(uint64_t seed_height, char cnHash[32])
         // are out of sync by more than at least SEEDHASH_EPOCH_BLOCKS blocks.
         pblockindex = g_chainman->m_blockman.GetBlockSeedHeight(seed_height);
         if (pblockindex == nullptr) {
-            int pp = 0;
-            return;
+            return uint256();
         }
     }
-    uint256 blockHash = pblockindex->GetBlockHash();
-    const unsigned char* pHash = blockHash.begin();
-    for (int j = 31; j >= 0; j--) {
-        cnHash[31 - j] = pHash[j];
+    return pblockindex->GetBlockHash();
+}
+
+static uint256 CalculatePoWHash(const CBlockHeader& header, const uint256& seed_hash)
+{
+    uint256 thash;
+    unsigned char blob[CryptoNoteHeader::MAX_BLOB_SIZE];
+    const size_t blob_size = header.cnHeader.WriteBlob(blob);
+    uint32_t height = header.nNonce;
+    if (header.cnHeader.major_version >= RX_BLOCK_VERSION) {
+        uint64_t seed_height = crypto::rx_seedheight(height);
+        char cnHash[32];
+        GetCNSeedHash(seed_hash, cnHash);
+        crypto::rx_slow_hash(height, seed_height, cnHash, blob, blob_size, BEGIN(thash), 0, 0);
+    } else {
+        cn_slow_hash(blob, blob_size, BEGIN(thash), header.cnHeader.major_version - 6, 0, height);
     }
+
+    return thash;
 }
 
 const uint256 GetPoWHash(const CBlockHeader& header)
@@ -207,19 +342,28 @@ const uint256 GetPoWHash(const CBlockHeader& header)
         // return thash;
     }
 
-    uint256 thash;
-    cryptonote::blobdata blob = cryptonote::t_serializable_object_to_blob(header.cnHeader);
-    uint32_t height = header.nNonce;
+    uint256 seed_hash;
     if (header.cnHeader.major_version >= RX_BLOCK_VERSION) {
-        uint64_t seed_height = crypto::rx_seedheight(height);
-        char cnHash[32];
-        cn_get_block_hash_by_height(seed_height, cnHash);
-        crypto::rx_slow_hash(height, seed_height, cnHash, blob.data(), blob.size(), BEGIN(thash), 0, 0);
-    } else {
-        cn_slow_hash(blob.data(), blob.size(), BEGIN(thash), header.cnHeader.major_version - 6, 0, height);
+        const uint64_t seed_height = crypto::rx_seedheight(header.nNonce);
+        seed_hash = g_seed_hashes.Get(seed_height).value_or(uint256());
+        if (seed_hash.IsNull()) {
+            seed_hash = cn_get_block_hash_by_height(seed_height);
+        }
     }
+    return CalculatePoWHash(header, seed_hash);
+}
 
-    return thash;
+const uint256 GetPoWHash(const CBlockHeader& header, const uint256& seed_hash)
+{
+    if (!(header.isCNConsistent())) {
+        return (HashWriter{} << header).GetHash();
+    }
+    return CalculatePoWHash(header, seed_hash);
+}
+
+bool CPoWCheck::operator()()
+{
+    return CheckProofOfWork(GetPoWHash(*m_header, m_seed_hash), m_header->nBits, *m_params);
 }
 
 bool CheckProofOfWork(CBlock block, unsigned int nBits, const Consensus::Params& params)
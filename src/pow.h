@@ -7,24 +7,59 @@
 #define KEVACOIN_POW_H
 
 #include <consensus/params.h>
+#include <uint256.h>
 
 #include <stdint.h>
 
 class CBlockHeader;
 class CBlock;
 class CBlockIndex;
-class uint256;
+
+/** Default for -randomxfastverify */
+static constexpr bool DEFAULT_RANDOMX_FAST_VERIFY{false};
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&);
 unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nFirstBlockTime, const Consensus::Params&);
 
-static void cn_get_block_hash_by_height(uint64_t seed_height, char cnHash[32]);
+/**
+ * Record the RandomX seed block hashes of the active chain ending at tip, so
+ * that GetPoWHash can find them without cs_main.  Must be called (with
+ * cs_main held) whenever the tip of the active chain changes.
+ */
+void UpdatePoWSeedHashes(const CBlockIndex* tip);
+/**
+ * Compute the PoW hash of a header.  The RandomX seed block hash comes from
+ * the table kept by UpdatePoWSeedHashes; only headers whose seed is not
+ * recorded there fall back to a cs_main lookup.
+ */
 const uint256 GetPoWHash(const CBlockHeader& header);
+/** Compute the PoW hash of a header whose RandomX seed block hash is already known (unused before RandomX). */
+const uint256 GetPoWHash(const CBlockHeader& header, const uint256& seed_hash);
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(CBlock block, unsigned int nBits, const Consensus::Params&);
 bool CheckProofOfWork(CBlockHeader header, unsigned int nBits, const Consensus::Params&);
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
 
+/**
+ * Closure representing the proof of work check of one header, so that the
+ * RandomX/CryptoNight hashes of a batch of headers can be computed by the
+ * worker threads of a CCheckQueue, each with its own RandomX VM.  The seed
+ * block hash is looked up beforehand so that the workers need no cs_main.
+ */
+class CPoWCheck
+{
+private:
+    const CBlockHeader* m_header;
+    uint256 m_seed_hash;
+    const Consensus::Params* m_params;
+
+public:
+    CPoWCheck(const CBlockHeader& header, const uint256& seed_hash, const Consensus::Params& params)
+        : m_header(&header), m_seed_hash(seed_hash), m_params(&params) {}
+
+    bool operator()();
+};
+
 /**
  * Return false if the proof-of-work requirement specified by new_nbits at a
  * given height is not possible, given the proof-of-work on the prior block as
@@ -16,6 +16,60 @@
 
 #define BEGIN(a)            ((char*)&(a))
 
+namespace {
+
+/** Read a varint exactly like binary_archive, failing wherever it would not read cleanly.  */
+template <typename T>
+bool ReadCNVarInt(Span<const unsigned char>& blob, T& value)
+{
+    const int read = tools::read_varint(blob.begin(), blob.end(), value);
+    if (read <= 0 || (blob[read - 1] & 0x80)) return false;
+    blob = blob.subspan(read);
+    return true;
+}
+
+bool ReadCNBytes(Span<const unsigned char>& blob, unsigned char* out, size_t size)
+{
+    if (blob.size() < size) return false;
+    memcpy(out, blob.data(), size);
+    blob = blob.subspan(size);
+    return true;
+}
+
+} // namespace
+
+size_t CryptoNoteHeader::WriteBlob(unsigned char (&out)[MAX_BLOB_SIZE]) const
+{
+    unsigned char* it = out;
+    tools::write_varint(it, major_version);
+    tools::write_varint(it, minor_version);
+    tools::write_varint(it, timestamp);
+    memcpy(it, prev_id.begin(), prev_id.size());
+    it += prev_id.size();
+    WriteLE32(it, nonce);
+    it += sizeof(nonce);
+    memcpy(it, merkle_root.begin(), merkle_root.size());
+    it += merkle_root.size();
+    tools::write_varint(it, nTxes);
+    return it - out;
+}
+
+bool CryptoNoteHeader::ReadBlob(Span<const unsigned char> blob)
+{
+    CryptoNoteHeader header;
+    unsigned char nonce_bytes[sizeof(nonce)];
+    if (!ReadCNVarInt(blob, header.major_version) || !ReadCNVarInt(blob, header.minor_version)
+        || !ReadCNVarInt(blob, header.timestamp) || !ReadCNBytes(blob, header.prev_id.begin(), header.prev_id.size())
+        || !ReadCNBytes(blob, nonce_bytes, sizeof(nonce_bytes))
+        || !ReadCNBytes(blob, header.merkle_root.begin(), header.merkle_root.size())
+        || !ReadCNVarInt(blob, header.nTxes) || !blob.empty()) {
+        return false;
+    }
+    header.nonce = ReadLE32(nonce_bytes);
+    *this = header;
+    return true;
+}
+
 extern "C" void cn_fast_hash(const void *data, size_t length, char *hash);
 
 uint256 CBlockHeader::GetOriginalBlockHash() const
@@ -34,17 +88,34 @@ bool CBlockHeader::isCNConsistent() const
     return (GetOriginalBlockHash() == cnHeader.prev_id);
 }
 
-uint256 CBlockHeader::GetHash() const
-{    
+uint256 CBlockHeader::ComputeHash() const
+{
     if (!isCNConsistent()) {
         return (HashWriter{} << *this).GetHash();
     }
     uint256 thash;
-    cryptonote::blobdata blob = cryptonote::t_serializable_object_to_blob(cnHeader);
-    cn_fast_hash(blob.data(), blob.size(), BEGIN(thash));
+    unsigned char blob[CryptoNoteHeader::MAX_BLOB_SIZE];
+    cn_fast_hash(blob, cnHeader.WriteBlob(blob), BEGIN(thash));
     return thash;
 }
 
+void CBlockHeader::CacheHash()
+{
+    m_hash_cache.reset();
+    m_hash_cache = HashCache{.nVersion = nVersion, .hashPrevBlock = hashPrevBlock, .hashMerkleRoot = hashMerkleRoot,
+                             .nTime = nTime, .nBits = nBits, .nNonce = nNonce, .cnHeader = cnHeader, .hash = ComputeHash()};
+}
+
+uint256 CBlockHeader::GetHash() const
+{
+    if (m_hash_cache && m_hash_cache->nVersion == nVersion && m_hash_cache->hashPrevBlock == hashPrevBlock
+        && m_hash_cache->hashMerkleRoot == hashMerkleRoot && m_hash_cache->nTime == nTime
+        && m_hash_cache->nBits == nBits && m_hash_cache->nNonce == nNonce && m_hash_cache->cnHeader == cnHeader) {
+        return m_hash_cache->hash;
+    }
+    return ComputeHash();
+}
+
 // uint256 CBlockHeader::GetHash() const
 // {
 //     return (HashWriter{} << *this).GetHash();
@@ -11,6 +11,7 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <optional>
 
 #include <cryptonote_basic/cryptonote_format_utils.h>
 
@@ -88,27 +89,65 @@ public:
     }
 
 
+    /** Upper bound of the size of the CryptoNote serialization of a header.  */
+    static constexpr size_t MAX_BLOB_SIZE = 2 + 2 + 10 + 32 + 4 + 32 + 10;
+
+    /**
+     * Write the CryptoNote serialization of the header (as produced by
+     * t_serializable_object_to_blob) into the given buffer, without going
+     * through binary_archive and its allocations.
+     * @return The size of the serialization.
+     */
+    size_t WriteBlob(unsigned char (&out)[MAX_BLOB_SIZE]) const;
+
+    /**
+     * Parse a CryptoNote serialization of a header.  Only blobs that
+     * binary_archive would read cleanly and completely are accepted; the
+     * header is left untouched otherwise.
+     */
+    bool ReadBlob(Span<const unsigned char> blob);
+
+    friend bool operator==(const CryptoNoteHeader& a, const CryptoNoteHeader& b)
+    {
+        return a.major_version == b.major_version && a.minor_version == b.minor_version
+            && a.timestamp == b.timestamp && a.prev_id == b.prev_id && a.nonce == b.nonce
+            && a.merkle_root == b.merkle_root && a.nTxes == b.nTxes;
+    }
+
     // SERIALIZE_METHODS(CryptoNoteHeader, obj) { READWRITE(obj.major_version, obj.minor_version, obj.timestamp, obj.prev_id, obj.nonce, obj.merkle_root, obj.nTxes); }
-    ADD_SERIALIZE_METHODS;
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        if (ser_action.ForRead()) {
-            std::string blob;
-            READWRITE(blob);
-            std::stringstream ss;
-            ss << blob;
-            // load
-            binary_archive<false> ba(ss);
-            ::serialization::serialize(ba, *this);
+    // The CryptoNote serialization is embedded as a length prefixed blob.
+    // Well-formed headers go through a fixed size buffer; anything else is
+    // handed to binary_archive, so that malformed blobs are still read the
+    // way they always have been.
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char buf[MAX_BLOB_SIZE];
+        const size_t size = WriteBlob(buf);
+        WriteCompactSize(s, size);
+        s.write(MakeByteSpan(buf).first(size));
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint64_t size = ReadCompactSize(s);
+        std::string blob;
+        if (size <= MAX_BLOB_SIZE) {
+            unsigned char buf[MAX_BLOB_SIZE];
+            s.read(MakeWritableByteSpan(buf).first(size));
+            if (ReadBlob(Span{buf}.first(size))) return;
+            blob.assign(buf, buf + size);
         } else {
-            std::stringstream ss;
-            // store
-            binary_archive<true> ba(ss);
-            ::serialization::serialize(ba, *this);
-            std::string blob = ss.str();
-            READWRITE(blob);
+            blob.resize(size);
+            s.read(MakeWritableByteSpan(blob));
         }
+        std::stringstream ss;
+        ss << blob;
+        // load
+        binary_archive<false> ba(ss);
+        ::serialization::serialize(ba, *this);
     }
 };
 
@@ -150,6 +189,9 @@ public:
         READWRITE(nBits);
         READWRITE(nNonce);
         READWRITE(cnHeader);
+        if (ser_action.ForRead()) {
+            CacheHash();
+        }
     }
 
     // SERIALIZE_METHODS(CBlockHeader, obj) { READWRITE(obj.nVersion, obj.hashPrevBlock, obj.hashMerkleRoot, obj.nTime, obj.nBits, obj.nNonce, obj.cnHeader); }
@@ -163,6 +205,7 @@ public:
         nBits = 0;
         nNonce = 0;
         cnHeader.SetNull();
+        m_hash_cache.reset();
     }
 
     bool IsNull() const
@@ -190,6 +233,29 @@ public:
 
     bool isCNConsistent() const;
 
+private:
+    /**
+     * The hash of a deserialized header, with a copy of the fields it was
+     * computed from.  The fields are public, so GetHash() only trusts the
+     * cached hash while they still match.
+     */
+    struct HashCache {
+        int32_t nVersion;
+        uint256 hashPrevBlock;
+        uint256 hashMerkleRoot;
+        uint32_t nTime;
+        uint32_t nBits;
+        uint32_t nNonce;
+        CryptoNoteHeader cnHeader;
+        uint256 hash;
+    };
+    std::optional<HashCache> m_hash_cache;
+
+    uint256 ComputeHash() const;
+    void CacheHash();
+
+public:
+
     // bool isLegacy()
     // {
     //     return legacyMode;
@@ -240,16 +306,8 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        block.hashPrevBlock  = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime          = nTime;
-        block.nBits          = nBits;
-        block.nNonce         = nNonce;
-        block.cnHeader       = cnHeader;
-        // block.SetLegacy(legacyMode);
-        return block;
+        // Copying (rather than assigning the fields) keeps the cached hash.
+        return *this;
     }
 
     std::string ToString() const;
@@ -99,14 +99,44 @@ Wtxid CTransaction::ComputeWitnessHash() const
     return Wtxid::FromUint256((HashWriter{} << TX_WITH_WITNESS(*this)).GetHash());
 }
 
-CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
-CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
+std::shared_ptr<const CTransaction::KevaOutputs> CTransaction::ComputeKevaOutputs() const
+{
+    KevaOutputs keva_outputs;
+    for (uint32_t i = 0; i < vout.size(); ++i) {
+        const CScript& script = vout[i].scriptPubKey;
+        if (!CKevaScript::hasKevaPrefix(script)) {
+            continue;
+        }
+        CKevaScript op(script);
+        if (op.isKevaOp()) {
+            keva_outputs.emplace_back(i, std::move(op));
+        }
+    }
+    if (keva_outputs.empty()) {
+        return nullptr;
+    }
+    return std::make_shared<const KevaOutputs>(std::move(keva_outputs));
+}
+
+CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()}, m_keva_outputs{ComputeKevaOutputs()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()}, m_keva_outputs{ComputeKevaOutputs()} {}
+
+const CTransaction::KevaOutputs& CTransaction::GetKevaOutputs() const
+{
+    static const KevaOutputs no_keva_outputs;
+    return m_keva_outputs ? *m_keva_outputs : no_keva_outputs;
+}
 
 CAmount CTransaction::GetValueOut(bool fExcludeKeva) const
 {
     CAmount nValueOut = 0;
-    for (const auto& tx_out : vout) {
-        if (!fExcludeKeva || !CKevaScript::isKevaScript(tx_out.scriptPubKey)) {
+    const KevaOutputs& keva_outputs = GetKevaOutputs();
+    auto keva_it = keva_outputs.begin();
+    for (uint32_t i = 0; i < vout.size(); ++i) {
+        const CTxOut& tx_out = vout[i];
+        const bool is_keva = keva_it != keva_outputs.end() && keva_it->first == i;
+        if (is_keva) ++keva_it;
+        if (!fExcludeKeva || !is_keva) {
             nValueOut += tx_out.nValue;
         }
         if (!MoneyRange(tx_out.nValue) || !MoneyRange(nValueOut + tx_out.nValue))
@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+class CKevaScript;
+
 /** An outpoint - a combination of a transaction hash and an index n into its vout */
 class COutPoint
 {
@@ -299,6 +301,9 @@ public:
     static const int32_t CURRENT_VERSION=2;
     static const int32_t KEVACOIN_VERSION=0x7100;
 
+    /** The keva operations in the outputs, as (output index, parsed script) pairs. */
+    using KevaOutputs = std::vector<std::pair<uint32_t, CKevaScript>>;
+
     // The local variables are made const to prevent unintended modification
     // without updating the cached hash value. However, CTransaction is not
     // actually immutable; deserialization and assignment are implemented,
@@ -314,12 +319,16 @@ private:
     const bool m_has_witness;
     const Txid hash;
     const Wtxid m_witness_hash;
+    /** Memory only. Null if no output is a keva operation. */
+    const std::shared_ptr<const KevaOutputs> m_keva_outputs;
 
     Txid ComputeHash() const;
     Wtxid ComputeWitnessHash() const;
 
     bool ComputeHasWitness() const;
 
+    std::shared_ptr<const KevaOutputs> ComputeKevaOutputs() const;
+
 public:
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction& tx);
@@ -364,6 +373,16 @@ public:
         return nVersion == KEVACOIN_VERSION;
     }
 
+    /**
+     * Get the keva operations of the outputs, parsed once when the
+     * transaction was constructed. Non-Kevacoin transactions are parsed
+     * too, so that consensus can reject keva outputs in them.
+     */
+    const KevaOutputs& GetKevaOutputs() const LIFETIMEBOUND;
+
+    /** The shared keva operations, e.g. for memory accounting. Null if there are none. */
+    const std::shared_ptr<const KevaOutputs>& GetSharedKevaOutputs() const LIFETIMEBOUND { return m_keva_outputs; }
+
     friend bool operator==(const CTransaction& a, const CTransaction& b)
     {
         return a.hash == b.hash;
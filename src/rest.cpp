@@ -9,14 +9,19 @@
 
 #include <rest.h>
 
+#include <base58.h>
 #include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
 #include <flatfile.h>
+#include <hash.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
+#include <key_io.h>
+#include <keva/common.h>
+#include <keva/main.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -32,8 +37,10 @@
 #include <util/any.h>
 #include <util/check.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <any>
 #include <vector>
 
@@ -44,6 +51,7 @@ using node::NodeContext;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+static constexpr unsigned int MAX_REST_KEVA_NAMESPACE_RESULTS = 1000;
 
 static const struct {
     RESTResponseFormat rf;
@@ -55,6 +63,39 @@ static const struct {
       {RESTResponseFormat::JSON, "json"},
 };
 
+/** One result of /rest/kevagetmulti, in the binary response format.  */
+struct CKevaRestEntry {
+    enum State : uint8_t { MISSING = 0, CONFIRMED = 1, UNCONFIRMED = 2 };
+
+    uint8_t state{MISSING};
+    valtype value;
+    uint32_t nHeight{0};
+    COutPoint outpoint;
+
+    SERIALIZE_METHODS(CKevaRestEntry, obj)
+    {
+        READWRITE(obj.state);
+        if (obj.state != MISSING) READWRITE(obj.value);
+        if (obj.state == CONFIRMED) READWRITE(obj.nHeight, obj.outpoint);
+    }
+};
+
+static UniValue KevaRestEntryToJSON(const valtype& nameSpace, const valtype& key, const CKevaRestEntry& entry)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("namespace", EncodeBase58Check(nameSpace));
+    obj.pushKV("key", ValtypeToString(key));
+    obj.pushKV("value", ValtypeToString(entry.value));
+    if (entry.state == CKevaRestEntry::CONFIRMED) {
+        obj.pushKV("txid", entry.outpoint.hash.GetHex());
+        obj.pushKV("vout", (int32_t)entry.outpoint.n);
+        obj.pushKV("height", (int32_t)entry.nHeight);
+    } else if (entry.state == CKevaRestEntry::UNCONFIRMED) {
+        obj.pushKV("height", -1);
+    }
+    return obj;
+}
+
 struct CCoin {
     uint32_t nHeight;
     CTxOut out;
@@ -953,6 +994,366 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     }
 }
 
+static bool rest_kevagetmulti(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, strURIPart);
+
+    std::vector<std::string> uriParts;
+    if (param.length() > 1) {
+        uriParts = SplitString(param.substr(1), '/');
+    }
+
+    std::string strRequestMutable = req->ReadBody();
+    if (strRequestMutable.length() == 0 && uriParts.size() == 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+
+    // inputs are sent over URI scheme (/rest/kevagetmulti/namespace1-hexkey1/namespace2-hexkey2/...)
+    // or, for the binary formats, as a serialized vector of (namespace, key) pairs
+    std::vector<CKevaCache::NamespaceKeyType> names;
+    for (const std::string& part : uriParts) {
+        const size_t sep = part.find('-');
+        valtype nameSpace;
+        if (sep == std::string::npos || !DecodeKevaNamespace(part.substr(0, sep), Params(), nameSpace)) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        auto key = TryParseHex<unsigned char>(part.substr(sep + 1));
+        if (!key) return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        names.emplace_back(std::move(nameSpace), std::move(*key));
+    }
+    const bool fInputParsed = !names.empty();
+
+    switch (rf) {
+    case RESTResponseFormat::HEX: {
+        // convert hex to bin, continue then with bin part
+        std::vector<unsigned char> strRequestV = ParseHex(strRequestMutable);
+        strRequestMutable.assign(strRequestV.begin(), strRequestV.end());
+        [[fallthrough]];
+    }
+
+    case RESTResponseFormat::BINARY: {
+        try {
+            if (strRequestMutable.size() > 0) {
+                if (fInputParsed) //don't allow sending input over URI and HTTP RAW DATA
+                    return RESTERR(req, HTTP_BAD_REQUEST, "Combination of URI scheme inputs and raw post data is not allowed");
+
+                // The body is the serialized vector itself, not a string.
+                std::vector<std::pair<valtype, valtype>> pairs;
+                DataStream oss{MakeByteSpan(strRequestMutable)};
+                oss >> pairs;
+                if (!oss.empty()) return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+                for (auto& [nameSpace, key] : pairs) {
+                    names.emplace_back(std::move(nameSpace), std::move(key));
+                }
+            }
+        } catch (const std::ios_base::failure&) {
+            // abort in case of unreadable binary data
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        break;
+    }
+
+    case RESTResponseFormat::JSON: {
+        if (!fInputParsed)
+            return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+        break;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    if (names.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    if (names.size() > MAX_KEVA_LOOKUP_NAMES)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max keys exceeded (max: %d, tried: %d)", MAX_KEVA_LOOKUP_NAMES, names.size()));
+    for (const auto& [nameSpace, key] : names) {
+        if (nameSpace.size() > MAX_NAMESPACE_LENGTH || key.size() > MAX_KEY_LENGTH)
+            return RESTERR(req, HTTP_BAD_REQUEST, "Error: namespace or key too long");
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    const CTxMemPool* mempool = GetMemPool(context, req);
+    if (!mempool) return false;
+
+    int active_height;
+    uint256 active_hash;
+    const std::vector<CKevaLookup> lookups = LookupKevaEntries(*maybe_chainman, mempool, names, active_height, active_hash);
+
+    std::vector<CKevaRestEntry> entries(lookups.size());
+    for (size_t i = 0; i < lookups.size(); ++i) {
+        if (lookups[i].unconfirmed) {
+            entries[i].state = CKevaRestEntry::UNCONFIRMED;
+            entries[i].value = *lookups[i].unconfirmed;
+        } else if (lookups[i].confirmed) {
+            entries[i].state = CKevaRestEntry::CONFIRMED;
+            entries[i].value = lookups[i].confirmed->getValue();
+            entries[i].nHeight = lookups[i].confirmed->getHeight();
+            entries[i].outpoint = lookups[i].confirmed->getUpdateOutpoint();
+        }
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        DataStream ssResponse{};
+        ssResponse << active_height << active_hash << entries;
+
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssResponse.str());
+        return true;
+    }
+
+    case RESTResponseFormat::HEX: {
+        DataStream ssResponse{};
+        ssResponse << active_height << active_hash << entries;
+        std::string strHex = HexStr(ssResponse) + "\n";
+
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RESTResponseFormat::JSON: {
+        UniValue objResponse(UniValue::VOBJ);
+        objResponse.pushKV("chainHeight", active_height);
+        objResponse.pushKV("chaintipHash", active_hash.GetHex());
+
+        UniValue arr(UniValue::VARR);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            arr.push_back(KevaRestEntryToJSON(std::get<0>(names[i]), std::get<1>(names[i]), entries[i]));
+        }
+        objResponse.pushKV("entries", arr);
+
+        std::string strJSON = objResponse.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+/**
+ * Write the caching headers of a keva response, which only change when the
+ * returned entries do.  Replies with 304 Not Modified and returns true if the
+ * client already has the current version.
+ */
+static bool KevaNotModified(HTTPRequest* req, const std::string& etag, int64_t last_modified)
+{
+    req->WriteHeader("ETag", etag);
+    req->WriteHeader("Last-Modified", FormatHTTPDateTime(last_modified));
+    const auto [found, if_none_match] = req->GetHeader("If-None-Match");
+    if (found && (if_none_match == "*" || if_none_match.find(etag) != std::string::npos)) {
+        req->WriteReply(HTTP_NOT_MODIFIED);
+        return true;
+    }
+    return false;
+}
+
+static bool rest_keva(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, strURIPart);
+
+    // Check the format first, as the caching headers are written before the body.
+    if (rf == RESTResponseFormat::UNDEF) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+
+    // /rest/keva/<namespace>/<hexkey>
+    const size_t sep = param.find('/');
+    valtype nameSpace;
+    if (sep == std::string::npos || !DecodeKevaNamespace(param.substr(0, sep), Params(), nameSpace)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid namespace: " + SanitizeString(param.substr(0, sep)));
+    }
+    auto key = TryParseHex<unsigned char>(param.substr(sep + 1));
+    if (!key || key->empty() || key->size() > MAX_KEY_LENGTH) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid key: " + SanitizeString(param.substr(sep + 1)));
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    ChainstateManager& chainman = *maybe_chainman;
+
+    CKevaData data;
+    int64_t block_time;
+    {
+        LOCK(cs_main);
+        if (!chainman.ActiveChainstate().CoinsTip().GetName(nameSpace, *key, data)) {
+            return RESTERR(req, HTTP_NOT_FOUND, "Key not found");
+        }
+        block_time = Assert(chainman.ActiveChain()[data.getHeight()])->GetBlockTime();
+    }
+
+    CKevaRestEntry entry;
+    entry.state = CKevaRestEntry::CONFIRMED;
+    entry.value = data.getValue();
+    entry.nHeight = data.getHeight();
+    entry.outpoint = data.getUpdateOutpoint();
+
+    // The update outpoint identifies the value, so the entry does not change
+    // as long as the height and the outpoint do not.
+    const std::string etag{strprintf("\"%u-%s-%u\"", entry.nHeight, entry.outpoint.hash.GetHex(), entry.outpoint.n)};
+    if (KevaNotModified(req, etag, block_time)) return true;
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        DataStream ssEntry{};
+        ssEntry << entry;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssEntry.str());
+        return true;
+    }
+
+    case RESTResponseFormat::HEX: {
+        DataStream ssEntry{};
+        ssEntry << entry;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ssEntry) + "\n");
+        return true;
+    }
+
+    case RESTResponseFormat::JSON: {
+        std::string strJSON = KevaRestEntryToJSON(nameSpace, *key, entry).write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_kevanamespace(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, strURIPart);
+
+    // Check the format first, as the caching headers are written before the body.
+    if (rf == RESTResponseFormat::UNDEF) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+
+    // /rest/kevanamespace/<namespace>?start=<hexkey>&count=<count>
+    valtype nameSpace;
+    if (!DecodeKevaNamespace(param, Params(), nameSpace)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid namespace: " + SanitizeString(param));
+    }
+    valtype start;
+    size_t count{MAX_REST_KEVA_NAMESPACE_RESULTS};
+    try {
+        if (const auto start_str{req->GetQueryParameter("start")}) {
+            auto parsed = TryParseHex<unsigned char>(*start_str);
+            if (!parsed) return RESTERR(req, HTTP_BAD_REQUEST, "Invalid start key: " + SanitizeString(*start_str));
+            start = std::move(*parsed);
+        }
+        if (const auto count_str{req->GetQueryParameter("count")}) {
+            const auto parsed_count{ToIntegral<size_t>(*count_str)};
+            if (!parsed_count.has_value() || *parsed_count < 1 || *parsed_count > MAX_REST_KEVA_NAMESPACE_RESULTS) {
+                return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Count must be in the range 1-%u: %s", MAX_REST_KEVA_NAMESPACE_RESULTS, SanitizeString(*count_str)));
+            }
+            count = *parsed_count;
+        }
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    ChainstateManager& chainman = *maybe_chainman;
+
+    // Iterate over a snapshot of the keva state, so that cs_main is not held
+    // while reading the database.
+    std::vector<std::pair<valtype, CKevaRestEntry>> entries;
+    valtype next;
+    const CBlockIndex* tip;
+    auto list_keys = [&](const CCoinsView& view) {
+        std::unique_ptr<CKevaIterator> iter{view.IterateKeys(nameSpace)};
+        iter->seek(start);
+        valtype key;
+        CKevaData data;
+        while (iter->next(key, data)) {
+            if (entries.size() == count) {
+                next = key;
+                break;
+            }
+            CKevaRestEntry entry;
+            entry.state = CKevaRestEntry::CONFIRMED;
+            entry.value = data.getValue();
+            entry.nHeight = data.getHeight();
+            entry.outpoint = data.getUpdateOutpoint();
+            entries.emplace_back(key, std::move(entry));
+        }
+    };
+    std::unique_ptr<CCoinsView> snapshot;
+    {
+        LOCK(cs_main);
+        tip = chainman.ActiveTip();
+        CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
+        snapshot = view.GetKevaSnapshot();
+        if (!snapshot) list_keys(view);
+    }
+    if (snapshot) list_keys(*snapshot);
+
+    // A deletion does not raise the height of any remaining entry, so the
+    // ETag also commits to the listed keys and outpoints.
+    uint32_t max_height{0};
+    HashWriter hasher{};
+    for (const auto& [key, entry] : entries) {
+        max_height = std::max(max_height, entry.nHeight);
+        hasher << key << entry.outpoint;
+    }
+    hasher << next;
+    const std::string etag{strprintf("\"%u-%s\"", max_height, hasher.GetSHA256().GetHex().substr(0, 16))};
+    if (KevaNotModified(req, etag, tip->GetAncestor(max_height)->GetBlockTime())) return true;
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        DataStream ssEntries{};
+        ssEntries << entries << next;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssEntries.str());
+        return true;
+    }
+
+    case RESTResponseFormat::HEX: {
+        DataStream ssEntries{};
+        ssEntries << entries << next;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ssEntries) + "\n");
+        return true;
+    }
+
+    case RESTResponseFormat::JSON: {
+        UniValue objResponse(UniValue::VOBJ);
+        UniValue arr(UniValue::VARR);
+        for (const auto& [key, entry] : entries) {
+            arr.push_back(KevaRestEntryToJSON(nameSpace, key, entry));
+        }
+        objResponse.pushKV("entries", arr);
+        if (!next.empty()) objResponse.pushKV("next", HexStr(next));
+
+        std::string strJSON = objResponse.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
                        const std::string& str_uri_part)
 {
@@ -1016,6 +1417,9 @@ static const struct {
       {"/rest/mempool/", rest_mempool},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/kevagetmulti", rest_kevagetmulti},
+      {"/rest/keva/", rest_keva},
+      {"/rest/kevanamespace/", rest_kevanamespace},
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
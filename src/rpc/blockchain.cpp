@@ -21,6 +21,7 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/kevastatsindex.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
@@ -57,9 +58,11 @@
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
+using kernel::CKevaStats;
 
 using node::BlockManager;
 using node::NodeContext;
+using node::SnapshotKevaWriter;
 using node::SnapshotMetadata;
 
 struct CUpdatedBlock
@@ -904,7 +907,7 @@ static RPCHelpMan gettxoutsetinfo()
                         {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at which these statistics are calculated"},
                         {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs"},
                         {RPCResult::Type::NUM, "bogosize", "Database-independent, meaningless metric indicating the UTXO set size"},
-                        {RPCResult::Type::STR_HEX, "hash_serialized_3", /*optional=*/true, "The serialized hash (only present if 'hash_serialized_3' hash_type is chosen)"},
+                        {RPCResult::Type::STR_HEX, "hash_serialized_3", /*optional=*/true, "The serialized hash, which also covers the keva entries and namespace associations if there are any (only present if 'hash_serialized_3' hash_type is chosen)"},
                         {RPCResult::Type::STR_HEX, "muhash", /*optional=*/true, "The serialized hash (only present if 'muhash' hash_type is chosen)"},
                         {RPCResult::Type::NUM, "transactions", /*optional=*/true, "The number of transactions with unspent outputs (not available when coinstatsindex is used)"},
                         {RPCResult::Type::NUM, "disk_size", /*optional=*/true, "The estimated size of the chainstate on disk (not available when coinstatsindex is used)"},
@@ -1038,6 +1041,83 @@ static RPCHelpMan gettxoutsetinfo()
     };
 }
 
+static RPCHelpMan getkevasetinfo()
+{
+    return RPCHelpMan{"getkevasetinfo",
+                "\nReturns the number of keva entries and the MuHash of all keva entries.\n"
+                "Namespace associations are derived from the entries and not included.\n"
+                "Note this call may take some time if you are not using kevastatsindex.\n"
+                "Calling it with use_index=false rescans the keva database, which can be used to check the index.\n",
+                {
+                    {"hash_or_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the current best block"}, "The block hash or height of the target height (only available with kevastatsindex).",
+                     RPCArgOptions{
+                         .skip_type_check = true,
+                         .type_str = {"", "string or numeric"},
+                     }},
+                    {"use_index", RPCArg::Type::BOOL, RPCArg::Default{true}, "Use kevastatsindex, if available."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "height", "The block height (index) of the returned statistics"},
+                        {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at which these statistics are calculated"},
+                        {RPCResult::Type::NUM, "keva_entries", "The number of keva entries"},
+                        {RPCResult::Type::STR_HEX, "muhash", "The MuHash of the keva entries"},
+                        {RPCResult::Type::BOOL, "index_used", "Whether kevastatsindex was used"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getkevasetinfo", "") +
+                    HelpExampleCli("getkevasetinfo", "1000") +
+                    HelpExampleCli("-named getkevasetinfo", "use_index=false") +
+                    HelpExampleRpc("getkevasetinfo", "") +
+                    HelpExampleRpc("getkevasetinfo", "1000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const bool index_requested = request.params[1].isNull() || request.params[1].get_bool();
+
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    Chainstate& active_chainstate = chainman.ActiveChainstate();
+
+    std::optional<CKevaStats> maybe_stats;
+    if (index_requested && g_keva_stats_index) {
+        const CBlockIndex* pindex{request.params[0].isNull()
+            ? WITH_LOCK(::cs_main, return active_chainstate.m_chain.Tip())
+            : ParseHashOrHeight(request.params[0], chainman)};
+        if (!g_keva_stats_index->BlockUntilSyncedToCurrentChain()) {
+            const IndexSummary summary{g_keva_stats_index->GetSummary()};
+
+            // If a specific block was requested and the index has already synced past that height, we can return the
+            // data already even though the index is not fully synced yet.
+            if (pindex->nHeight > summary.best_block_height) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Unable to get data because kevastatsindex is still syncing. Current height: %d", summary.best_block_height));
+            }
+        }
+        maybe_stats = g_keva_stats_index->LookUpStats(*pindex);
+    } else {
+        if (!request.params[0].isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires kevastatsindex");
+        }
+        active_chainstate.ForceFlushStateToDisk();
+        CCoinsView* coins_view = WITH_LOCK(::cs_main, return &active_chainstate.CoinsDB());
+        maybe_stats = kernel::ComputeKevaStats(coins_view, active_chainstate.m_blockman, node.rpc_interruption_point);
+    }
+
+    if (!maybe_stats) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read keva set");
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("height", maybe_stats->nHeight);
+    ret.pushKV("bestblock", maybe_stats->hashBlock.GetHex());
+    ret.pushKV("keva_entries", static_cast<int64_t>(maybe_stats->entries_count));
+    ret.pushKV("muhash", maybe_stats->muhash.GetHex());
+    ret.pushKV("index_used", maybe_stats->index_used);
+    return ret;
+},
+    };
+}
+
 static RPCHelpMan gettxout()
 {
     return RPCHelpMan{"gettxout",
@@ -2605,6 +2685,7 @@ static RPCHelpMan dumptxoutset()
             RPCResult::Type::OBJ, "", "",
                 {
                     {RPCResult::Type::NUM, "coins_written", "the number of coins written in the snapshot"},
+                    {RPCResult::Type::NUM, "keva_written", "the number of keva entries and namespace associations written in the snapshot"},
                     {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
@@ -2657,6 +2738,7 @@ UniValue CreateUTXOSnapshot(
     const fs::path& temppath)
 {
     std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<CKevaViewCursor> keva_cursor;
     std::optional<CCoinsStats> maybe_stats;
     const CBlockIndex* tip;
 
@@ -2683,6 +2765,7 @@ UniValue CreateUTXOSnapshot(
         }
 
         pcursor = chainstate.CoinsDB().Cursor();
+        keva_cursor = chainstate.CoinsDB().KevaCursor();
         tip = CHECK_NONFATAL(chainstate.m_blockman.LookupBlockIndex(maybe_stats->hashBlock));
     }
 
@@ -2709,10 +2792,30 @@ UniValue CreateUTXOSnapshot(
         pcursor->Next();
     }
 
+    if (maybe_stats->keva_count > 0) {
+        SnapshotKevaWriter keva_writer{afile, maybe_stats->keva_count};
+        uint64_t keva_written{0};
+        bool association;
+        valtype nameSpace;
+        valtype key;
+        CKevaData data;
+        for (; keva_cursor->Valid(); keva_cursor->Next()) {
+            if (keva_written % 5000 == 0) node.rpc_interruption_point();
+            if (keva_cursor->GetKey(association, nameSpace, key) && keva_cursor->GetValue(data)) {
+                keva_writer.Write(association, nameSpace, key, data);
+                ++keva_written;
+            }
+        }
+        if (keva_written != maybe_stats->keva_count) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read keva state");
+        }
+    }
+
     afile.fclose();
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("coins_written", maybe_stats->coins_count);
+    result.pushKV("keva_written", maybe_stats->keva_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
     result.pushKV("path", path.utf8string());
@@ -2889,6 +2992,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &getdeploymentinfo},
         {"blockchain", &gettxout},
         {"blockchain", &gettxoutsetinfo},
+        {"blockchain", &getkevasetinfo},
         {"blockchain", &pruneblockchain},
         {"blockchain", &verifychain},
         {"blockchain", &preciousblock},
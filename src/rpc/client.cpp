@@ -75,6 +75,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listtransactions", 3, "include_watchonly" },
     { "walletpassphrase", 1, "timeout" },
     { "getblocktemplate", 0, "template_request" },
+    { "submitcryptonoteblock", 1, "nonce" },
     { "listsinceblock", 1, "target_confirmations" },
     { "listsinceblock", 2, "include_watchonly" },
     { "listsinceblock", 3, "include_removed" },
@@ -185,6 +186,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "gettxoutproof", 0, "txids" },
     { "gettxoutsetinfo", 1, "hash_or_height" },
     { "gettxoutsetinfo", 2, "use_index"},
+    { "getkevasetinfo", 0, "hash_or_height" },
+    { "getkevasetinfo", 1, "use_index"},
     { "lockunspent", 0, "unlock" },
     { "lockunspent", 1, "transactions" },
     { "lockunspent", 2, "persistent" },
@@ -321,6 +324,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "keva_group_filter", 3, "maxage"},
     { "keva_group_filter", 4, "from"},
     { "keva_group_filter", 5, "nb"},
+    { "keva_history", 2, "count"},
+    { "keva_get_multi", 0, "names"},
+    { "keva_recent", 0, "maxage"},
+    { "keva_recent", 1, "nb"},
 };
 // clang-format on
 
@@ -41,11 +41,15 @@
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <stdint.h>
 
 using node::BlockAssembler;
 using node::CBlockTemplate;
+using node::CryptoNoteBlockTemplate;
 using node::NodeContext;
 using node::RegenerateCommitments;
 using node::UpdateTime;
@@ -560,11 +564,227 @@ static std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+namespace {
+//! A cached CryptoNote template is rebuilt for mempool changes at most this often,
+constexpr auto CN_TEMPLATE_MIN_AGE{5s};
+//! and only once the mempool fees changed by CN_TEMPLATE_FEE_DELTA or it is older than CN_TEMPLATE_MAX_AGE.
+constexpr CAmount CN_TEMPLATE_FEE_DELTA{COIN / 100};
+constexpr auto CN_TEMPLATE_MAX_AGE{60s};
+//! Number of recent templates that submitcryptonoteblock accepts solutions for.
+constexpr size_t MAX_CN_TEMPLATES{16};
+//! Number of payout scripts and reserve sizes that a current template is kept for.
+constexpr size_t MAX_CN_TEMPLATE_KEYS{8};
+
+/** A CryptoNote template together with its getblocktemplate reply. */
+struct CachedCryptoNoteTemplate {
+    CryptoNoteBlockTemplate tmpl;
+    UniValue result;
+};
+
+/** The current template for one payout script and reserve size. */
+struct CurrentCryptoNoteTemplate {
+    uint64_t id{0};
+    uint256 prev_hash;
+    unsigned int txs_updated{0};
+    CAmount mempool_fee{0};
+    SteadyClock::time_point time_built;
+};
+
+/**
+ * The CryptoNote templates handed out by getblocktemplate.  Pools poll for
+ * work several times per second, so the current template of a payout script
+ * and reserve size is only rebuilt when the tip changes or the mempool fees
+ * changed noticeably; other requests are answered from the cache without
+ * taking cs_main.
+ */
+struct CryptoNoteTemplateCache {
+    Mutex cs;
+    //! Recent templates by id, for all payout scripts and reserve sizes.
+    std::map<uint64_t, std::shared_ptr<const CachedCryptoNoteTemplate>> templates GUARDED_BY(cs);
+    //! The current template by payout script and reserve size.
+    std::map<std::pair<CScript, size_t>, CurrentCryptoNoteTemplate> current GUARDED_BY(cs);
+    //! Ids are taken before building, so that templates can be built without holding cs.
+    std::atomic<uint64_t> last_id{0};
+};
+
+CryptoNoteTemplateCache g_cn_templates;
+} // namespace
+
+static std::string CryptoNoteHashingBlob(const CBlockHeader& header)
+{
+    unsigned char blob[CryptoNoteHeader::MAX_BLOB_SIZE];
+    return HexStr(Span{blob, header.cnHeader.WriteBlob(blob)});
+}
+
+/**
+ * Build the CryptoNote template with id current.id and its getblocktemplate
+ * reply on the current tip.  Sets the tip and the mempool fee the template was
+ * built at in current.
+ */
+static std::shared_ptr<const CachedCryptoNoteTemplate> BuildCryptoNoteTemplate(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& script,
+                                                                               size_t reserve_size, CurrentCryptoNoteTemplate& current)
+{
+    LOCK(cs_main);
+    const CBlockIndex* tip{chainman.ActiveChain().Tip()};
+    current.mempool_fee = WITH_LOCK(mempool.cs, return mempool.GetTotalFee());
+    std::unique_ptr<CBlockTemplate> block_template{BlockAssembler{chainman.ActiveChainstate(), &mempool}.CreateNewBlock(script)};
+    if (!block_template) {
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    }
+
+    const int height{tip->nHeight + 1};
+    auto entry{std::make_shared<CachedCryptoNoteTemplate>()};
+    entry->tmpl = node::MakeCryptoNoteTemplate(std::move(block_template->block), height, chainman.GetConsensus(), reserve_size);
+    const CBlock& block = entry->tmpl.block;
+
+    DataStream ss;
+    ss << TX_WITH_WITNESS(block);
+    UniValue merkle_branch(UniValue::VARR);
+    for (const uint256& hash : entry->tmpl.merkle_branch) {
+        merkle_branch.push_back(HexStr(hash));
+    }
+
+    UniValue& result = entry->result;
+    result = UniValue(UniValue::VOBJ);
+    result.pushKV("templateid", ToString(current.id));
+    result.pushKV("blocktemplate_blob", HexStr(ss));
+    result.pushKV("blockhashing_blob", CryptoNoteHashingBlob(block));
+    result.pushKV("reserved_offset", (uint64_t)entry->tmpl.reserved_offset);
+    result.pushKV("reserve_size", (uint64_t)reserve_size);
+    result.pushKV("merkle_branch", merkle_branch);
+    result.pushKV("height", height);
+    result.pushKV("prev_hash", tip->GetBlockHash().GetHex());
+    result.pushKV("target", arith_uint256().SetCompact(block.nBits).GetHex());
+    result.pushKV("bits", strprintf("%08x", block.nBits));
+    result.pushKV("curtime", block.GetBlockTime());
+    result.pushKV("expected_reward", block.vtx[0]->vout[0].nValue);
+    if (block.cnHeader.major_version >= RX_BLOCK_VERSION) {
+        // The seed hash in the byte order RandomX is keyed with, see GetPoWHash.
+        uint64_t seed_height, next_seed_height;
+        crypto::rx_seedheights(height, &seed_height, &next_seed_height);
+        result.pushKV("seed_height", seed_height);
+        result.pushKV("seed_hash", CHECK_NONFATAL(tip->GetAncestor(seed_height))->GetBlockHash().GetHex());
+        if (next_seed_height != seed_height) {
+            result.pushKV("next_seed_hash", CHECK_NONFATAL(tip->GetAncestor(next_seed_height))->GetBlockHash().GetHex());
+        }
+    }
+
+    current.prev_hash = tip->GetBlockHash();
+    return entry;
+}
+
+static std::shared_ptr<const CachedCryptoNoteTemplate> GetCryptoNoteTemplate(ChainstateManager& chainman, const CTxMemPool& mempool, const CScript& script, size_t reserve_size)
+{
+    CryptoNoteTemplateCache& cache = g_cn_templates;
+    const std::pair<CScript, size_t> key{script, reserve_size};
+
+    uint256 best_block{WITH_LOCK(g_best_block_mutex, return g_best_block)};
+    if (best_block.IsNull()) {
+        // No block was connected since startup.
+        best_block = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip()->GetBlockHash());
+    }
+    const unsigned int txs_updated{mempool.GetTransactionsUpdated()};
+    const auto now{SteadyClock::now()};
+    {
+        LOCK(cache.cs);
+        const auto it{cache.current.find(key)};
+        if (it != cache.current.end() && it->second.prev_hash == best_block) {
+            const CurrentCryptoNoteTemplate& current{it->second};
+            const auto& entry{cache.templates.at(current.id)};
+            if (txs_updated == current.txs_updated || now - current.time_built < CN_TEMPLATE_MIN_AGE) {
+                return entry;
+            }
+            const CAmount fee_delta{WITH_LOCK(mempool.cs, return mempool.GetTotalFee()) - current.mempool_fee};
+            if (std::abs(fee_delta) < CN_TEMPLATE_FEE_DELTA && now - current.time_built < CN_TEMPLATE_MAX_AGE) {
+                return entry;
+            }
+        }
+    }
+
+    // Build the new template without holding cache.cs, so that requests for
+    // other payout scripts are still answered from the cache meanwhile.
+    CurrentCryptoNoteTemplate built{.id = ++cache.last_id, .txs_updated = txs_updated, .time_built = now};
+    auto entry{BuildCryptoNoteTemplate(chainman, mempool, script, reserve_size, built)};
+
+    // Publish the template.  A concurrent request may have built a newer one
+    // for the same key meanwhile, which then stays the current template.
+    LOCK(cache.cs);
+    cache.templates.emplace(built.id, entry);
+    CurrentCryptoNoteTemplate& current{cache.current[key]};
+    if (current.id < built.id) {
+        current = built;
+    }
+    if (cache.current.size() > MAX_CN_TEMPLATE_KEYS) {
+        cache.current.erase(std::min_element(cache.current.begin(), cache.current.end(), [](const auto& a, const auto& b) {
+            return a.second.time_built < b.second.time_built;
+        }));
+    }
+    // Keep the current templates, and the most recent others for submission.
+    for (auto it{cache.templates.begin()}; it != cache.templates.end() && cache.templates.size() > MAX_CN_TEMPLATES;) {
+        const bool is_current{std::any_of(cache.current.begin(), cache.current.end(), [&](const auto& c) { return c.second.id == it->first; })};
+        it = is_current ? std::next(it) : cache.templates.erase(it);
+    }
+    return entry;
+}
+
+/** getblocktemplate in mode "cryptonote" */
+static UniValue CryptoNoteBlockTemplateResult(NodeContext& node, const UniValue& oparam)
+{
+    ChainstateManager& chainman = EnsureChainman(node);
+    const CTxMemPool& mempool = EnsureMemPool(node);
+
+    const UniValue& address = oparam.find_value("address");
+    if (!address.isStr()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Missing address for mode=\"cryptonote\"");
+    }
+    const CTxDestination destination{DecodeDestination(address.get_str())};
+    if (!IsValidDestination(destination)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Error: Invalid address");
+    }
+    size_t reserve_size{node::DEFAULT_CN_RESERVE_SIZE};
+    if (const UniValue& reserve = oparam.find_value("reserve_size"); !reserve.isNull()) {
+        const int64_t size{reserve.getInt<int64_t>()};
+        if (size < 0 || size > int64_t(node::MAX_CN_RESERVE_SIZE)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("reserve_size must be between 0 and %u", node::MAX_CN_RESERVE_SIZE));
+        }
+        reserve_size = size;
+    }
+    std::vector<unsigned char> extra_nonce;
+    if (!oparam.find_value("extranonce").isNull()) {
+        extra_nonce = ParseHexO(oparam, "extranonce");
+        if (extra_nonce.size() > reserve_size) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "extranonce is longer than reserve_size");
+        }
+    }
+
+    if (!chainman.GetParams().IsTestChain()) {
+        const CConnman& connman = EnsureConnman(node);
+        if (connman.GetNodeCount(ConnectionDirection::Both) == 0) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, PACKAGE_NAME " is not connected!");
+        }
+
+        if (chainman.IsInitialBlockDownload()) {
+            throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, PACKAGE_NAME " is in initial sync and waiting for blocks...");
+        }
+    }
+
+    const auto entry{GetCryptoNoteTemplate(chainman, mempool, GetScriptForDestination(destination), reserve_size)};
+    UniValue result{entry->result};
+    if (!extra_nonce.empty()) {
+        CBlock block{entry->tmpl.block};
+        node::SetCryptoNoteNonce(entry->tmpl, block, extra_nonce, 0);
+        result.pushKV("blockhashing_blob", CryptoNoteHashingBlob(block));
+    }
+    return result;
+}
+
 static RPCHelpMan getblocktemplate()
 {
     return RPCHelpMan{"getblocktemplate",
         "\nIf the request parameters include a 'mode' key, that is used to explicitly select between the default 'template' request or a 'proposal'.\n"
         "It returns data needed to construct a block to work on.\n"
+        "With mode \"cryptonote\", a template for CryptoNote pool software is returned instead, whose solutions are\n"
+        "submitted with submitcryptonoteblock.\n"
         "For full specification, see BIPs 22, 23, 9, and 145:\n"
         "    https://github.com/bitcoin/bips/blob/master/bip-0022.mediawiki\n"
         "    https://github.com/bitcoin/bips/blob/master/bip-0023.mediawiki\n"
@@ -573,7 +793,7 @@ static RPCHelpMan getblocktemplate()
         {
             {"template_request", RPCArg::Type::OBJ, RPCArg::Optional::NO, "Format of the template",
             {
-                {"mode", RPCArg::Type::STR, /* treat as named arg */ RPCArg::Optional::OMITTED, "This must be set to \"template\", \"proposal\" (see BIP 23), or omitted"},
+                {"mode", RPCArg::Type::STR, /* treat as named arg */ RPCArg::Optional::OMITTED, "This must be set to \"template\", \"proposal\" (see BIP 23), \"cryptonote\", or omitted"},
                 {"capabilities", RPCArg::Type::ARR, /* treat as named arg */ RPCArg::Optional::OMITTED, "A list of strings",
                 {
                     {"str", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "client side supported feature, 'longpoll', 'coinbasevalue', 'proposal', 'serverlist', 'workid'"},
@@ -585,12 +805,36 @@ static RPCHelpMan getblocktemplate()
                 }},
                 {"longpollid", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "delay processing request until the result would vary significantly from the \"longpollid\" of a prior template"},
                 {"data", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "proposed block data to check, encoded in hexadecimal; valid only for mode=\"proposal\""},
+                {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "the address to send the block reward to; required for mode=\"cryptonote\""},
+                {"reserve_size", RPCArg::Type::NUM, RPCArg::DefaultHint{strprintf("%u", node::DEFAULT_CN_RESERVE_SIZE)}, strprintf("number of extra nonce bytes to reserve in the coinbase (at most %u); valid only for mode=\"cryptonote\"", node::MAX_CN_RESERVE_SIZE)},
+                {"extranonce", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "extra nonce to return the blockhashing_blob for, zero padded to reserve_size; valid only for mode=\"cryptonote\""},
             },
             },
         },
         {
             RPCResult{"If the proposal was accepted with mode=='proposal'", RPCResult::Type::NONE, "", ""},
             RPCResult{"If the proposal was not accepted with mode=='proposal'", RPCResult::Type::STR, "", "According to BIP22"},
+            RPCResult{"With mode=='cryptonote'", RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR, "templateid", "The id to pass to submitcryptonoteblock"},
+                {RPCResult::Type::STR_HEX, "blocktemplate_blob", "The serialized block, with a zero extra nonce"},
+                {RPCResult::Type::STR_HEX, "blockhashing_blob", "The CryptoNote header blob to hash, for the requested (or zero) extra nonce"},
+                {RPCResult::Type::NUM, "reserved_offset", "Offset of the extra nonce in blocktemplate_blob"},
+                {RPCResult::Type::NUM, "reserve_size", "Number of extra nonce bytes"},
+                {RPCResult::Type::ARR, "merkle_branch", "The merkle branch of the coinbase transaction",
+                {
+                    {RPCResult::Type::STR_HEX, "", "hash in internal byte order"},
+                }},
+                {RPCResult::Type::NUM, "height", "The height of the next block"},
+                {RPCResult::Type::STR_HEX, "prev_hash", "The hash of current highest block"},
+                {RPCResult::Type::STR_HEX, "target", "The hash target"},
+                {RPCResult::Type::STR, "bits", "compressed target of next block"},
+                {RPCResult::Type::NUM_TIME, "curtime", "The block timestamp in " + UNIX_EPOCH_TIME},
+                {RPCResult::Type::NUM, "expected_reward", "The block reward including transaction fees (in satoshis)"},
+                {RPCResult::Type::NUM, "seed_height", /*optional=*/true, "The height of the RandomX seed block"},
+                {RPCResult::Type::STR_HEX, "seed_hash", /*optional=*/true, "The RandomX seed hash"},
+                {RPCResult::Type::STR_HEX, "next_seed_hash", /*optional=*/true, "The RandomX seed hash of the next epoch, if it starts within the next blocks"},
+            }},
             RPCResult{"Otherwise", RPCResult::Type::OBJ, "", "",
             {
                 {RPCResult::Type::NUM, "version", "The preferred block version"},
@@ -655,6 +899,13 @@ static RPCHelpMan getblocktemplate()
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
+    if (!request.params[0].isNull()) {
+        const UniValue& oparam = request.params[0].get_obj();
+        const UniValue& modeval = oparam.find_value("mode");
+        if (modeval.isStr() && modeval.get_str() == "cryptonote") {
+            return CryptoNoteBlockTemplateResult(node, oparam);
+        }
+    }
     LOCK(cs_main);
 
     std::string strMode = "template";
@@ -987,37 +1238,9 @@ protected:
     }
 };
 
-static RPCHelpMan submitblock()
-{
-    // We allow 2 arguments for compliance with BIP22. Argument 2 is ignored.
-    return RPCHelpMan{"submitblock",
-        "\nAttempts to submit new block to network.\n"
-        "See https://en.bitcoin.it/wiki/BIP_0022 for full specification.\n",
-        {
-            {"hexdata", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded block data to submit"},
-            {"dummy", RPCArg::Type::STR, RPCArg::DefaultHint{"ignored"}, "dummy value, for compatibility with BIP22. This value is ignored."},
-        },
-        {
-            RPCResult{"If the block was accepted", RPCResult::Type::NONE, "", ""},
-            RPCResult{"Otherwise", RPCResult::Type::STR, "", "According to BIP22"},
-        },
-        RPCExamples{
-                    HelpExampleCli("submitblock", "\"mydata\"")
-            + HelpExampleRpc("submitblock", "\"mydata\"")
-                },
-        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+static UniValue ProcessSubmittedBlock(ChainstateManager& chainman, const std::shared_ptr<CBlock>& blockptr)
 {
-    std::shared_ptr<CBlock> blockptr = std::make_shared<CBlock>();
     CBlock& block = *blockptr;
-    if (!DecodeHexBlk(block, request.params[0].get_str())) {
-        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block decode failed");
-    }
-
-    if (block.vtx.empty() || !block.vtx[0]->IsCoinBase()) {
-        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block does not start with a coinbase");
-    }
-
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
     uint256 hash = block.GetHash();
     {
         LOCK(cs_main);
@@ -1052,6 +1275,85 @@ static RPCHelpMan submitblock()
         return "inconclusive";
     }
     return BIP22ValidationResult(sc->state);
+}
+
+static RPCHelpMan submitblock()
+{
+    // We allow 2 arguments for compliance with BIP22. Argument 2 is ignored.
+    return RPCHelpMan{"submitblock",
+        "\nAttempts to submit new block to network.\n"
+        "See https://en.bitcoin.it/wiki/BIP_0022 for full specification.\n",
+        {
+            {"hexdata", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded block data to submit"},
+            {"dummy", RPCArg::Type::STR, RPCArg::DefaultHint{"ignored"}, "dummy value, for compatibility with BIP22. This value is ignored."},
+        },
+        {
+            RPCResult{"If the block was accepted", RPCResult::Type::NONE, "", ""},
+            RPCResult{"Otherwise", RPCResult::Type::STR, "", "According to BIP22"},
+        },
+        RPCExamples{
+                    HelpExampleCli("submitblock", "\"mydata\"")
+            + HelpExampleRpc("submitblock", "\"mydata\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::shared_ptr<CBlock> blockptr = std::make_shared<CBlock>();
+    CBlock& block = *blockptr;
+    if (!DecodeHexBlk(block, request.params[0].get_str())) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block decode failed");
+    }
+
+    if (block.vtx.empty() || !block.vtx[0]->IsCoinBase()) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block does not start with a coinbase");
+    }
+
+    return ProcessSubmittedBlock(EnsureAnyChainman(request.context), blockptr);
+},
+    };
+}
+
+static RPCHelpMan submitcryptonoteblock()
+{
+    return RPCHelpMan{"submitcryptonoteblock",
+        "\nAttempts to submit a solution for a template returned by getblocktemplate with mode \"cryptonote\".\n",
+        {
+            {"templateid", RPCArg::Type::STR, RPCArg::Optional::NO, "the templateid of the template"},
+            {"nonce", RPCArg::Type::NUM, RPCArg::Optional::NO, "the nonce of the CryptoNote header"},
+            {"extranonce", RPCArg::Type::STR_HEX, RPCArg::Default{""}, "the extra nonce, zero padded to the reserve_size of the template"},
+        },
+        {
+            RPCResult{"If the block was accepted", RPCResult::Type::NONE, "", ""},
+            RPCResult{"Otherwise", RPCResult::Type::STR, "", "According to BIP22"},
+        },
+        RPCExamples{
+                    HelpExampleCli("submitcryptonoteblock", "\"12\" 3735928559 \"0000000100000002\"")
+            + HelpExampleRpc("submitcryptonoteblock", "\"12\", 3735928559, \"0000000100000002\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const auto id{ToIntegral<uint64_t>(request.params[0].get_str())};
+    const int64_t nonce{request.params[1].getInt<int64_t>()};
+    if (nonce < 0 || nonce > std::numeric_limits<uint32_t>::max()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "nonce out of range");
+    }
+    const std::vector<unsigned char> extra_nonce{request.params[2].isNull() ? std::vector<unsigned char>{} : ParseHexV(request.params[2], "extranonce")};
+
+    std::shared_ptr<const CachedCryptoNoteTemplate> entry;
+    if (id) {
+        LOCK(g_cn_templates.cs);
+        const auto it{g_cn_templates.templates.find(*id)};
+        if (it != g_cn_templates.templates.end()) entry = it->second;
+    }
+    if (!entry) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown or expired templateid");
+    }
+    if (extra_nonce.size() > entry->tmpl.reserve_size) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "extranonce is longer than the reserve_size of the template");
+    }
+
+    auto blockptr{std::make_shared<CBlock>(entry->tmpl.block)};
+    node::SetCryptoNoteNonce(entry->tmpl, *blockptr, extra_nonce, nonce);
+    return ProcessSubmittedBlock(EnsureAnyChainman(request.context), blockptr);
 },
     };
 }
@@ -1104,6 +1406,7 @@ void RegisterMiningRPCCommands(CRPCTable& t)
         {"mining", &getprioritisedtransactions},
         {"mining", &getblocktemplate},
         {"mining", &submitblock},
+        {"mining", &submitcryptonoteblock},
         {"mining", &submitheader},
 
         {"hidden", &generatetoaddress},
@@ -11,6 +11,8 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/kevahistoryindex.h>
+#include <index/kevastatsindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/echo.h>
@@ -26,6 +28,7 @@
 #include <univalue.h>
 #include <util/any.h>
 #include <util/check.h>
+#include <validation.h>
 
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
@@ -117,6 +120,17 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCChainstateMemoryInfo(ChainstateManager& chainman)
+{
+    LOCK(::cs_main);
+    const CCoinsViewCache& coins_tip = chainman.ActiveChainstate().CoinsTip();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("coins_tip", uint64_t(coins_tip.DynamicMemoryUsage()));
+    obj.pushKV("keva_changes", uint64_t(coins_tip.KevaChangesMemoryUsage()));
+    obj.pushKV("keva_read_cache", uint64_t(coins_tip.KevaCacheMemoryUsage()));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -161,6 +175,12 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "chainstate", /*optional=*/true, "Information about the in-memory chainstate caches",
+                            {
+                                {RPCResult::Type::NUM, "coins_tip", "Number of bytes used by the coins cache, including pending keva changes"},
+                                {RPCResult::Type::NUM, "keva_changes", "Number of bytes used by keva changes not yet flushed to disk"},
+                                {RPCResult::Type::NUM, "keva_read_cache", "Number of bytes used by the keva read cache (see -kevacache)"},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -177,6 +197,10 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        const NodeContext& node = EnsureAnyNodeContext(request.context);
+        if (node.chainman) {
+            obj.pushKV("chainstate", RPCChainstateMemoryInfo(*node.chainman));
+        }
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -391,6 +415,14 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_keva_history_index) {
+        result.pushKVs(SummaryToJSON(g_keva_history_index->GetSummary(), index_name));
+    }
+
+    if (g_keva_stats_index) {
+        result.pushKVs(SummaryToJSON(g_keva_stats_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
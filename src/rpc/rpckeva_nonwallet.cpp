@@ -7,7 +7,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <base58.h>
+#include <chain.h>
 #include <coins.h>
+#include <crypto/common.h>
+#include <index/kevahistoryindex.h>
 #include <init.h>
 #include <keva/common.h>
 #include <keva/main.h>
@@ -21,13 +24,17 @@
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <script/keva.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <univalue.h>
 // #include <util.h>
+#include <util/strencodings.h>
 #include <validation.h>
 // #include "utilstrencodings.h"
 #include <boost/xpressive/xpressive_dynamic.hpp>
 
+#include <algorithm>
+
 using node::NodeContext;
 
 /**
@@ -67,6 +74,121 @@ UniValue getKevaInfo(const valtype& key, const CKevaData& data, const valtype& n
                         data.getHeight(), nameSpace);
 }
 
+/**
+ * Key iterator over a list of keys and their data that was looked up
+ * beforehand.  The entries must be sorted in database order.
+ */
+class CKevaListIterator : public CKevaIterator
+{
+private:
+    std::vector<std::pair<valtype, CKevaData>> entries;
+    std::vector<std::pair<valtype, CKevaData>>::const_iterator pos;
+
+public:
+    CKevaListIterator(const valtype& ns, std::vector<std::pair<valtype, CKevaData>> e)
+        : CKevaIterator(ns), entries(std::move(e)), pos(entries.begin())
+    {}
+
+    /* Order of the keys of a namespace in the database.  */
+    static bool keyLess(const valtype& a, const valtype& b)
+    {
+        if (a.size() != b.size())
+            return a.size() < b.size();
+        return a < b;
+    }
+
+    void seek(const valtype& start) override
+    {
+        pos = std::lower_bound(entries.cbegin(), entries.cend(), start,
+                               [](const std::pair<valtype, CKevaData>& entry, const valtype& key) {
+                                   return keyLess(entry.first, key);
+                               });
+    }
+
+    bool next(valtype& key, CKevaData& data) override
+    {
+        if (pos == entries.cend())
+            return false;
+        key = pos->first;
+        data = pos->second;
+        ++pos;
+        return true;
+    }
+};
+
+/**
+ * Iterate over the keys of a namespace that were updated in the last maxage
+ * blocks, in the same order as IterateKeys.  If the view has a height
+ * index, only the recently updated keys are looked up instead of scanning
+ * the whole namespace.  With maxage zero, all keys are returned.
+ */
+static CKevaIterator* IterateRecentKeys(const CCoinsView& view, const valtype& nameSpace, int height, int maxage)
+{
+    if (maxage == 0 || maxage > height) {
+        return view.IterateKeys(nameSpace);
+    }
+
+    std::set<valtype> keys;
+    if (!view.GetKeysSinceHeight(nameSpace, height - maxage + 1, keys)) {
+        return view.IterateKeys(nameSpace);
+    }
+
+    std::vector<std::pair<valtype, CKevaData>> entries;
+    entries.reserve(keys.size());
+    for (const valtype& key : keys) {
+        CKevaData data;
+        if (view.GetName(nameSpace, key, data)) {
+            entries.emplace_back(key, std::move(data));
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return CKevaListIterator::keyLess(a.first, b.first);
+    });
+    return new CKevaListIterator(nameSpace, std::move(entries));
+}
+
+/**
+ * Take a snapshot of the confirmed keva state, so that scans can run on it
+ * without holding cs_main, and thus without stalling block connection.
+ */
+static std::unique_ptr<CCoinsView> GetKevaSnapshot(ChainstateManager& chainman) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    std::unique_ptr<CCoinsView> snapshot = chainman.ActiveChainstate().CoinsTip().GetKevaSnapshot();
+    CHECK_NONFATAL(snapshot != nullptr);
+    return snapshot;
+}
+
+/**
+ * Read the confirmed keva state: from the snapshot if one was taken to build
+ * a namespace group, otherwise from the chain tip under cs_main.
+ */
+template<typename Fn>
+static auto WithKevaView(ChainstateManager& chainman, const std::unique_ptr<CCoinsView>& snapshot, Fn&& fn)
+{
+    if (snapshot) {
+        return fn(static_cast<const CCoinsView&>(*snapshot));
+    }
+    LOCK(cs_main);
+    return fn(static_cast<const CCoinsView&>(chainman.ActiveChainstate().CoinsTip()));
+}
+
+/**
+ * Build the group of a namespace that was not cached, from a snapshot taken
+ * at the given best block.  This runs without cs_main; the group is only
+ * added to the cache if the chainstate is still at that block, since the
+ * cache does not track changes to groups it did not hold yet.
+ */
+static CKevaGroup LoadNamespaceGroup(ChainstateManager& chainman, const CCoinsView& snapshot,
+                                     const uint256& bestBlock, const valtype& nameSpace)
+{
+    CKevaGroup group = BuildNamespaceGroup(snapshot, nameSpace);
+    LOCK(cs_main);
+    const CCoinsViewCache& tip = chainman.ActiveChainstate().CoinsTip();
+    if (tip.GetBestBlock() == bestBlock)
+        tip.CacheNamespaceGroup(nameSpace, group);
+    return group;
+}
+
 static RPCHelpMan keva_get()
 {
     return RPCHelpMan{"keva_get",
@@ -144,42 +266,112 @@ static RPCHelpMan keva_get()
     };
 }
 
-enum InitiatorType : int
+static RPCHelpMan keva_get_multi()
 {
-    INITIATOR_TYPE_ALL,
-    INITIATOR_TYPE_SELF,
-    INITIATOR_TYPE_OTHER
-};
+    return RPCHelpMan{"keva_get_multi",
+        "\nGet the values of many keys at once, in the order they are given.\n"
+        "This is faster than separate keva_get calls, as the mempool and the chain state are only locked once.\n",
+        {
+            {"names", RPCArg::Type::ARR, RPCArg::Optional::NO, strprintf("The keys to look up (at most %u)", MAX_KEVA_LOOKUP_NAMES),
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"namespace", RPCArg::Type::STR, RPCArg::Optional::NO, "The namespace Id"},
+                            {"key", RPCArg::Type::STR, RPCArg::Optional::NO, "The key"},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{RPCResult::Type::ARR, "", "",
+        {
+            {RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR, "namespace", "The namespace Id."},
+                {RPCResult::Type::STR, "key", "The key."},
+                {RPCResult::Type::STR, "value", "The value associated with the key (empty if it does not exist)."},
+                {RPCResult::Type::STR_HEX, "txid", /*optional=*/true, "The transaction of the last confirmed update."},
+                {RPCResult::Type::NUM, "vout", /*optional=*/true, "The output of the last confirmed update."},
+                {RPCResult::Type::NUM, "height", /*optional=*/true, "The height of the last update, -1 if it is unconfirmed."},
+            }},
+        }},
+        RPCExamples{
+                HelpExampleCli("keva_get_multi", "'[{\"namespace\":\"namespace_id\",\"key\":\"key1\"},{\"namespace\":\"namespace_id\",\"key\":\"key2\"}]'")
+            + HelpExampleRpc("keva_get_multi", "[{\"namespace\":\"namespace_id\",\"key\":\"key1\"},{\"namespace\":\"namespace_id\",\"key\":\"key2\"}]")
+            },
+    [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    const CTxMemPool& mempool = EnsureMemPool(node);
 
+    const UniValue& params = request.params[0].get_array();
+    if (params.size() > MAX_KEVA_LOOKUP_NAMES) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("too many keys (max: %u)", MAX_KEVA_LOOKUP_NAMES));
+    }
 
-// Check if the key has the format _g:NamespaceId. If yes,
-// return the namespace.
-bool isNamespaceGroup(const valtype& key, valtype& targetNS)
-{
-    std::string keyStr = ValtypeToString(key);
-    if (keyStr.rfind(CKevaData::ASSOCIATE_PREFIX, 0) != 0) {
-        return false;
+    std::vector<CKevaCache::NamespaceKeyType> names;
+    names.reserve(params.size());
+    for (const UniValue& param : params.getValues()) {
+        RPCTypeCheckObj(param, {
+            {"namespace", UniValueType(UniValue::VSTR)},
+            {"key", UniValueType(UniValue::VSTR)},
+        });
+        valtype nameSpace;
+        if (!DecodeKevaNamespace(param.find_value("namespace").get_str(), Params(), nameSpace)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid namespace id");
+        }
+        if (nameSpace.size() > MAX_NAMESPACE_LENGTH)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "the namespace is too long");
+        valtype key = ValtypeFromString(param.find_value("key").get_str());
+        if (key.size() > MAX_KEY_LENGTH)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "the key is too long");
+        names.emplace_back(std::move(nameSpace), std::move(key));
     }
-    keyStr.erase(0, CKevaData::ASSOCIATE_PREFIX.length());
-    if (!DecodeKevaNamespace(keyStr, Params(), targetNS)) {
-        return false;
+
+    int height;
+    uint256 tipHash;
+    const std::vector<CKevaLookup> lookups = LookupKevaEntries(chainman, &mempool, names, height, tipHash);
+
+    UniValue res(UniValue::VARR);
+    for (size_t i = 0; i < names.size(); ++i) {
+        const auto& [nameSpace, key] = names[i];
+        const CKevaLookup& lookup = lookups[i];
+        if (lookup.confirmed) {
+            res.push_back(getKevaInfo(key, *lookup.confirmed, nameSpace));
+            continue;
+        }
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("key", ValtypeToString(key));
+        obj.pushKV("value", lookup.unconfirmed ? ValtypeToString(*lookup.unconfirmed) : "");
+        if (lookup.unconfirmed)
+            obj.pushKV("height", -1);
+        obj.pushKV("namespace", EncodeBase58Check(nameSpace));
+        res.push_back(obj);
     }
-    return true;
+    return res;
+},
+    };
 }
 
-void getNamespaceGroup(const valtype& nameSpace, std::set<valtype>& namespaces, const InitiatorType type, CCoinsViewCache& view, CTxMemPool& mempool)
+enum InitiatorType : int
 {
-    CKevaData data;
+    INITIATOR_TYPE_ALL,
+    INITIATOR_TYPE_SELF,
+    INITIATOR_TYPE_OTHER
+};
+
 
-    // NodeContext& node = EnsureAnyNodeContext(request.context);
-    // ChainstateManager& chainman = EnsureChainman(node);
-    // CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
-    // CTxMemPool& mempool = EnsureMemPool(node);
+/**
+ * Collect the namespace group of a namespace from its cached adjacency and
+ * the pending group changes in the mempool.  This only looks at the group
+ * keys and members, not at the other keys of the namespace.
+ */
+void getNamespaceGroup(const valtype& nameSpace, std::set<valtype>& namespaces, const InitiatorType type, const CKevaGroup& group, const CTxMemPool& mempool)
+{
     // Find the namespace connection initialized by others.
     if (type == INITIATOR_TYPE_ALL || type == INITIATOR_TYPE_OTHER) {
-        valtype ns;
-        std::unique_ptr<CKevaIterator> iter(view.IterateAssociatedNamespaces(nameSpace));
-        while (iter->next(ns, data)) {
+        for (const auto& [ns, data] : group.members) {
             namespaces.insert(ns);
         }
     }
@@ -189,52 +381,25 @@ void getNamespaceGroup(const valtype& nameSpace, std::set<valtype>& namespaces,
     }
 
     // Find the namespace connection initialized by us, and not confirmed yet.
-    {
-        // LOCK (mempool.cs);
-        std::vector<std::tuple<valtype, valtype, valtype, uint256>> unconfirmedKeyValueList;
-        mempool.getUnconfirmedKeyValueList(unconfirmedKeyValueList, nameSpace);
-        std::set<valtype> nsList;
-        valtype targetNS;
-        for (auto entry: unconfirmedKeyValueList) {
-            const valtype ns = std::get<0>(entry);
-            if (ns != nameSpace) {
-                continue;
-            }
-            const valtype key = std::get<1>(entry);
-            // Find the value with the format _g:NamespaceId
-            if (!isNamespaceGroup(key, targetNS)) {
-                continue;
-            }
-            if (nsList.find(targetNS) != nsList.end()) {
-                continue;
-            }
-            valtype val;
-            if (mempool.getUnconfirmedKeyValue(nameSpace, key, val) && val.size() > 0) {
-                namespaces.insert(targetNS);
-                nsList.insert(targetNS);
-            }
+    std::vector<std::tuple<valtype, valtype, valtype>> pendingGroupKeys;
+    mempool.getUnconfirmedGroupKeys(nameSpace, pendingGroupKeys);
+    std::set<valtype> pendingDeletes;
+    for (const auto& [key, targetNS, value] : pendingGroupKeys) {
+        if (value.empty()) {
+            pendingDeletes.insert(key);
+        } else {
+            namespaces.insert(targetNS);
         }
     }
 
     // Find the namespace connection initialized by us.
-    std::unique_ptr<CKevaIterator> iterKeys(view.IterateKeys(nameSpace));
-    valtype key;
-    while (iterKeys->next(key, data)) {
-        valtype targetNS;
-        // Find the value with the format _g:NamespaceId
-        if (isNamespaceGroup(key, targetNS)) {
-            // If it has been removed but not yet confirmed, skip it anyway.
-            {
-            // LOCK (mempool.cs);
-            valtype val;
-            if (mempool.getUnconfirmedKeyValue(nameSpace, key, val) && val.size() == 0) {
-                continue;
-            }
-            }
-            namespaces.insert(targetNS);
+    for (const auto& [key, joined] : group.joined) {
+        // If it has been removed but not yet confirmed, skip it anyway.
+        if (pendingDeletes.count(key) > 0) {
+            continue;
         }
+        namespaces.insert(joined.first);
     }
-
 }
 
 static RPCHelpMan keva_group_get()
@@ -260,7 +425,6 @@ static RPCHelpMan keva_group_get()
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
-    CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
     CTxMemPool& mempool = EnsureMemPool(node);
 
     if (!request.params[0].isStr()) {
@@ -301,12 +465,24 @@ static RPCHelpMan keva_group_get()
     if (key.size() > MAX_KEY_LENGTH)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "the key is too long");
 
-    std::set<valtype> namespaces;
+    /* Only a group that is not cached yet needs a snapshot to be built.  */
+    std::unique_ptr<CCoinsView> snapshot;
+    uint256 bestBlock;
+    CKevaGroup group;
     {
         LOCK(cs_main);
-        namespaces.insert(nameSpace);
-        getNamespaceGroup(nameSpace, namespaces, initiatorType, view, mempool);
+        const CCoinsViewCache& tip = chainman.ActiveChainstate().CoinsTip();
+        if (!tip.GetCachedNamespaceGroup(nameSpace, group)) {
+            snapshot = GetKevaSnapshot(chainman);
+            bestBlock = tip.GetBestBlock();
+        }
     }
+    if (snapshot)
+        group = LoadNamespaceGroup(chainman, *snapshot, bestBlock, nameSpace);
+
+    std::set<valtype> namespaces;
+    namespaces.insert(nameSpace);
+    getNamespaceGroup(nameSpace, namespaces, initiatorType, group, mempool);
 
     // If there is unconfirmed one, return its value.
     {
@@ -327,20 +503,21 @@ static RPCHelpMan keva_group_get()
 
   // Otherwise, return the confirmed value.
   {
-    LOCK(cs_main);
     unsigned currentHeight = 0;
     CKevaData data;
-    CKevaData currentData;
     valtype ns;
-    for (auto iter = namespaces.begin(); iter != namespaces.end(); ++iter) {
-      if (view.GetName(*iter, key, currentData)) {
-        if (currentData.getHeight() > currentHeight) {
-          currentHeight = currentData.getHeight();
-          data = currentData;
-          ns = *iter;
+    WithKevaView(chainman, snapshot, [&](const CCoinsView& view) {
+      CKevaData currentData;
+      for (auto iter = namespaces.begin(); iter != namespaces.end(); ++iter) {
+        if (view.GetName(*iter, key, currentData)) {
+          if (currentData.getHeight() > currentHeight) {
+            currentHeight = currentData.getHeight();
+            data = currentData;
+            ns = *iter;
+          }
         }
       }
-    }
+    });
     if (currentHeight > 0) {
       return getKevaInfo(key, data, ns);
     }
@@ -355,6 +532,65 @@ static RPCHelpMan keva_group_get()
     };
 }
 
+/**
+ * Position at which a paged keva_filter or keva_group_filter scan resumes.
+ * The scan is anchored at the chain tip of its first page, so that maxage
+ * means the same on every page.
+ */
+struct KevaFilterCursor
+{
+    //! Height and hash of the chain tip when the scan started.
+    uint32_t height{0};
+    uint256 block;
+    //! Namespace and key of the first entry of the next page.
+    valtype nameSpace;
+    valtype key;
+
+    SERIALIZE_METHODS(KevaFilterCursor, obj) { READWRITE(obj.height, obj.block, obj.nameSpace, obj.key); }
+};
+
+static std::string EncodeFilterCursor(const KevaFilterCursor& cursor)
+{
+    DataStream ss{};
+    ss << cursor;
+    return HexStr(ss);
+}
+
+/**
+ * Parse the cursor argument of a paged scan.  The empty string starts a new
+ * scan at the current tip.  Otherwise, the block the scan started at must
+ * still be in the active chain.
+ */
+static KevaFilterCursor ParseFilterCursor(const std::string& str, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    KevaFilterCursor cursor;
+    if (str.empty()) {
+        cursor.height = chain.Height();
+        cursor.block = chain.Tip()->GetBlockHash();
+        return cursor;
+    }
+
+    const auto bytes = TryParseHex<uint8_t>(str);
+    if (!bytes) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid cursor");
+    }
+    try {
+        DataStream ss{*bytes};
+        ss >> cursor;
+        if (!ss.empty()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid cursor");
+        }
+    } catch (const std::ios_base::failure&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid cursor");
+    }
+
+    const CBlockIndex* pindex = cursor.height <= static_cast<uint32_t>(chain.Height()) ? chain[cursor.height] : nullptr;
+    if (!pindex || pindex->GetBlockHash() != cursor.block) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "The cursor's block is no longer in the active chain, restart the scan");
+    }
+    return cursor;
+}
+
 static RPCHelpMan keva_group_filter()
 {
     return RPCHelpMan{"keva_group_filter",
@@ -367,6 +603,9 @@ static RPCHelpMan keva_group_filter()
             {"from", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Return from this position onward; index starts at 0, default=0"},
             {"nb", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Return only \"nb\" entries; 0 means all, default=0"},
             {"stat", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "If set to the string \"stat\", print statistics instead of returning the names"},
+            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Page through the entries instead of using \"from\": \"\" returns the first \"nb\" entries, and the \"next\" value of a page the entries after it.\n"
+                                                                       "Pages list every (namespace, key) entry separately, in the order of the namespaces and then of the keys, rather than one per key sorted by key. "
+                                                                       "Each page reads the chain state at the time of the call: no entry is returned twice, but entries that are created or deleted between two calls are only returned if they are after the cursor"},
         },
         {
             RPCResult{RPCResult::Type::OBJ, "", "",
@@ -376,17 +615,25 @@ static RPCHelpMan keva_group_filter()
                 {RPCResult::Type::STR, "txid", "The key's last update tx."},
                 {RPCResult::Type::NUM, "height", "The key's last update height."},
             }},
+            RPCResult{"if cursor is given", RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::ARR, "keys", "The entries of this page, in scan order.",
+                {
+                    {RPCResult::Type::ELISION, "", ""},
+                }},
+                {RPCResult::Type::STR_HEX, "next", /*optional=*/true, "Cursor to pass to get the next page, if there are more keys."},
+            }},
         },
         RPCExamples{
                 HelpExampleCli("keva_group_filter", "\"namespaceId\" \"all\"")
             + HelpExampleCli("keva_group_filter", "\"namespaceId\" \"self\" 96000 0 0 \"stat\"")
+            + HelpExampleCli("keva_group_filter", "-named namespace=\"namespaceId\" nb=100 cursor=\"\"")
             + HelpExampleRpc("keva_group_filter", "\"namespaceId\"")
             },
     [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
-    CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
     CTxMemPool& mempool = EnsureMemPool(node);
 
     if (chainman.IsInitialBlockDownload()) {
@@ -414,7 +661,7 @@ static RPCHelpMan keva_group_filter()
         }
     }
 
-    if (request.params.size() >= 2) {
+    if (request.params.size() >= 2 && !request.params[1].isNull()) {
         if (!request.params[1].isStr()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid initiator");
         }
@@ -430,7 +677,7 @@ static RPCHelpMan keva_group_filter()
         }
     }
 
-    if (request.params.size() >= 3) {
+    if (request.params.size() >= 3 && !request.params[2].isNull()) {
         if (!request.params[2].isStr()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid regex");
         }
@@ -438,7 +685,7 @@ static RPCHelpMan keva_group_filter()
         regexp = boost::xpressive::sregex::compile(request.params[2].get_str());
     }
 
-    if (request.params.size() >= 4) {
+    if (request.params.size() >= 4 && !request.params[3].isNull()) {
         if (!request.params[3].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid maxage");
         }
@@ -448,7 +695,7 @@ static RPCHelpMan keva_group_filter()
         throw JSONRPCError(RPC_INVALID_PARAMETER,
                         "'maxage' should be non-negative");
 
-    if (request.params.size() >= 5) {
+    if (request.params.size() >= 5 && !request.params[4].isNull()) {
         if (!request.params[4].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid from");
         }
@@ -457,7 +704,7 @@ static RPCHelpMan keva_group_filter()
     if (from < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "'from' should be non-negative");
 
-    if (request.params.size() >= 6) {
+    if (request.params.size() >= 6 && !request.params[5].isNull()) {
         if (!request.params[5].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid nb");
         }
@@ -466,7 +713,7 @@ static RPCHelpMan keva_group_filter()
     if (nb < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "'nb' should be non-negative");
 
-    if (request.params.size() >= 7) {
+    if (request.params.size() >= 7 && !request.params[6].isNull()) {
         if (!request.params[6].isStr()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid stat");
         }
@@ -476,34 +723,92 @@ static RPCHelpMan keva_group_filter()
         stats = true;
     }
 
+    const bool paged = request.params.size() >= 8 && !request.params[7].isNull();
+    if (paged && (from > 0 || stats)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "'cursor' cannot be combined with 'from' or 'stat'");
+    }
+
     UniValue uniKeys(UniValue::VARR);
     unsigned count(0);
+    /* Without a cursor, a key that is in several namespaces of the group is
+       returned once, with its most recent data.  All keys seen so far are
+       remembered, so that "from", "nb" and "stat" count distinct keys.  */
     std::map<valtype, std::tuple<CKevaData, valtype>> keys;
+    std::set<valtype> seenKeys;
+
+    /* A paged scan keeps the tip height of its first page, and resumes at
+       the namespace and key the previous page stopped at.  */
+    int height;
+    KevaFilterCursor cursor;
+    bool hasMore(false);
+    std::unique_ptr<CCoinsView> snapshot;
+    uint256 bestBlock;
+    CKevaGroup group;
+    {
+        LOCK (cs_main);
+        height = chainman.ActiveHeight();
+        if (paged) {
+            cursor = ParseFilterCursor(request.params[7].get_str(), chainman.ActiveChain());
+            height = cursor.height;
+        }
+        const CCoinsViewCache& tip = chainman.ActiveChainstate().CoinsTip();
+        if (!tip.GetCachedNamespaceGroup(nameSpace, group)) {
+            snapshot = GetKevaSnapshot(chainman);
+            bestBlock = tip.GetBestBlock();
+        }
+    }
+    if (snapshot)
+        group = LoadNamespaceGroup(chainman, *snapshot, bestBlock, nameSpace);
 
-    LOCK (cs_main);
     std::set<valtype> namespaces;
     namespaces.insert(nameSpace);
-    getNamespaceGroup(nameSpace, namespaces, initiatorType, view, mempool);
+    getNamespaceGroup(nameSpace, namespaces, initiatorType, group, mempool);
 
     valtype key;
     CKevaData data;
     valtype displayKey = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
-    for (auto iterNS = namespaces.begin(); iterNS != namespaces.end(); ++iterNS) {
-        std::unique_ptr<CKevaIterator> iter(view.IterateKeys(*iterNS));
-        while (iter->next(key, data)) {
-            if (key == displayKey) {
-                continue;
-            }
-            const int age = chainman.ActiveHeight() - data.getHeight();
-            assert(age >= 0);
-            if (maxage != 0 && age >= maxage) {
-                continue;
+    WithKevaView(chainman, snapshot, [&](const CCoinsView& view) {
+        for (auto iterNS = namespaces.lower_bound(cursor.nameSpace); iterNS != namespaces.end() && !hasMore; ++iterNS) {
+            std::unique_ptr<CKevaIterator> iter(IterateRecentKeys(view, *iterNS, height, maxage));
+            if (*iterNS == cursor.nameSpace) {
+                iter->seek(cursor.key);
             }
+            while (iter->next(key, data)) {
+                if (key == displayKey) {
+                    continue;
+                }
+                // Keys updated after a paged scan started count as new.
+                const int age = std::max(0, height - static_cast<int>(data.getHeight()));
+                if (maxage != 0 && age >= maxage) {
+                    continue;
+                }
+
+                if (haveRegexp) {
+                    const std::string keyStr = ValtypeToString(key);
+                    boost::xpressive::smatch matches;
+                    if (!boost::xpressive::regex_search(keyStr, matches, regexp))
+                        continue;
+                }
+
+                /* A paged scan returns every (namespace, key) entry in the order
+                   it is iterated, so that the cursor is simply the next entry.  */
+                if (paged) {
+                    if (nb > 0 && count == static_cast<unsigned>(nb)) {
+                        cursor.nameSpace = *iterNS;
+                        cursor.key = key;
+                        hasMore = true;
+                        break;
+                    }
+                    ++count;
+                    uniKeys.push_back(getKevaInfo(key, data, *iterNS));
+                    continue;
+                }
 
-            if (haveRegexp) {
-                const std::string keyStr = ValtypeToString(key);
-                boost::xpressive::smatch matches;
-                if (!boost::xpressive::regex_search(keyStr, matches, regexp))
+                if (!seenKeys.insert(key).second) {
+                    auto it = keys.find(key);
+                    if (it != keys.end() && data.getHeight() > std::get<0>(it->second).getHeight()) {
+                        it->second = std::make_tuple(data, *iterNS);
+                    }
                     continue;
                 }
 
@@ -511,34 +816,36 @@ static RPCHelpMan keva_group_filter()
                     --from;
                     continue;
                 }
-                assert(from == 0);
+                /* Later namespaces may still have newer data of the keys that
+                   were already found, so the scan does not stop at "nb".  */
+                if (nb > 0 && count == static_cast<unsigned>(nb)) {
+                    continue;
+                }
 
-            if (stats) {
                 ++count;
-            } else {
-                auto it = keys.find(key);
-                if (it == keys.end()) {
-                    keys.insert(std::make_pair(key, std::make_tuple(data, *iterNS)));
-                } else if (data.getHeight() > std::get<0>(it->second).getHeight()) {
-                    it->second = std::make_tuple(data, *iterNS);
+                if (!stats) {
+                    keys.emplace(key, std::make_tuple(data, *iterNS));
                 }
             }
-
-            if (nb > 0) {
-                --nb;
-                if (nb == 0)
-                    break;
-            }
         }
-    }
+    });
 
     if (stats) {
         UniValue res(UniValue::VOBJ);
-        res.pushKV("blocks", chainman.ActiveHeight());
+        res.pushKV("blocks", height);
         res.pushKV("count", static_cast<int>(count));
         return res;
     }
 
+    if (paged) {
+        UniValue res(UniValue::VOBJ);
+        res.pushKV("keys", uniKeys);
+        if (hasMore) {
+            res.pushKV("next", EncodeFilterCursor(cursor));
+        }
+        return res;
+    }
+
     for (auto e = keys.begin(); e != keys.end(); ++e) {
         uniKeys.push_back(getKevaInfo(e->first, std::get<0>(e->second), std::get<1>(e->second)));
     }
@@ -560,6 +867,7 @@ static RPCHelpMan keva_filter()
             {"from", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Return from this position onward; index starts at 0, default=0"},
             {"nb", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Return only \"nb\" entries; 0 means all, default=0"},
             {"stat", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "If set to the string \"stat\", print statistics instead of returning the names"},
+            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Page through the keys instead of using \"from\": \"\" returns the first \"nb\" keys, and the \"next\" value of a page the keys after it"},
         },
         {
             RPCResult{RPCResult::Type::OBJ, "", "",
@@ -569,20 +877,25 @@ static RPCHelpMan keva_filter()
                 {RPCResult::Type::STR, "txid", "The key's last update tx."},
                 {RPCResult::Type::NUM, "height", "The key's last update height."},
             }},
+            RPCResult{"if cursor is given", RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::ARR, "keys", "The keys of this page, as without cursor.",
+                {
+                    {RPCResult::Type::ELISION, "", ""},
+                }},
+                {RPCResult::Type::STR_HEX, "next", /*optional=*/true, "Cursor to pass to get the next page, if there are more keys."},
+            }},
         },
         RPCExamples{
                 HelpExampleCli("keva_filter", "\"^id/\"")
             + HelpExampleCli("keva_filter", "\"^id/\" 96000 0 0 \"stat\"")
+            + HelpExampleCli("keva_filter", "-named namespace=\"namespaceId\" nb=100 cursor=\"\"")
             + HelpExampleRpc("keva_filter", "\"^d/\"")
             },
     [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
-    // std::unique_ptr<CCoinsViewCache> pcoinsTip;
-    // CCoinsViewCache view(pcoinsTip->)
-    LOCK (cs_main);
-    CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
 
     if (chainman.IsInitialBlockDownload()) {
         throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD,
@@ -611,7 +924,7 @@ static RPCHelpMan keva_filter()
         }
     }
 
-    if (request.params.size() >= 2) {
+    if (request.params.size() >= 2 && !request.params[1].isNull()) {
         if (!request.params[1].isStr()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid regex");
         }
@@ -619,7 +932,7 @@ static RPCHelpMan keva_filter()
         regexp = boost::xpressive::sregex::compile(request.params[1].get_str());
     }
 
-    if (request.params.size() >= 3) {
+    if (request.params.size() >= 3 && !request.params[2].isNull()) {
         if (!request.params[2].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid maxage");
         }
@@ -629,7 +942,7 @@ static RPCHelpMan keva_filter()
         throw JSONRPCError(RPC_INVALID_PARAMETER,
                         "'maxage' should be non-negative");
 
-    if (request.params.size() >= 4) {
+    if (request.params.size() >= 4 && !request.params[3].isNull()) {
         if (!request.params[3].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid from");
         }
@@ -638,7 +951,7 @@ static RPCHelpMan keva_filter()
     if (from < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "'from' should be non-negative");
 
-    if (request.params.size() >= 5) {
+    if (request.params.size() >= 5 && !request.params[4].isNull()) {
         if (!request.params[4].isNum()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid nb");
         }
@@ -647,7 +960,7 @@ static RPCHelpMan keva_filter()
     if (nb < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "'nb' should be non-negative");
 
-    if (request.params.size() >= 6) {
+    if (request.params.size() >= 6 && !request.params[5].isNull()) {
         if (!request.params[5].isStr()) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid stat");
         }
@@ -657,20 +970,46 @@ static RPCHelpMan keva_filter()
         stats = true;
     }
 
+    const bool paged = request.params.size() >= 7 && !request.params[6].isNull();
+    if (paged && (from > 0 || stats)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "'cursor' cannot be combined with 'from' or 'stat'");
+    }
+
     /* ******************************************* */
     /* Iterate over names to build up the result.  */
 
     UniValue keys(UniValue::VARR);
     unsigned count(0);
 
-    LOCK (cs_main);
+    /* A paged scan keeps the tip height of its first page, and resumes at
+       the key the previous page stopped at.  */
+    int height;
+    KevaFilterCursor cursor;
+    bool hasMore(false);
+    std::unique_ptr<CCoinsView> snapshot;
+    {
+        LOCK (cs_main);
+        height = chainman.ActiveHeight();
+        if (paged) {
+            cursor = ParseFilterCursor(request.params[6].get_str(), chainman.ActiveChain());
+            if (!cursor.nameSpace.empty() && cursor.nameSpace != nameSpace) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "the cursor is for another namespace");
+            }
+            height = cursor.height;
+        }
+        snapshot = GetKevaSnapshot(chainman);
+    }
+    const CCoinsView& view = *snapshot;
 
     valtype key;
     CKevaData data;
-    std::unique_ptr<CKevaIterator> iter(view.IterateKeys(nameSpace));
+    std::unique_ptr<CKevaIterator> iter(IterateRecentKeys(view, nameSpace, height, maxage));
+    if (paged) {
+        iter->seek(cursor.key);
+    }
     while (iter->next(key, data)) {
-        const int age = chainman.ActiveHeight() - data.getHeight();
-        assert(age >= 0);
+        // Keys updated after a paged scan started count as new.
+        const int age = std::max(0, height - static_cast<int>(data.getHeight()));
         if (maxage != 0 && age >= maxage)
             continue;
 
@@ -687,12 +1026,18 @@ static RPCHelpMan keva_filter()
         }
         assert(from == 0);
 
-        if (stats)
-            ++count;
-        else
+        if (paged && nb > 0 && count == static_cast<unsigned>(nb)) {
+            cursor.nameSpace = nameSpace;
+            cursor.key = key;
+            hasMore = true;
+            break;
+        }
+
+        ++count;
+        if (!stats)
             keys.push_back(getKevaInfo(key, data));
 
-        if (nb > 0) {
+        if (!paged && nb > 0) {
             --nb;
             if (nb == 0)
                 break;
@@ -704,11 +1049,20 @@ static RPCHelpMan keva_filter()
 
     if (stats) {
         UniValue res(UniValue::VOBJ);
-        res.pushKV("blocks", chainman.ActiveHeight());
+        res.pushKV("blocks", height);
         res.pushKV("count", static_cast<int>(count));
         return res;
     }
 
+    if (paged) {
+        UniValue res(UniValue::VOBJ);
+        res.pushKV("keys", keys);
+        if (hasMore) {
+            res.pushKV("next", EncodeFilterCursor(cursor));
+        }
+        return res;
+    }
+
     return keys;
 },
     };
@@ -766,7 +1120,6 @@ static RPCHelpMan keva_group_show()
 {
     NodeContext& node = EnsureAnyNodeContext(request.context);
     ChainstateManager& chainman = EnsureChainman(node);
-    CCoinsViewCache& view = chainman.ActiveChainstate().CoinsTip();
     CTxMemPool& mempool = EnsureMemPool(node);
 
     if (chainman.IsInitialBlockDownload()) {
@@ -832,144 +1185,325 @@ static RPCHelpMan keva_group_show()
     UniValue namespaces(UniValue::VARR);
     unsigned count(0);
 
-    LOCK (cs_main);
+    int height;
+    std::unique_ptr<CCoinsView> snapshot;
+    uint256 bestBlock;
+    CKevaGroup group;
+    {
+        LOCK (cs_main);
+        height = chainman.ActiveHeight();
+        const CCoinsViewCache& tip = chainman.ActiveChainstate().CoinsTip();
+        if (!tip.GetCachedNamespaceGroup(nameSpace, group)) {
+            snapshot = GetKevaSnapshot(chainman);
+            bestBlock = tip.GetBestBlock();
+        }
+    }
+    if (snapshot)
+        group = LoadNamespaceGroup(chainman, *snapshot, bestBlock, nameSpace);
 
-    valtype ns;
-    CKevaData data;
     valtype nsDisplayKey = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
-    std::unique_ptr<CKevaIterator> iter(view.IterateAssociatedNamespaces(nameSpace));
 
     // Find the namespace connection initialized by others.
-    while (iter->next(ns, data)) {
-        const int age = chainman.ActiveHeight() - data.getHeight();
-        assert(age >= 0);
-        if (maxage != 0 && age >= maxage) {
-            continue;
-        }
+    WithKevaView(chainman, snapshot, [&](const CCoinsView& view) {
+        for (const auto& [ns, data] : group.members) {
+            const int age = height - data.getHeight();
+            assert(age >= 0);
+            if (maxage != 0 && age >= maxage) {
+                continue;
+            }
 
-        if (from > 0) {
-            --from;
-            continue;
+            if (from > 0) {
+                --from;
+                continue;
+            }
+            assert(from == 0);
+
+            if (stats) {
+                ++count;
+            } else {
+                CKevaData nsData;
+                valtype nsName;
+                if (view.GetName(ns, nsDisplayKey, nsData)) {
+                    nsName = nsData.getValue();
+                    }
+                    namespaces.push_back(getNamespaceInfo(ns, nsName, data.getUpdateOutpoint(),
+                                    data.getHeight(), true));
+            }
+
+            if (nb > 0) {
+                --nb;
+                if (nb == 0)
+                    break;
+            }
         }
-        assert(from == 0);
+    });
 
-        if (stats) {
-            ++count;
-        } else {
+    // Find the namespace connection initialized by us, and not confirmed yet.
+    std::vector<std::tuple<valtype, valtype, valtype>> pendingGroupKeys;
+    mempool.getUnconfirmedGroupKeys(nameSpace, pendingGroupKeys);
+    std::set<valtype> pendingDeletes;
+    WithKevaView(chainman, snapshot, [&](const CCoinsView& view) {
+        std::set<valtype> nsList;
+        for (const auto& [key, targetNS, value] : pendingGroupKeys) {
+            if (value.empty()) {
+                pendingDeletes.insert(key);
+                continue;
+            }
+            if (nsList.find(targetNS) != nsList.end()) {
+                continue;
+            }
             CKevaData nsData;
             valtype nsName;
-            if (view.GetName(ns, nsDisplayKey, nsData)) {
+            if (view.GetName(targetNS, nsDisplayKey, nsData)) {
                 nsName = nsData.getValue();
-                }
-                namespaces.push_back(getNamespaceInfo(ns, nsName, data.getUpdateOutpoint(),
-                                data.getHeight(), true));
-        }
-
-        if (nb > 0) {
-            --nb;
-            if (nb == 0)
-                break;
+            }
+            UniValue obj(UniValue::VOBJ);
+            obj.pushKV("namespaceId", EncodeBase58Check(targetNS));
+            obj.pushKV("display_name", ValtypeToString(nsName));
+            obj.pushKV("height", -1);
+            obj.pushKV("initiator", false);
+            namespaces.push_back(obj);
+            nsList.insert(targetNS);
         }
-    }
+    });
+
+    // Find the namespace connection initialized by us and confirmed, in
+    // the same order as the keys of the namespace.
+    std::vector<std::pair<valtype, std::pair<valtype, CKevaData>>> joined(group.joined.begin(), group.joined.end());
+    std::sort(joined.begin(), joined.end(), [](const auto& a, const auto& b) {
+        return CKevaListIterator::keyLess(a.first, b.first);
+    });
+    WithKevaView(chainman, snapshot, [&](const CCoinsView& view) {
+        for (const auto& [key, target] : joined) {
+            const auto& [targetNS, data] = target;
 
-    // Find the namespace connection initialized by us, and not confirmed yet.
-    {
-        // LOCK (mempool.cs);
-        std::vector<std::tuple<valtype, valtype, valtype, uint256>> unconfirmedKeyValueList;
-        mempool.getUnconfirmedKeyValueList(unconfirmedKeyValueList, nameSpace);
-        std::set<valtype> nsList;
-        valtype targetNS;
-        for (auto entry: unconfirmedKeyValueList) {
-            const valtype ns = std::get<0>(entry);
-            if (ns != nameSpace) {
+            // If it has been removed but not yet confirmed, skip it anyway.
+            if (pendingDeletes.count(key) > 0) {
                 continue;
             }
-            const valtype key = std::get<1>(entry);
-            // Find the value with the format _g:NamespaceId
-            if (!isNamespaceGroup(key, targetNS)) {
+
+            const int age = height - data.getHeight();
+            assert(age >= 0);
+            if (maxage != 0 && age >= maxage) {
                 continue;
             }
-            if (nsList.find(targetNS) != nsList.end()) {
+
+            if (from > 0) {
+                --from;
                 continue;
             }
-            valtype val;
-            if (mempool.getUnconfirmedKeyValue(nameSpace, key, val) && val.size() > 0) {
+            assert(from == 0);
+
+            if (stats) {
+                ++count;
+            }
+            else {
                 CKevaData nsData;
                 valtype nsName;
                 if (view.GetName(targetNS, nsDisplayKey, nsData)) {
                     nsName = nsData.getValue();
                 }
-                UniValue obj(UniValue::VOBJ);
-                obj.pushKV("namespaceId", EncodeBase58Check(targetNS));
-                obj.pushKV("display_name", ValtypeToString(nsName));
-                obj.pushKV("height", -1);
-                obj.pushKV("initiator", false);
-                namespaces.push_back(obj);
-                nsList.insert(targetNS);
+                namespaces.push_back(getNamespaceInfo(targetNS, nsName, data.getUpdateOutpoint(),
+                                data.getHeight(), false));
+            }
+
+            if (nb > 0) {
+                --nb;
+                if (nb == 0)
+                break;
             }
         }
+    });
+
+    if (stats) {
+        UniValue res(UniValue::VOBJ);
+        res.pushKV("blocks", height);
+        res.pushKV("count", static_cast<int>(count));
+        return res;
     }
 
-    // Find the namespace connection initialized by us and confirmed.
-    std::unique_ptr<CKevaIterator> iterKeys(view.IterateKeys(nameSpace));
-    valtype targetNS;
-    valtype key;
-    while (iterKeys->next(key, data)) {
+    return namespaces;
+},
+    };
+}
 
-        // Find the value with the format _g:NamespaceId
-        if (!isNamespaceGroup(key, targetNS)) {
-            continue;
-        }
+/* Encode a position in the keva history index as an opaque cursor.  */
+static std::string EncodeHistoryCursor(uint32_t height, uint32_t seq)
+{
+    unsigned char buf[8];
+    WriteBE32(buf, height);
+    WriteBE32(buf + 4, seq);
+    return HexStr(buf);
+}
 
-        // If it has been removed but not yet confirmed, skip it anyway.
+static RPCHelpMan keva_history()
+{
+    return RPCHelpMan{"keva_history",
+        "\nList all confirmed operations on the given key, oldest first.\n"
+        "Requires -kevahistoryindex.\n",
         {
-            // LOCK (mempool.cs);
-            valtype val;
-            if (mempool.getUnconfirmedKeyValue(nameSpace, key, val) && val.size() == 0) {
-                continue;
-            }
-        }
+            {"namespace", RPCArg::Type::STR, RPCArg::Optional::NO, "The namespace Id"},
+            {"key", RPCArg::Type::STR, RPCArg::Optional::NO, "The key"},
+            {"count", RPCArg::Type::NUM, RPCArg::Default{100}, "Return at most this many operations (1 to 1000)"},
+            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Continue after the operations of a previous call, as returned in its \"next\" field"},
+        },
+        RPCResult{RPCResult::Type::OBJ, "", "",
+        {
+            {RPCResult::Type::ARR, "history", "",
+            {
+                {RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::STR, "key", "The key."},
+                    {RPCResult::Type::STR, "value", "The value set by the operation (empty for deletions)."},
+                    {RPCResult::Type::STR_HEX, "txid", "The transaction of the operation."},
+                    {RPCResult::Type::NUM, "vout", "The output of the operation."},
+                    {RPCResult::Type::NUM, "height", "The height of the block containing the operation."},
+                    {RPCResult::Type::BOOL, "deleted", "Whether the operation deleted the key."},
+                }},
+            }},
+            {RPCResult::Type::STR, "next", /*optional=*/true, "Cursor to pass to get the next operations, if there are more."},
+        }},
+        RPCExamples{
+                HelpExampleCli("keva_history", "\"namespace_id\" \"key\"")
+            + HelpExampleCli("keva_history", "\"namespace_id\" \"key\" 100 \"cursor\"")
+            + HelpExampleRpc("keva_history", "\"namespace_id\", \"key\"")
+            },
+    [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_keva_history_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The keva history index is not enabled. Use -kevahistoryindex to enable it.");
+    }
 
-        const int age = chainman.ActiveHeight() - data.getHeight();
-        assert(age >= 0);
-        if (maxage != 0 && age >= maxage) {
-            continue;
-        }
+    valtype nameSpace;
+    if (!DecodeKevaNamespace(request.params[0].get_str(), Params(), nameSpace)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid namespace id");
+    }
+    if (nameSpace.size() > MAX_NAMESPACE_LENGTH)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "the namespace is too long");
 
-        if (from > 0) {
-            --from;
-            continue;
-        }
-        assert(from == 0);
+    const valtype key = ValtypeFromString(request.params[1].get_str());
+    if (key.size() > MAX_KEY_LENGTH)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "the key is too long");
 
-        if (stats) {
-            ++count;
-        }
-        else {
-            CKevaData nsData;
-            valtype nsName;
-            if (view.GetName(targetNS, nsDisplayKey, nsData)) {
-                nsName = nsData.getValue();
-            }
-            namespaces.push_back(getNamespaceInfo(targetNS, nsName, data.getUpdateOutpoint(),
-                            data.getHeight(), false));
-        }
+    const int count = request.params[2].isNull() ? 100 : request.params[2].getInt<int>();
+    if (count < 1 || count > 1000) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count must be between 1 and 1000");
+    }
 
-        if (nb > 0) {
-            --nb;
-            if (nb == 0)
-            break;
+    std::pair<uint32_t, uint32_t> start{0, 0};
+    if (!request.params[3].isNull()) {
+        const auto cursor = TryParseHex<unsigned char>(request.params[3].get_str());
+        if (!cursor || cursor->size() != 8) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid cursor");
         }
+        start = {ReadBE32(cursor->data()), ReadBE32(cursor->data() + 4)};
     }
 
-    if (stats) {
-        UniValue res(UniValue::VOBJ);
-        res.pushKV("blocks", chainman.ActiveHeight());
-        res.pushKV("count", static_cast<int>(count));
-        return res;
+    if (!g_keva_history_index->BlockUntilSyncedToCurrentChain()) {
+        const IndexSummary summary{g_keva_history_index->GetSummary()};
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("The keva history index is still syncing. Current height: %d", summary.best_block_height));
     }
 
-    return namespaces;
+    std::vector<KevaHistoryEntry> entries;
+    const bool more = g_keva_history_index->FindHistory(nameSpace, key, start, count, entries);
+
+    UniValue history(UniValue::VARR);
+    for (const KevaHistoryEntry& entry : entries) {
+        UniValue obj = getKevaInfo(key, entry.value, entry.outpoint, entry.height, valtype());
+        obj.pushKV("deleted", entry.deleted);
+        history.push_back(obj);
+    }
+
+    UniValue res(UniValue::VOBJ);
+    res.pushKV("history", history);
+    if (more) {
+        /* The cursor points just past the last returned operation.  */
+        const KevaHistoryEntry& last = entries.back();
+        res.pushKV("next", EncodeHistoryCursor(last.height, last.seq + 1));
+    }
+    return res;
+},
+    };
+}
+
+static RPCHelpMan keva_recent()
+{
+    return RPCHelpMan{"keva_recent",
+        "\nList the keys of all namespaces that were updated in the last blocks, most recent first.\n",
+        {
+            {"maxage", RPCArg::Type::NUM, RPCArg::Default{100}, "Only consider keys updated in the last \"maxage\" blocks (1 to 10000)"},
+            {"nb", RPCArg::Type::NUM, RPCArg::Default{100}, "Return only \"nb\" entries; 0 means all"},
+        },
+        RPCResult{RPCResult::Type::ARR, "", "",
+        {
+            {RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR, "key", "The key."},
+                {RPCResult::Type::STR, "value", "The key's current value."},
+                {RPCResult::Type::STR_HEX, "txid", "The key's last update tx."},
+                {RPCResult::Type::NUM, "vout", "The output of the key's last update."},
+                {RPCResult::Type::NUM, "height", "The key's last update height."},
+                {RPCResult::Type::STR, "namespace", "The namespace Id."},
+            }},
+        }},
+        RPCExamples{
+                HelpExampleCli("keva_recent", "")
+            + HelpExampleCli("keva_recent", "1000 0")
+            + HelpExampleRpc("keva_recent", "100, 10")
+            },
+    [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+
+    if (chainman.IsInitialBlockDownload()) {
+        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD,
+                        "Kevacoin is downloading blocks...");
+    }
+
+    const int maxage = request.params[0].isNull() ? 100 : request.params[0].getInt<int>();
+    if (maxage < 1 || maxage > 10000) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "maxage must be between 1 and 10000");
+    }
+    const int nb = request.params[1].isNull() ? 100 : request.params[1].getInt<int>();
+    if (nb < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "'nb' should be non-negative");
+    }
+
+    int height;
+    std::unique_ptr<CCoinsView> snapshot;
+    {
+        LOCK (cs_main);
+        height = chainman.ActiveHeight();
+        snapshot = GetKevaSnapshot(chainman);
+    }
+    const CCoinsView& view = *snapshot;
+    std::set<CKevaCache::NamespaceKeyType> names;
+    if (!view.GetNamesSinceHeight(std::max(0, height - maxage + 1), names)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The keva height index is not available");
+    }
+
+    std::vector<std::pair<const CKevaCache::NamespaceKeyType*, CKevaData>> entries;
+    entries.reserve(names.size());
+    for (const auto& name : names) {
+        CKevaData data;
+        if (view.GetName(std::get<0>(name), std::get<1>(name), data)) {
+            entries.emplace_back(&name, std::move(data));
+        }
+    }
+    /* Most recent first, and in the (namespace, key) order within a block.  */
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.second.getHeight() > b.second.getHeight();
+    });
+    if (nb > 0 && entries.size() > static_cast<size_t>(nb)) {
+        entries.resize(nb);
+    }
+
+    UniValue keys(UniValue::VARR);
+    for (const auto& [name, data] : entries) {
+        keys.push_back(getKevaInfo(std::get<1>(*name), data, std::get<0>(*name)));
+    }
+    return keys;
 },
     };
 }
@@ -978,10 +1512,13 @@ void RegisterKevaRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"keva_get", &keva_get},
+        {"keva_get_multi", &keva_get_multi},
         {"keva_filter", &keva_filter},
         {"keva_group_show", &keva_group_show},
         {"keva_group_get", &keva_group_get},
         {"keva_group_filter", &keva_group_filter},
+        {"keva_history", &keva_history},
+        {"keva_recent", &keva_recent},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
@@ -8,6 +8,7 @@
 
 #include <hash.h>
 #include <keva/common.h>
+#include <memusage.h>
 #include <script/keva.h>
 
 const std::string CKevaScript::KEVA_DISPLAY_NAME_KEY = "_KEVA_NS_";
@@ -76,6 +77,14 @@ CKevaScript::CKevaScript(const CScript& script)
     address = CScript(pc, script.end());
 }
 
+size_t CKevaScript::DynamicMemoryUsage() const
+{
+  size_t usage = memusage::DynamicUsage(address) + memusage::DynamicUsage(args);
+  for (const valtype& arg : args)
+    usage += memusage::DynamicUsage(arg);
+  return usage;
+}
+
 CScript CKevaScript::buildKevaPut(const CScript& addr, const valtype& nameSpace,
                           const valtype& key, const valtype& value)
 {
@@ -234,6 +234,12 @@ public:
     return (op == OP_KEVA_DELETE);
   }
 
+  /**
+   * Return the dynamic memory usage of the address and the arguments.
+   * @return The memory used on the heap.
+   */
+  size_t DynamicMemoryUsage() const;
+
   /**
    * Check if the given script is a keva script.  This is a utility method.
    * @param script The script to parse.
@@ -241,10 +247,25 @@ public:
    */
   static inline bool isKevaScript (const CScript& script)
   {
+    if (!hasKevaPrefix(script))
+      return false;
     const CKevaScript op(script);
     return op.isKevaOp();
   }
 
+  /**
+   * Check if the script starts with a keva operation code.  This is much
+   * cheaper than parsing it and false for all scripts that are no keva
+   * scripts, so it can be used to skip the parsing.
+   * @param script The script to check.
+   * @return True iff it may be a keva script.
+   */
+  static inline bool hasKevaPrefix (const CScript& script)
+  {
+    return !script.empty () && script[0] >= OP_KEVA_NAMESPACE
+             && script[0] <= OP_KEVA_DELETE;
+  }
+
  /**
    * Build a keva namespace transaction.
    * @param addr The address script to append.
@@ -222,6 +222,7 @@ bool CScript::IsPayToScriptHash(bool allowKeva) const
 
     
     // Strip off a keva prefix if present.
+    if (!CKevaScript::hasKevaPrefix(*this)) return IsPayToScriptHash(false);
     const CKevaScript kevaOp(*this);
     return kevaOp.getAddress().IsPayToScriptHash(false);
 }
@@ -236,6 +237,7 @@ bool CScript::IsPayToWitnessScriptHash(bool allowKeva) const
     }
     
     // Strip off a keva prefix if present.
+    if (!CKevaScript::hasKevaPrefix(*this)) return IsPayToWitnessScriptHash(false);
     const CKevaScript kevaOp(*this);
     return kevaOp.getAddress().IsPayToWitnessScriptHash(false);
 }
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <optional>
 #include <string>
 
 typedef std::vector<unsigned char> valtype;
@@ -143,8 +144,9 @@ TxoutType Solver(const CScript& scriptPubKey, std::vector<std::vector<unsigned c
     vSolutionsRet.clear();
 
     // If we have a keva script, strip the prefix
-    const CKevaScript kevaOp(scriptPubKey);
-    const CScript& script1 = kevaOp.getAddress();
+    std::optional<CKevaScript> kevaOp;
+    if (CKevaScript::hasKevaPrefix(scriptPubKey)) kevaOp.emplace(scriptPubKey);
+    const CScript& script1 = kevaOp ? kevaOp->getAddress() : scriptPubKey;
 
     // Shortcut for pay-to-script-hash, which are more constrained than the other types:
     // it is always OP_HASH160 20 [20 byte hash] OP_EQUAL
@@ -130,6 +130,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getdescriptorinfo",
     "getdifficulty",
     "getindexinfo",
+    "getkevasetinfo",
     "getmemoryinfo",
     "getmempoolancestors",
     "getmempooldescendants",
@@ -169,6 +170,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "signmessagewithprivkey",
     "signrawtransactionwithkey",
     "submitblock",
+    "submitcryptonoteblock",
     "submitheader",
     "submitpackage",
     "syncwithvalidationinterfacequeue",
@@ -0,0 +1,921 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <base58.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <core_memusage.h>
+#include <crypto/muhash.h>
+#include <kernel/coinstats.h>
+#include <keva/common.h>
+#include <keva/main.h>
+#include <memusage.h>
+#include <node/utxo_snapshot.h>
+#include <primitives/block.h>
+#include <script/keva.h>
+#include <streams.h>
+#include <txdb.h>
+#include <txmempool.h>
+#include <uint256.h>
+#include <undo.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <array>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(keva_tests, TestingSetup)
+
+static CKevaScript KevaPut(const valtype& nameSpace, const std::string& key, const std::string& value)
+{
+    return CKevaScript(CKevaScript::buildKevaPut(CScript() << OP_TRUE, nameSpace, ValtypeFromString(key), ValtypeFromString(value)));
+}
+
+static CKevaScript KevaDelete(const valtype& nameSpace, const std::string& key)
+{
+    return CKevaScript(CKevaScript::buildKevaDelete(CScript() << OP_TRUE, nameSpace, ValtypeFromString(key)));
+}
+
+BOOST_AUTO_TEST_CASE(keva_mempool_index)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    CKevaMemPool kevaPool(pool);
+    LOCK(pool.cs);
+
+    const valtype nsA = ValtypeFromString("namespace-a");
+    const valtype nsB = ValtypeFromString("namespace-b");
+    const uint256 tx1{uint256::ONE};
+    const uint256 tx2 = uint256S("02");
+    const uint256 tx3 = uint256S("03");
+    const uint256 tx4 = uint256S("04");
+
+    kevaPool.addUnchecked(tx1, KevaPut(nsA, "key", "first"));
+    kevaPool.addUnchecked(tx2, KevaPut(nsB, "key", "other"));
+    kevaPool.addUnchecked(tx3, KevaPut(nsA, "key", "second"));
+    kevaPool.addUnchecked(tx4, KevaDelete(nsA, "gone"));
+
+    // The latest pending operation on a key wins.
+    valtype value;
+    BOOST_CHECK(kevaPool.getUnconfirmedKeyValue(nsA, ValtypeFromString("key"), value));
+    BOOST_CHECK(value == ValtypeFromString("second"));
+    BOOST_CHECK(kevaPool.getUnconfirmedKeyValue(nsA, ValtypeFromString("gone"), value));
+    BOOST_CHECK(value.empty());
+    BOOST_CHECK(!kevaPool.getUnconfirmedKeyValue(nsA, ValtypeFromString("missing"), value));
+
+    // Lists follow insertion order, optionally filtered by namespace.
+    std::vector<std::tuple<valtype, valtype, valtype, uint256>> list;
+    kevaPool.getUnconfirmedKeyValueList(list, valtype());
+    BOOST_CHECK_EQUAL(list.size(), 4U);
+    BOOST_CHECK(std::get<3>(list[0]) == tx1);
+    BOOST_CHECK(std::get<3>(list[1]) == tx2);
+    BOOST_CHECK(std::get<3>(list[3]) == tx4);
+
+    list.clear();
+    kevaPool.getUnconfirmedKeyValueList(list, nsA);
+    BOOST_CHECK_EQUAL(list.size(), 3U);
+    BOOST_CHECK(std::get<3>(list[0]) == tx1);
+    BOOST_CHECK(std::get<3>(list[1]) == tx3);
+
+    // Removing the latest operation exposes the previous one again.
+    kevaPool.remove(tx3);
+    BOOST_CHECK(kevaPool.getUnconfirmedKeyValue(nsA, ValtypeFromString("key"), value));
+    BOOST_CHECK(value == ValtypeFromString("first"));
+
+    kevaPool.remove(tx1);
+    kevaPool.remove(tx4);
+    BOOST_CHECK(!kevaPool.getUnconfirmedKeyValue(nsA, ValtypeFromString("key"), value));
+    list.clear();
+    kevaPool.getUnconfirmedKeyValueList(list, nsA);
+    BOOST_CHECK(list.empty());
+
+    // Removing an unknown transaction is a no-op.
+    kevaPool.remove(tx1);
+    list.clear();
+    kevaPool.getUnconfirmedKeyValueList(list, valtype());
+    BOOST_CHECK_EQUAL(list.size(), 1U);
+}
+
+static CKevaData KevaData(unsigned height, const std::string& value)
+{
+    CKevaData data;
+    data.fromScript(height, COutPoint(), KevaPut(ValtypeFromString("ns"), "key", value));
+    return data;
+}
+
+/** Backing view that counts keva reads and remembers written changes.  */
+class KevaCountingView : public CCoinsView
+{
+public:
+    CKevaCache written;
+    mutable int reads{0};
+
+    bool GetName(const valtype& nameSpace, const valtype& key, CKevaData& data) const override
+    {
+        ++reads;
+        if (written.isDeleted(nameSpace, key)) return false;
+        return written.get(nameSpace, key, data);
+    }
+
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const CKevaCache& names, bool erase = true) override
+    {
+        written.apply(names);
+        return true;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(keva_read_cache_lru)
+{
+    const valtype ns = ValtypeFromString("ns");
+    CKevaReadCache cache(0);
+    bool found;
+    CKevaData data;
+
+    // A zero budget disables the cache.
+    cache.set(ns, ValtypeFromString("a"), KevaData(1, "x"));
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+
+    cache.setMaxSize(1 << 20);
+    cache.set(ns, ValtypeFromString("a"), KevaData(1, "x"));
+    cache.setMissing(ns, ValtypeFromString("b"));
+    BOOST_CHECK(cache.get(ns, ValtypeFromString("a"), found, data));
+    BOOST_CHECK(found && data.getValue() == ValtypeFromString("x"));
+    BOOST_CHECK(cache.get(ns, ValtypeFromString("b"), found, data));
+    BOOST_CHECK(!found);
+    BOOST_CHECK(!cache.get(ns, ValtypeFromString("c"), found, data));
+
+    // Shrinking the budget evicts the least recently used entries first.
+    cache.get(ns, ValtypeFromString("a"), found, data);
+    const size_t usage = cache.dynamicMemoryUsage();
+    cache.setMaxSize(usage - 1);
+    BOOST_CHECK(cache.dynamicMemoryUsage() < usage);
+    BOOST_CHECK(cache.get(ns, ValtypeFromString("a"), found, data));
+    BOOST_CHECK(!cache.get(ns, ValtypeFromString("b"), found, data));
+
+    cache.remove(ns, ValtypeFromString("a"));
+    BOOST_CHECK_EQUAL(cache.size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(keva_read_cache_coins_view)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype key = ValtypeFromString("key");
+    KevaCountingView base;
+    CCoinsViewCache tip(&base);
+    tip.SetKevaCacheSize(1 << 20);
+    CKevaData data;
+
+    // Negative lookups are cached.
+    BOOST_CHECK(!tip.GetName(ns, key, data));
+    BOOST_CHECK(!tip.GetName(ns, key, data));
+    BOOST_CHECK_EQUAL(base.reads, 1);
+
+    // A change flushed from a child view invalidates the cached entry.
+    {
+        CCoinsViewCache child(&tip);
+        child.SetKeyValue(ns, key, KevaData(1, "v1"), false, std::nullopt);
+        BOOST_CHECK(child.Flush());
+    }
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK(tip.GetName(ns, key, data));
+    BOOST_CHECK(data.getValue() == ValtypeFromString("v1"));
+    BOOST_CHECK(tip.GetName(ns, key, data));
+    BOOST_CHECK_EQUAL(base.reads, 2);
+
+    // So do changes made directly, e.g. when disconnecting blocks.
+    tip.DeleteKey(ns, key);
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK(!tip.GetName(ns, key, data));
+    BOOST_CHECK_EQUAL(base.reads, 3);
+}
+
+BOOST_AUTO_TEST_CASE(keva_prefetch_names)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype a = ValtypeFromString("a");
+    const valtype b = ValtypeFromString("b");
+    const valtype c = ValtypeFromString("c");
+    KevaCountingView base;
+    {
+        CCoinsViewCache setup(&base);
+        setup.SetKeyValue(ns, a, KevaData(1, "va"), false, std::nullopt);
+        BOOST_CHECK(setup.Flush());
+    }
+    base.reads = 0;
+
+    // Without a read cache there is nowhere to keep the results.
+    CCoinsViewCache tip(&base);
+    tip.PrefetchNames({{ns, a}, {ns, b}});
+    BOOST_CHECK_EQUAL(base.reads, 0);
+
+    // Existing and missing names are both served from the read cache.
+    tip.SetKevaCacheSize(1 << 20);
+    tip.SetKeyValue(ns, c, KevaData(2, "vc"), false, std::nullopt);
+    tip.PrefetchNames({{ns, a}, {ns, b}, {ns, c}});
+    BOOST_CHECK_EQUAL(base.reads, 2);
+    CKevaData data;
+    BOOST_CHECK(tip.GetName(ns, a, data));
+    BOOST_CHECK(data.getValue() == ValtypeFromString("va"));
+    BOOST_CHECK(!tip.GetName(ns, b, data));
+    BOOST_CHECK(tip.GetName(ns, c, data));
+    BOOST_CHECK_EQUAL(base.reads, 2);
+
+    // Names already cached are not read again.
+    tip.PrefetchNames({{ns, a}, {ns, b}});
+    BOOST_CHECK_EQUAL(base.reads, 2);
+
+    // A cache without a read cache passes the names it does not hold on to
+    // its base, so that a block connected through a temporary view on top
+    // of the tip fills the read cache of the tip.
+    const valtype d = ValtypeFromString("d");
+    CCoinsViewCache child(&tip);
+    child.SetKeyValue(ns, a, KevaData(3, "va2"), false, std::nullopt);
+    child.PrefetchNames({{ns, a}, {ns, b}, {ns, d}});
+    BOOST_CHECK_EQUAL(base.reads, 3);
+    BOOST_CHECK(!tip.GetName(ns, d, data));
+    BOOST_CHECK_EQUAL(base.reads, 3);
+}
+
+BOOST_AUTO_TEST_CASE(keva_undo_names)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype a = ValtypeFromString("a");
+    const valtype b = ValtypeFromString("b");
+    CCoinsView dummy;
+    CCoinsViewCache view(&dummy);
+    view.SetKeyValue(ns, a, KevaData(1, "va"), false, std::nullopt);
+
+    // a is updated and b created twice; only b has to be looked up to be undone.
+    CBlockUndo undo;
+    for (const valtype& key : {a, b, b}) {
+        undo.vkevaundo.emplace_back();
+        undo.vkevaundo.back().fromOldState(ns, key, view);
+    }
+    const std::vector<CKevaCache::NamespaceKeyType> names = GetKevaUndoNames(undo);
+    BOOST_REQUIRE_EQUAL(names.size(), 1U);
+    BOOST_CHECK(names[0] == CKevaCache::NamespaceKeyType(ns, b));
+}
+
+BOOST_AUTO_TEST_CASE(keva_tx_outputs)
+{
+    const valtype ns = ValtypeFromString("ns");
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::KEVACOIN_VERSION;
+    mtx.vout.emplace_back(1, CScript() << OP_TRUE);
+    mtx.vout.emplace_back(KEVA_LOCKED_AMOUNT, CKevaScript::buildKevaPut(CScript() << OP_TRUE, ns, ValtypeFromString("k"), ValtypeFromString("v")));
+    // Starts with a keva opcode, but is no valid keva script.
+    mtx.vout.emplace_back(2, CScript() << OP_KEVA_PUT << OP_TRUE);
+
+    const CTransaction tx{mtx};
+    BOOST_REQUIRE_EQUAL(tx.GetKevaOutputs().size(), 1U);
+    BOOST_CHECK_EQUAL(tx.GetKevaOutputs()[0].first, 1U);
+    const CKevaScript& op = tx.GetKevaOutputs()[0].second;
+    BOOST_CHECK(op.isAnyUpdate());
+    BOOST_CHECK(op.getOpNamespace() == ns);
+    BOOST_CHECK(op.getOpValue() == ValtypeFromString("v"));
+    BOOST_CHECK_EQUAL(tx.GetValueOut(/*fExcludeKeva=*/true), 3);
+    BOOST_CHECK(FindKevaOutput(tx) == COutPoint(tx.GetHash(), 1));
+
+    // Copies share the parsed operations.
+    const CTransaction copy{tx};
+    BOOST_CHECK_EQUAL(&copy.GetKevaOutputs(), &tx.GetKevaOutputs());
+
+    // Non-Kevacoin transactions are parsed too, so that consensus can reject them.
+    mtx.nVersion = CTransaction::CURRENT_VERSION;
+    mtx.vout.push_back(mtx.vout[1]);
+    const CTransaction multi{mtx};
+    BOOST_CHECK_EQUAL(multi.GetKevaOutputs().size(), 2U);
+    BOOST_CHECK(!FindKevaOutput(multi));
+
+    mtx.vout.clear();
+    BOOST_CHECK(CTransaction{mtx}.GetKevaOutputs().empty());
+}
+
+BOOST_AUTO_TEST_CASE(keva_tx_memory_usage)
+{
+    const valtype ns = ValtypeFromString("ns");
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::KEVACOIN_VERSION;
+    mtx.vout.emplace_back(1, CScript() << OP_TRUE);
+    mtx.vout.emplace_back(KEVA_LOCKED_AMOUNT, CKevaScript::buildKevaPut(CScript() << OP_TRUE, ns, ValtypeFromString("k"), ValtypeFromString(std::string(1000, 'v'))));
+    const CTransaction tx{mtx};
+    BOOST_REQUIRE_EQUAL(tx.GetKevaOutputs().size(), 1U);
+
+    // The same outputs, with the keva opcode replaced so that nothing is parsed.
+    mtx.vout[1].scriptPubKey[0] = OP_NOP;
+    const CTransaction plain{mtx};
+    BOOST_REQUIRE(plain.GetKevaOutputs().empty());
+
+    // The parsed operations hold their own copy of the arguments.
+    const CKevaScript& op = tx.GetKevaOutputs()[0].second;
+    BOOST_CHECK_GT(op.DynamicMemoryUsage(), 1000U);
+    BOOST_CHECK_EQUAL(RecursiveDynamicUsage(tx),
+                      RecursiveDynamicUsage(plain) + memusage::DynamicUsage(tx.GetSharedKevaOutputs())
+                      + memusage::DynamicUsage(tx.GetKevaOutputs()) + op.DynamicMemoryUsage());
+}
+
+BOOST_AUTO_TEST_CASE(keva_cache_memory_usage)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype other = ValtypeFromString("other");
+    const valtype key = ValtypeFromString("key");
+    CKevaCache cache;
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), 0U);
+
+    cache.set(ns, key, KevaData(1, "short"), std::nullopt);
+    cache.SanityCheck();
+    const size_t usage = cache.DynamicMemoryUsage();
+    BOOST_CHECK(usage > 0);
+
+    // Overwriting tracks the size of the new value.
+    cache.set(ns, key, KevaData(2, std::string(1000, 'x')), std::nullopt);
+    cache.SanityCheck();
+    BOOST_CHECK(cache.DynamicMemoryUsage() >= usage + 900);
+
+    // Deleting replaces the entry by a (smaller) deletion mark.
+    cache.remove(ns, key, std::nullopt);
+    cache.SanityCheck();
+    BOOST_CHECK(cache.DynamicMemoryUsage() < usage + 900);
+
+    cache.associateNamespaces(ns, other, KevaData(3, "assoc"));
+    cache.disassociateNamespaces(other, ns);
+    cache.SanityCheck();
+
+    // Applying changes on top of another cache keeps the accounting intact.
+    CKevaCache parent;
+    parent.set(ns, key, KevaData(1, "old"), std::nullopt);
+    parent.apply(cache);
+    parent.SanityCheck();
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), 0U);
+
+    // Pending keva changes count towards the coins cache size.
+    KevaCountingView base;
+    CCoinsViewCache tip(&base);
+    const size_t empty_usage = tip.DynamicMemoryUsage();
+    tip.SetKeyValue(ns, key, KevaData(1, std::string(1000, 'x')), false, std::nullopt);
+    BOOST_CHECK(tip.KevaChangesMemoryUsage() > 1000);
+    BOOST_CHECK_EQUAL(tip.DynamicMemoryUsage(), empty_usage + tip.KevaChangesMemoryUsage());
+    tip.SanityCheck();
+    BOOST_CHECK(tip.Sync());
+    BOOST_CHECK_EQUAL(tip.KevaChangesMemoryUsage(), 0U);
+    CKevaData data;
+    BOOST_CHECK(tip.GetName(ns, key, data));
+    BOOST_CHECK_EQUAL(data.getValue().size(), 1000U);
+}
+
+/** Keva iterator over a fixed list of keys, sorted as in the database.  */
+class KevaListIterator : public CKevaIterator
+{
+    std::vector<std::pair<valtype, CKevaData>> items;
+    size_t pos{0};
+
+public:
+    KevaListIterator(const valtype& ns, std::vector<std::pair<valtype, CKevaData>> list)
+        : CKevaIterator(ns), items(std::move(list)) {}
+
+    void seek(const valtype& start) override
+    {
+        for (pos = 0; pos < items.size(); ++pos) {
+            const valtype& key = items[pos].first;
+            if (key.size() > start.size() || (key.size() == start.size() && key >= start)) break;
+        }
+    }
+
+    bool next(valtype& key, CKevaData& data) override
+    {
+        if (pos == items.size()) return false;
+        key = items[pos].first;
+        data = items[pos].second;
+        ++pos;
+        return true;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(keva_cache_key_order)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype next = ValtypeFromString("nt");
+    CKevaCache cache;
+
+    // Keys are sorted by length first, namespaces lexicographically.
+    cache.set(ns, ValtypeFromString("aa"), KevaData(1, "aa"), std::nullopt);
+    cache.set(ns, ValtypeFromString("c"), KevaData(1, "c"), std::nullopt);
+    cache.set(next, ValtypeFromString("z"), KevaData(1, "z"), std::nullopt);
+    cache.remove(ns, ValtypeFromString("b"), std::nullopt);
+    BOOST_CHECK(cache.isDeleted(ns, ValtypeFromString("b")));
+    BOOST_CHECK(!cache.isDeleted(next, ValtypeFromString("b")));
+    CKevaData data;
+    BOOST_CHECK(cache.get(ns, ValtypeFromString("c"), data));
+    BOOST_CHECK(!cache.get(ValtypeFromString("n"), ValtypeFromString("sc"), data));
+
+    // Merging with the base iterator skips deleted keys and keeps to the
+    // iterated namespace, even if a later namespace has the same key.
+    std::vector<std::pair<valtype, CKevaData>> base{
+        {ValtypeFromString("a"), KevaData(1, "base")},
+        {ValtypeFromString("b"), KevaData(1, "base")},
+        {ValtypeFromString("z"), KevaData(1, "base")},
+        {ValtypeFromString("aa"), KevaData(1, "base")},
+        {ValtypeFromString("ab"), KevaData(1, "base")},
+    };
+    std::unique_ptr<CKevaIterator> iter(cache.iterateKeys(new KevaListIterator(ns, base)));
+    std::vector<std::string> keys;
+    valtype key;
+    while (iter->next(key, data)) {
+        keys.push_back(ValtypeToString(key) + "=" + ValtypeToString(data.getValue()));
+    }
+    const std::vector<std::string> expected{"a=base", "c=c", "z=base", "aa=aa", "ab=base"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(keva_separate_db)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype key1 = ValtypeFromString("key1");
+    const valtype key2 = ValtypeFromString("key2");
+    const DBParams params{.path = m_path_root / "kevadb_test", .cache_bytes = 1 << 20};
+    CoinsViewOptions options;
+    CKevaData data;
+
+    // Start out with the keva entries in the coins database.
+    {
+        CCoinsViewDB db{params, options};
+        BOOST_CHECK(!db.HasSeparateKevaDB());
+        CCoinsViewCache cache(&db);
+        cache.SetKeyValue(ns, key1, KevaData(1, "v1"), false, std::nullopt);
+        cache.SetBestBlock(uint256::ONE);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    // Enabling the separate database moves them over.
+    options.keva_db = true;
+    {
+        CCoinsViewDB db{params, options};
+        BOOST_CHECK(db.HasSeparateKevaDB());
+        BOOST_CHECK(fs::exists(params.path / "keva"));
+        BOOST_CHECK(db.GetName(ns, key1, data));
+        BOOST_CHECK(data.getValue() == ValtypeFromString("v1"));
+
+        CCoinsViewCache cache(&db);
+        cache.DeleteKey(ns, key1);
+        cache.SetKeyValue(ns, key2, KevaData(2, "v2"), false, std::nullopt);
+        cache.SetBestBlock(uint256S("02"));
+        BOOST_CHECK(cache.Flush());
+    }
+    {
+        CCoinsViewDB db{params, options};
+        BOOST_CHECK(!db.GetName(ns, key1, data));
+        BOOST_CHECK(db.GetName(ns, key2, data));
+        BOOST_CHECK(data.getValue() == ValtypeFromString("v2"));
+        BOOST_CHECK_EQUAL(db.GetBestBlock(), uint256S("02"));
+    }
+
+    // Disabling it again moves the entries back.
+    options.keva_db = false;
+    {
+        CCoinsViewDB db{params, options};
+        BOOST_CHECK(!db.HasSeparateKevaDB());
+        BOOST_CHECK(!fs::exists(params.path / "keva"));
+        BOOST_CHECK(!db.GetName(ns, key1, data));
+        BOOST_CHECK(db.GetName(ns, key2, data));
+        BOOST_CHECK(data.getValue() == ValtypeFromString("v2"));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(keva_height_index)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype other = ValtypeFromString("other");
+    const valtype key1 = ValtypeFromString("key1");
+    const valtype key2 = ValtypeFromString("key2");
+    const DBParams params{.path = m_path_root / "kevaheight_test", .cache_bytes = 1 << 20};
+    const std::set<valtype> none;
+    std::set<valtype> keys;
+    std::set<CKevaCache::NamespaceKeyType> names;
+
+    // A database written before the index existed.
+    {
+        CDBWrapper db{params};
+        db.Write(std::make_pair(uint8_t{'n'}, std::make_pair(ns, key1)), KevaData(5, "v1"));
+    }
+
+    CCoinsViewDB db{params, CoinsViewOptions{}};
+    BOOST_CHECK(db.GetKeysSinceHeight(ns, 5, keys));
+    BOOST_CHECK(keys == std::set<valtype>{key1});
+    keys.clear();
+    BOOST_CHECK(db.GetKeysSinceHeight(ns, 6, keys));
+    BOOST_CHECK(keys == none);
+
+    // Pending changes are applied on top of the index.
+    CCoinsViewCache cache(&db);
+    cache.SetKeyValue(ns, key2, KevaData(10, "v2"), false, std::nullopt);
+    cache.SetKeyValue(other, key1, KevaData(8, "v3"), false, std::nullopt);
+    BOOST_CHECK(cache.GetKeysSinceHeight(ns, 6, keys));
+    BOOST_CHECK(keys == std::set<valtype>{key2});
+    keys.clear();
+    BOOST_CHECK(cache.GetNamesSinceHeight(0, names));
+    BOOST_CHECK_EQUAL(names.size(), 3U);
+    names.clear();
+
+    // Flushing moves the entries of updated keys to their new height.
+    cache.SetKeyValue(ns, key1, KevaData(12, "v4"), false, 5u);
+    cache.SetBestBlock(uint256::ONE);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(db.GetKeysSinceHeight(ns, 11, keys));
+    BOOST_CHECK(keys == std::set<valtype>{key1});
+    keys.clear();
+    BOOST_CHECK(db.GetNamesSinceHeight(9, names));
+    BOOST_CHECK(names == (std::set<CKevaCache::NamespaceKeyType>{{ns, key2}, {ns, key1}}));
+    names.clear();
+
+    // Deleted keys and keys reset to older data (as when disconnecting
+    // blocks) drop out of the range.
+    cache.DeleteKey(ns, key2);
+    cache.SetKeyValue(ns, key1, KevaData(5, "v1"), true, 12u);
+    BOOST_CHECK(cache.GetKeysSinceHeight(ns, 6, keys));
+    BOOST_CHECK(keys == none);
+    cache.SetBestBlock(uint256S("02"));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(db.GetKeysSinceHeight(ns, 0, keys));
+    BOOST_CHECK(keys == std::set<valtype>{key1});
+    keys.clear();
+    BOOST_CHECK(db.GetKeysSinceHeight(ns, 6, keys));
+    BOOST_CHECK(keys == none);
+    BOOST_CHECK(db.GetNamesSinceHeight(6, names));
+    BOOST_CHECK(names == (std::set<CKevaCache::NamespaceKeyType>{{other, key1}}));
+}
+
+BOOST_AUTO_TEST_CASE(keva_snapshot)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const valtype key1 = ValtypeFromString("key1");
+    const valtype key2 = ValtypeFromString("key2");
+    CCoinsViewDB db{{.path = m_path_root / "kevasnapshot_test", .cache_bytes = 1 << 20}, CoinsViewOptions{}};
+    CCoinsViewCache cache(&db);
+    CKevaData data;
+
+    cache.SetKeyValue(ns, key1, KevaData(1, "v1"), false, std::nullopt);
+    cache.SetBestBlock(uint256::ONE);
+    BOOST_CHECK(cache.Flush());
+    cache.SetKeyValue(ns, key2, KevaData(2, "v2"), false, std::nullopt);
+
+    std::unique_ptr<CCoinsView> snapshot{cache.GetKevaSnapshot()};
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK(snapshot->GetName(ns, key1, data));
+    BOOST_CHECK(snapshot->GetName(ns, key2, data));
+
+    // Neither later changes to the cache nor flushing them to the database
+    // are visible through the snapshot.
+    cache.DeleteKey(ns, key1);
+    cache.SetKeyValue(ns, key2, KevaData(3, "v3"), false, 2u);
+    cache.SetBestBlock(uint256S("02"));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!db.GetName(ns, key1, data));
+
+    BOOST_CHECK(snapshot->GetName(ns, key1, data));
+    BOOST_CHECK(data == KevaData(1, "v1"));
+    BOOST_CHECK(snapshot->GetName(ns, key2, data));
+    BOOST_CHECK(data == KevaData(2, "v2"));
+
+    std::unique_ptr<CKevaIterator> iter{snapshot->IterateKeys(ns)};
+    valtype key;
+    size_t count = 0;
+    while (iter->next(key, data)) ++count;
+    BOOST_CHECK_EQUAL(count, 2U);
+
+    // Resizing the database cache does not wait for the snapshot, it is
+    // done with the first flush after the snapshot is released.
+    WITH_LOCK(cs_main, db.ResizeCache(2 << 20));
+    BOOST_CHECK(snapshot->GetName(ns, key2, data));
+    iter.reset();
+    snapshot.reset();
+    cache.SetKeyValue(ns, key1, KevaData(4, "v4"), false, std::nullopt);
+    cache.SetBestBlock(uint256S("03"));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(db.GetName(ns, key1, data));
+    BOOST_CHECK(data == KevaData(4, "v4"));
+    BOOST_CHECK(db.GetName(ns, key2, data));
+    BOOST_CHECK(data == KevaData(3, "v3"));
+}
+
+BOOST_AUTO_TEST_CASE(keva_get_names)
+{
+    const valtype nsA = ValtypeFromString("a");
+    const valtype nsB = ValtypeFromString("bb");
+    const valtype key1 = ValtypeFromString("key1");
+    const valtype key2 = ValtypeFromString("key2");
+    const valtype key3 = ValtypeFromString("k3");
+    CCoinsViewDB db{{.path = m_path_root / "kevagetnames_test", .cache_bytes = 1 << 20}, CoinsViewOptions{}};
+    CCoinsViewCache cache(&db);
+
+    cache.SetKeyValue(nsA, key1, KevaData(1, "a1"), false, std::nullopt);
+    cache.SetKeyValue(nsA, key2, KevaData(2, "a2"), false, std::nullopt);
+    cache.SetKeyValue(nsB, key3, KevaData(3, "b3"), false, std::nullopt);
+    cache.SetBestBlock(uint256::ONE);
+    BOOST_CHECK(cache.Flush());
+
+    // Results follow the request order, not the database order.
+    const std::vector<CKevaCache::NamespaceKeyType> names{{nsB, key3}, {nsA, key2}, {nsB, key1}, {nsA, key1}};
+    auto found = db.GetNames(names);
+    BOOST_REQUIRE_EQUAL(found.size(), 4U);
+    BOOST_CHECK(found[0] == KevaData(3, "b3"));
+    BOOST_CHECK(found[1] == KevaData(2, "a2"));
+    BOOST_CHECK(!found[2]);
+    BOOST_CHECK(found[3] == KevaData(1, "a1"));
+
+    // Unflushed changes of the cache take precedence over the database.
+    cache.DeleteKey(nsA, key2);
+    cache.SetKeyValue(nsB, key1, KevaData(4, "b1"), false, std::nullopt);
+    found = cache.GetNames(names);
+    BOOST_REQUIRE_EQUAL(found.size(), 4U);
+    BOOST_CHECK(found[0] == KevaData(3, "b3"));
+    BOOST_CHECK(!found[1]);
+    BOOST_CHECK(found[2] == KevaData(4, "b1"));
+    BOOST_CHECK(found[3] == KevaData(1, "a1"));
+
+    const std::unique_ptr<CCoinsView> snapshot{cache.GetKevaSnapshot()};
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK(snapshot->GetNames(names) == found);
+}
+
+/** A namespace id that can be referred to by a "_g:" key.  */
+static valtype KevaGroupNamespace(unsigned char id)
+{
+    valtype nameSpace = Params().Base58Prefix(CChainParams::KEVA_NAMESPACE);
+    nameSpace.insert(nameSpace.end(), 20, id);
+    return nameSpace;
+}
+
+static valtype KevaGroupKey(const valtype& nameSpace)
+{
+    return ValtypeFromString(CKevaData::ASSOCIATE_PREFIX + EncodeBase58Check(nameSpace));
+}
+
+BOOST_AUTO_TEST_CASE(keva_group_cache)
+{
+    const valtype nsA = KevaGroupNamespace(1);
+    const valtype nsB = KevaGroupNamespace(2);
+    const valtype nsC = KevaGroupNamespace(3);
+    const valtype displayKey = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
+    CCoinsViewDB db{{.path = m_path_root / "kevagroup_test", .cache_bytes = 1 << 20}, CoinsViewOptions{}};
+    CCoinsViewCache tip(&db);
+    tip.SetKevaGroupCacheSize(1 << 20);
+
+    for (const valtype& ns : {nsA, nsB, nsC}) {
+        tip.SetKeyValue(ns, displayKey, KevaData(1, "name"), false, std::nullopt);
+    }
+    tip.SetKeyValue(nsA, KevaGroupKey(nsB), KevaData(2, "a"), false, std::nullopt);
+    tip.SetKeyValue(nsA, ValtypeFromString("other"), KevaData(2, "x"), false, std::nullopt);
+    tip.SetBestBlock(uint256::ONE);
+    BOOST_CHECK(tip.Flush());
+
+    // Groups are loaded in both directions.
+    CKevaGroup groupA = tip.GetNamespaceGroup(nsA);
+    BOOST_REQUIRE_EQUAL(groupA.joined.size(), 1U);
+    BOOST_CHECK(groupA.joined.begin()->first == KevaGroupKey(nsB));
+    BOOST_CHECK(groupA.joined.begin()->second.first == nsB);
+    BOOST_CHECK(groupA.members.empty());
+    CKevaGroup groupB = tip.GetNamespaceGroup(nsB);
+    BOOST_CHECK(groupB.joined.empty());
+    BOOST_REQUIRE_EQUAL(groupB.members.size(), 1U);
+    BOOST_CHECK(groupB.members.begin()->first == nsA);
+
+    // Changes written through a child view, as when connecting a block,
+    // update the cached groups.
+    {
+        CCoinsViewCache child(&tip);
+        child.SetKeyValue(nsC, KevaGroupKey(nsB), KevaData(3, "c"), false, std::nullopt);
+        child.DeleteKey(nsA, KevaGroupKey(nsB));
+        BOOST_CHECK(child.Flush());
+    }
+    groupA = tip.GetNamespaceGroup(nsA);
+    BOOST_CHECK(groupA.joined.empty());
+    groupB = tip.GetNamespaceGroup(nsB);
+    BOOST_REQUIRE_EQUAL(groupB.members.size(), 1U);
+    BOOST_CHECK(groupB.members.begin()->first == nsC);
+    BOOST_CHECK(groupB.members.begin()->second == KevaData(3, "c"));
+
+    // The cached groups match groups loaded from scratch, and those built
+    // from a snapshot.
+    tip.SetBestBlock(uint256S("02"));
+    BOOST_CHECK(tip.Flush());
+    CCoinsViewCache fresh(&db);
+    const std::unique_ptr<CCoinsView> snapshot{fresh.GetKevaSnapshot()};
+    for (const valtype& ns : {nsA, nsB, nsC}) {
+        const CKevaGroup cached = tip.GetNamespaceGroup(ns);
+        const CKevaGroup loaded = fresh.GetNamespaceGroup(ns);
+        BOOST_CHECK(cached.joined == loaded.joined);
+        BOOST_CHECK(cached.members == loaded.members);
+        const CKevaGroup built = BuildNamespaceGroup(*snapshot, ns);
+        BOOST_CHECK(cached.joined == built.joined);
+        BOOST_CHECK(cached.members == built.members);
+    }
+
+    // Pending group changes are indexed in the mempool.
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    CKevaMemPool kevaPool(pool);
+    LOCK(pool.cs);
+    kevaPool.addUnchecked(uint256::ONE, KevaPut(nsA, "plain", "v"));
+    kevaPool.addUnchecked(uint256S("02"), CKevaScript(CKevaScript::buildKevaPut(CScript() << OP_TRUE, nsA, KevaGroupKey(nsC), ValtypeFromString("g"))));
+    kevaPool.addUnchecked(uint256S("03"), CKevaScript(CKevaScript::buildKevaDelete(CScript() << OP_TRUE, nsA, KevaGroupKey(nsB))));
+    std::vector<std::tuple<valtype, valtype, valtype>> pending;
+    kevaPool.getUnconfirmedGroupKeys(nsA, pending);
+    BOOST_REQUIRE_EQUAL(pending.size(), 2U);
+    for (const auto& [key, target, value] : pending) {
+        BOOST_CHECK(key == KevaGroupKey(target));
+        BOOST_CHECK_EQUAL(value.empty(), target == nsB);
+    }
+
+    kevaPool.remove(uint256S("02"));
+    kevaPool.remove(uint256S("03"));
+    pending.clear();
+    kevaPool.getUnconfirmedGroupKeys(nsA, pending);
+    BOOST_CHECK(pending.empty());
+}
+
+BOOST_AUTO_TEST_CASE(keva_snapshot_section)
+{
+    const valtype nsA = ValtypeFromString("nsA");
+    const valtype nsB = ValtypeFromString("nsB");
+    const valtype key1 = ValtypeFromString("key1");
+    const valtype key2 = ValtypeFromString("key2");
+    CCoinsViewDB from{{.path = m_path_root / "kevasection_from", .cache_bytes = 1 << 20}, CoinsViewOptions{}};
+    {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap coins{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
+        CKevaCache names;
+        names.set(nsA, key1, KevaData(1, "a1"), std::nullopt);
+        names.set(nsA, key2, KevaData(2, "a2"), std::nullopt);
+        names.set(nsB, key1, KevaData(3, "b1"), std::nullopt);
+        names.associateNamespaces(nsB, nsA, KevaData(3, "assoc"));
+        BOOST_CHECK(from.BatchWrite(coins, uint256::ONE, names));
+    }
+
+    // Entries come first, then associations.
+    std::vector<std::tuple<bool, valtype, valtype, CKevaData>> records;
+    bool association;
+    valtype nameSpace;
+    valtype key;
+    CKevaData data;
+    for (auto cursor{from.KevaCursor()}; cursor->Valid(); cursor->Next()) {
+        BOOST_REQUIRE(cursor->GetKey(association, nameSpace, key));
+        BOOST_REQUIRE(cursor->GetValue(data));
+        records.emplace_back(association, nameSpace, key, data);
+    }
+    BOOST_REQUIRE_EQUAL(records.size(), 4U);
+    BOOST_CHECK(!std::get<0>(records[2]));
+    BOOST_CHECK(std::get<0>(records[3]));
+
+    const fs::path path = m_path_root / "kevasection.dat";
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        node::SnapshotKevaWriter writer{file, records.size()};
+        for (const auto& [a, n, k, d] : records) writer.Write(a, n, k, d);
+    }
+
+    // Load the records into another database and read them back.
+    CCoinsViewDB to{{.path = m_path_root / "kevasection_to", .cache_bytes = 1 << 20}, CoinsViewOptions{.keva_db = true}};
+    {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        std::array<uint8_t, 4> magic;
+        file >> magic;
+        BOOST_CHECK(magic == node::SNAPSHOT_KEVA_MAGIC);
+        uint64_t count;
+        node::SnapshotKevaReader reader{file, count};
+        BOOST_REQUIRE_EQUAL(count, records.size());
+        CKevaDBLoader loader{to};
+        for (uint64_t i = 0; i < count; ++i) {
+            reader.Read(association, nameSpace, key, data);
+            loader.Add(association, nameSpace, key, data);
+        }
+        loader.Commit();
+        uint8_t left_over;
+        BOOST_CHECK_THROW(file >> left_over, std::ios_base::failure);
+    }
+
+    size_t i = 0;
+    for (auto cursor{to.KevaCursor()}; cursor->Valid(); cursor->Next(), ++i) {
+        BOOST_REQUIRE(i < records.size());
+        BOOST_REQUIRE(cursor->GetKey(association, nameSpace, key));
+        BOOST_REQUIRE(cursor->GetValue(data));
+        BOOST_CHECK(std::make_tuple(association, nameSpace, key, data) == records[i]);
+    }
+    BOOST_CHECK_EQUAL(i, records.size());
+
+    // The height index is written along with the entries.
+    std::set<valtype> keys;
+    BOOST_CHECK(to.GetKeysSinceHeight(nsA, 2, keys));
+    BOOST_CHECK(keys == std::set<valtype>{key2});
+}
+
+static uint256 KevaEntriesHash(const CCoinsView& view)
+{
+    MuHash3072 muhash;
+    bool association;
+    valtype nameSpace;
+    valtype key;
+    CKevaData data;
+    for (auto cursor{view.KevaCursor()}; cursor->Valid(); cursor->Next()) {
+        BOOST_REQUIRE(cursor->GetKey(association, nameSpace, key));
+        BOOST_REQUIRE(cursor->GetValue(data));
+        if (!association) kernel::ApplyKevaEntryHash(muhash, nameSpace, key, data);
+    }
+    uint256 out;
+    muhash.Finalize(out);
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(keva_entry_changes)
+{
+    const valtype ns = ValtypeFromString("ns");
+    CCoinsViewDB db{{.path = m_path_root / "kevachanges_test", .cache_bytes = 1 << 20}, CoinsViewOptions{}};
+    {
+        CCoinsViewCache cache(&db);
+        cache.SetKeyValue(ns, ValtypeFromString("a"), KevaData(1, "a0"), false, std::nullopt);
+        cache.SetKeyValue(ns, ValtypeFromString("b"), KevaData(1, "b0"), false, std::nullopt);
+        cache.SetBestBlock(uint256::ONE);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.ValidateKevaDB());
+    MuHash3072 muhash;
+    kernel::ApplyKevaEntryHash(muhash, ns, ValtypeFromString("a"), KevaData(1, "a0"));
+    kernel::ApplyKevaEntryHash(muhash, ns, ValtypeFromString("b"), KevaData(1, "b0"));
+    uint256 out;
+    muhash.Finalize(out);
+    BOOST_CHECK(out == KevaEntriesHash(db));
+
+    // "a" is updated twice, "b" deleted, "c" created, and "d" created and
+    // deleted again within the block.
+    const auto put = [&](const std::string& key, const std::string& value) {
+        return CKevaScript::buildKevaPut(CScript() << OP_TRUE, ns, ValtypeFromString(key), ValtypeFromString(value));
+    };
+    const auto del = [&](const std::string& key) {
+        return CKevaScript::buildKevaDelete(CScript() << OP_TRUE, ns, ValtypeFromString(key));
+    };
+    CBlock block;
+    for (const CScript& script : {put("a", "a1"), put("a", "a2"), del("b"), put("c", "c1"), put("d", "d1"), del("d")}) {
+        CMutableTransaction mtx;
+        mtx.nVersion = CTransaction::KEVACOIN_VERSION;
+        mtx.vout.emplace_back(KEVA_LOCKED_AMOUNT, script);
+        block.vtx.push_back(MakeTransactionRef(mtx));
+    }
+
+    CBlockUndo undo;
+    {
+        CCoinsViewCache cache(&db);
+        CKevaNotifier notifier{nullptr};
+        for (const CTransactionRef& tx : block.vtx) ApplyKevaTransaction(tx, 5, cache, undo, notifier);
+        cache.SetBestBlock(uint256S("02"));
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.ValidateKevaDB());
+
+    const std::vector<CKevaEntryChange> changes{GetKevaEntryChanges(block, undo, 5)};
+    BOOST_REQUIRE_EQUAL(changes.size(), 3U);
+    BOOST_CHECK(changes[0].key == ValtypeFromString("a"));
+    BOOST_CHECK(changes[0].oldData == KevaData(1, "a0"));
+    BOOST_REQUIRE(changes[0].newData);
+    BOOST_CHECK(changes[0].newData->getValue() == ValtypeFromString("a2"));
+    BOOST_CHECK(changes[0].newData->getUpdateOutpoint() == COutPoint(block.vtx[1]->GetHash(), 0));
+    BOOST_CHECK(changes[1].key == ValtypeFromString("b"));
+    BOOST_CHECK(changes[1].oldData == KevaData(1, "b0"));
+    BOOST_CHECK(!changes[1].newData);
+    BOOST_CHECK(changes[2].key == ValtypeFromString("c"));
+    BOOST_CHECK(!changes[2].oldData);
+    BOOST_CHECK(changes[2].newData);
+
+    // Applying the changes incrementally matches a full rescan.
+    for (const CKevaEntryChange& change : changes) {
+        if (change.oldData) kernel::RemoveKevaEntryHash(muhash, change.nameSpace, change.key, *change.oldData);
+        if (change.newData) kernel::ApplyKevaEntryHash(muhash, change.nameSpace, change.key, *change.newData);
+    }
+    muhash.Finalize(out);
+    BOOST_CHECK(out == KevaEntriesHash(db));
+}
+
+BOOST_AUTO_TEST_CASE(keva_validate_db)
+{
+    const valtype ns = ValtypeFromString("ns");
+    const DBParams params{.path = m_path_root / "kevavalidate_test", .cache_bytes = 1 << 20};
+
+    // An entry without its height index records.
+    {
+        CDBWrapper db{params};
+        db.Write(std::make_pair(uint8_t{'n'}, std::make_pair(ns, ValtypeFromString("key"))), KevaData(5, "v1"));
+        db.Write(uint8_t{'V'}, int{1});
+    }
+    CCoinsViewDB db{params, CoinsViewOptions{}};
+    BOOST_CHECK(!db.ValidateKevaDB());
+
+    // The view forwards to its backing database.
+    CCoinsViewCache cache(&db);
+    BOOST_CHECK(!cache.ValidateKevaDB());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
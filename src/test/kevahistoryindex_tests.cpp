@@ -0,0 +1,151 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <coins.h>
+#include <index/kevahistoryindex.h>
+#include <interfaces/chain.h>
+#include <keva/common.h>
+#include <keva/main.h>
+#include <script/keva.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(kevahistoryindex_tests)
+
+/** Build a keva transaction spending the first output of prev into the keva script.  */
+static CMutableTransaction KevaSpend(const CTransactionRef& prev, const CScript& kevaScript)
+{
+    CMutableTransaction mtx;
+    mtx.SetKevacoin();
+    mtx.vin.emplace_back(COutPoint(prev->GetHash(), 0));
+    mtx.vout.emplace_back(prev->vout[0].nValue - 10000, kevaScript);
+    return mtx;
+}
+
+BOOST_FIXTURE_TEST_CASE(kevahistoryindex_initial_sync, TestChain100Setup)
+{
+    const CScript addr = CScript() << OP_TRUE;
+    const valtype key = ValtypeFromString("key");
+
+    // Register a namespace from a coinbase output and put the key in the same block.
+    CMutableTransaction reg;
+    reg.SetKevacoin();
+    reg.vin.emplace_back(COutPoint(m_coinbase_txns[0]->GetHash(), 0));
+    valtype nameSpace;
+    CKevaScript::generateNamespace(reg.vin[0].prevout.hash, reg.vin[0].prevout.n, nameSpace, Params(), true);
+    reg.vout.emplace_back(m_coinbase_txns[0]->vout[0].nValue - 10000,
+                          CKevaScript::buildKevaNamespace(addr, nameSpace, ValtypeFromString("name")));
+    {
+        FillableSigningProvider keystore;
+        BOOST_REQUIRE(keystore.AddKey(coinbaseKey));
+        std::map<COutPoint, Coin> coins;
+        coins[reg.vin[0].prevout] = Coin(m_coinbase_txns[0]->vout[0], 1, /*fCoinBaseIn=*/true);
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(reg, &keystore, coins, SIGHASH_ALL, input_errors));
+    }
+    const CTransactionRef regTx = MakeTransactionRef(reg);
+    const CMutableTransaction put1 = KevaSpend(regTx, CKevaScript::buildKevaPut(addr, nameSpace, key, ValtypeFromString("v1")));
+    const CTransactionRef put1Tx = MakeTransactionRef(put1);
+    CreateAndProcessBlock({reg, put1}, CScript() << OP_TRUE);
+
+    // Update the key, then delete it in the next block.
+    const CMutableTransaction put2 = KevaSpend(put1Tx, CKevaScript::buildKevaPut(addr, nameSpace, key, ValtypeFromString("v2")));
+    CreateAndProcessBlock({put2}, CScript() << OP_TRUE);
+    const CMutableTransaction del = KevaSpend(MakeTransactionRef(put2), CKevaScript::buildKevaDelete(addr, nameSpace, key));
+    CreateAndProcessBlock({del}, CScript() << OP_TRUE);
+    BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return m_node.chainman->ActiveHeight()), 103);
+    {
+        LOCK(cs_main);
+        CKevaData data;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().CoinsTip().GetNamespace(nameSpace, data));
+        BOOST_CHECK(!m_node.chainman->ActiveChainstate().CoinsTip().GetName(nameSpace, key, data));
+    }
+
+    KevaHistoryIndex index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(index.Init());
+
+    // BlockUntilSyncedToCurrentChain should return false before the index is started.
+    BOOST_CHECK(!index.BlockUntilSyncedToCurrentChain());
+
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown));
+
+    {
+        LOCK(cs_main);
+        BOOST_CHECK_EQUAL(index.GetSummary().best_block_height, m_node.chainman->ActiveHeight());
+    }
+
+    // The registration is recorded as a put of the display name key.
+    std::vector<KevaHistoryEntry> entries;
+    BOOST_CHECK(!index.FindHistory(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), {0, 0}, 10, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK_EQUAL(entries[0].height, 101U);
+    BOOST_CHECK(entries[0].outpoint == COutPoint(regTx->GetHash(), 0));
+    BOOST_CHECK(entries[0].value == ValtypeFromString("name"));
+
+    // All operations on the key, oldest first.
+    entries.clear();
+    BOOST_CHECK(!index.FindHistory(nameSpace, key, {0, 0}, 10, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 3U);
+    BOOST_CHECK_EQUAL(entries[0].height, 101U);
+    BOOST_CHECK_EQUAL(entries[0].seq, 1U);
+    BOOST_CHECK(entries[0].outpoint == COutPoint(put1Tx->GetHash(), 0));
+    BOOST_CHECK(!entries[0].deleted);
+    BOOST_CHECK(entries[0].value == ValtypeFromString("v1"));
+    BOOST_CHECK_EQUAL(entries[1].height, 102U);
+    BOOST_CHECK(entries[1].value == ValtypeFromString("v2"));
+    BOOST_CHECK_EQUAL(entries[2].height, 103U);
+    BOOST_CHECK(entries[2].outpoint == COutPoint(del.GetHash(), 0));
+    BOOST_CHECK(entries[2].deleted);
+    BOOST_CHECK(entries[2].value.empty());
+
+    // Paging resumes after the last returned operation.
+    entries.clear();
+    BOOST_CHECK(index.FindHistory(nameSpace, key, {0, 0}, 2, entries));
+    BOOST_CHECK_EQUAL(entries.size(), 2U);
+    entries.clear();
+    BOOST_CHECK(!index.FindHistory(nameSpace, key, {103, 0}, 2, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 1U);
+    BOOST_CHECK(entries[0].deleted);
+
+    // The operations of a block that is reorged out are removed from the
+    // index.  The index rewinds once the block of the new chain is connected.
+    BlockValidationState state;
+    CBlockIndex* tip = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip());
+    BOOST_CHECK(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    CBlockIndex* fork_tip = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip());
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(index.GetSummary().best_block_hash == fork_tip->GetBlockHash());
+    entries.clear();
+    BOOST_CHECK(!index.FindHistory(nameSpace, key, {0, 0}, 10, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    BOOST_CHECK(entries[1].value == ValtypeFromString("v2"));
+
+    // Reorging back adds them again.
+    BOOST_CHECK(m_node.chainman->ActiveChainstate().InvalidateBlock(state, fork_tip));
+    {
+        LOCK(cs_main);
+        m_node.chainman->ActiveChainstate().ResetBlockFailureFlags(tip);
+    }
+    BOOST_CHECK(m_node.chainman->ActiveChainstate().ActivateBestChain(state));
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(index.GetSummary().best_block_hash == tip->GetBlockHash());
+    entries.clear();
+    BOOST_CHECK(!index.FindHistory(nameSpace, key, {0, 0}, 10, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), 3U);
+    BOOST_CHECK(entries[2].deleted);
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,66 @@
+// Copyright (c) 2026 The Kevacoin Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/kevastatsindex.h>
+#include <interfaces/chain.h>
+#include <kernel/coinstats.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(kevastatsindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(kevastatsindex_initial_sync, TestChain100Setup)
+{
+    KevaStatsIndex index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(index.Init());
+
+    const CBlockIndex* tip = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip());
+
+    // The index has no stats before it is started.
+    BOOST_CHECK(!index.LookUpStats(*tip));
+    BOOST_CHECK(!index.BlockUntilSyncedToCurrentChain());
+
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown));
+
+    // The index matches a full scan of the keva database.
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    chainstate.ForceFlushStateToDisk();
+    CCoinsView* view = WITH_LOCK(cs_main, return &chainstate.CoinsDB());
+    const auto scanned{kernel::ComputeKevaStats(view, chainstate.m_blockman)};
+    BOOST_REQUIRE(scanned);
+    BOOST_CHECK(!scanned->index_used);
+    const auto indexed{index.LookUpStats(*tip)};
+    BOOST_REQUIRE(indexed);
+    BOOST_CHECK(indexed->index_used);
+    BOOST_CHECK_EQUAL(indexed->nHeight, scanned->nHeight);
+    BOOST_CHECK(indexed->hashBlock == scanned->hashBlock);
+    BOOST_CHECK_EQUAL(indexed->entries_count, scanned->entries_count);
+    BOOST_CHECK(indexed->muhash == scanned->muhash);
+
+    // Rewinding and reconnecting blocks keeps the index consistent.
+    {
+        BlockValidationState state;
+        CBlockIndex* old_tip = WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip());
+        BOOST_CHECK(chainstate.InvalidateBlock(state, old_tip));
+        {
+            LOCK(cs_main);
+            chainstate.ResetBlockFailureFlags(old_tip);
+        }
+        BOOST_CHECK(chainstate.ActivateBestChain(state));
+        BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+        BOOST_CHECK_EQUAL(index.GetSummary().best_block_height, 100);
+        const auto reconnected{index.LookUpStats(*old_tip)};
+        BOOST_REQUIRE(reconnected);
+        BOOST_CHECK(reconnected->muhash == indexed->muhash);
+    }
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,14 +8,19 @@
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
+#include <keva/common.h>
 #include <node/miner.h>
 #include <policy/policy.h>
+#include <script/keva.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <test/util/random.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util/strencodings.h>
 #include <util/time.h>
+#include <util/translation.h>
 #include <validation.h>
 #include <versionbits.h>
 
@@ -33,6 +38,7 @@ struct MinerTestingSetup : public TestingSetup {
     void TestPackageSelection(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     void TestBasicMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst, int baseheight) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     void TestPrioritisedMining(const CScript& scriptPubKey, const std::vector<CTransactionRef>& txFirst) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    void TestKevaChainSelection(const CScript& scriptPubKey) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool TestSequenceLocks(const CTransaction& tx, CTxMemPool& tx_mempool) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
     {
         CCoinsViewMemPool view_mempool{&m_node.chainman->ActiveChainstate().CoinsTip(), tx_mempool};
@@ -599,6 +605,53 @@ void MinerTestingSetup::TestPrioritisedMining(const CScript& scriptPubKey, const
     }
 }
 
+// Test that the updates of a namespace are selected together with the
+// package they extend, as long as they pay at least its feerate.
+void MinerTestingSetup::TestKevaChainSelection(const CScript& scriptPubKey)
+{
+    CTxMemPool& tx_mempool{MakeMempool()};
+    LOCK(tx_mempool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const valtype nameSpace{ValtypeFromString("namespace")};
+    const CAmount fees[]{20000, 2000, 40000, 500};
+    std::vector<Txid> kevaTxs;
+    // The block is not validated, so the coins spent need not exist.
+    COutPoint prevout{Txid::FromUint256(InsecureRand256()), 0};
+    CAmount value{5000000000LL};
+    for (size_t i = 0; i < std::size(fees); ++i) {
+        CMutableTransaction tx;
+        tx.SetKevacoin();
+        tx.vin.emplace_back(prevout);
+        value -= fees[i];
+        tx.vout.emplace_back(value, CKevaScript::buildKevaPut(CScript() << OP_TRUE, nameSpace,
+                                                              ValtypeFromString("key" + ToString(i)), ValtypeFromString("value")));
+        kevaTxs.push_back(tx.GetHash());
+        tx_mempool.addUnchecked(entry.Fee(fees[i]).Time(Now<NodeSeconds>()).SpendsCoinbase(i == 0).FromTx(tx));
+        prevout = COutPoint{tx.GetHash(), 0};
+    }
+
+    // A smaller transaction with a feerate between the namespace updates.
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint{Txid::FromUint256(InsecureRand256()), 0}, CScript() << OP_1);
+    tx.vout.emplace_back(5000000000LL - 5000, CScript() << OP_1);
+    const Txid hashPlainTx{tx.GetHash()};
+    tx_mempool.addUnchecked(entry.Fee(5000).Time(Now<NodeSeconds>()).SpendsCoinbase(true).FromTx(tx));
+
+    BlockAssembler::Options options;
+    options.blockMinFeeRate = blockMinFeeRate;
+    options.test_block_validity = false;
+    auto pblocktemplate = BlockAssembler{m_node.chainman->ActiveChainstate(), &tx_mempool, options}.CreateNewBlock(scriptPubKey);
+    BOOST_REQUIRE_EQUAL(pblocktemplate->block.vtx.size(), 6U);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == kevaTxs[0]);
+    BOOST_CHECK(pblocktemplate->block.vtx[2]->GetHash() == kevaTxs[1]);
+    BOOST_CHECK(pblocktemplate->block.vtx[3]->GetHash() == kevaTxs[2]);
+    // The last update pays less than the package it extends.
+    BOOST_CHECK(pblocktemplate->block.vtx[4]->GetHash() == hashPlainTx);
+    BOOST_CHECK(pblocktemplate->block.vtx[5]->GetHash() == kevaTxs[3]);
+    BOOST_CHECK_EQUAL(BlockAssembler::m_last_block_num_keva_ops.value(), 4);
+}
+
 // NOTE: These tests rely on CreateNewBlock doing its own self-validation!
 BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
 {
@@ -654,4 +707,111 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     TestPrioritisedMining(scriptPubKey, txFirst);
 }
 
+BOOST_AUTO_TEST_CASE(KevaChainSelection)
+{
+    LOCK(cs_main);
+    TestKevaChainSelection(CScript() << OP_TRUE);
+}
+
+struct KevaChainLimitSetup : public TestChain100Setup {
+    KevaChainLimitSetup() : TestChain100Setup{ChainType::REGTEST, {"-limitkevachaincount=40", "-acceptnonstdtxn=1"}} {}
+};
+
+// Test that chains of namespace updates are limited by -limitkevachaincount
+// instead of -limitancestorcount.
+BOOST_FIXTURE_TEST_CASE(KevaChainLimit, KevaChainLimitSetup)
+{
+    const CScript addr = CScript() << OP_TRUE;
+
+    // Register a namespace from a coinbase output.
+    CMutableTransaction reg;
+    reg.SetKevacoin();
+    reg.vin.emplace_back(COutPoint(m_coinbase_txns[0]->GetHash(), 0));
+    valtype nameSpace;
+    CKevaScript::generateNamespace(reg.vin[0].prevout.hash, reg.vin[0].prevout.n, nameSpace, Params(), true);
+    reg.vout.emplace_back(m_coinbase_txns[0]->vout[0].nValue - 10000,
+                          CKevaScript::buildKevaNamespace(addr, nameSpace, ValtypeFromString("name")));
+    {
+        FillableSigningProvider keystore;
+        BOOST_REQUIRE(keystore.AddKey(coinbaseKey));
+        std::map<COutPoint, Coin> coins;
+        coins[reg.vin[0].prevout] = Coin(m_coinbase_txns[0]->vout[0], 1, /*fCoinBaseIn=*/true);
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(reg, &keystore, coins, SIGHASH_ALL, input_errors));
+    }
+    CreateAndProcessBlock({reg}, addr);
+
+    // Chain updates of the namespace, each spending the keva output of the
+    // previous one.
+    LOCK(cs_main);
+    CTransactionRef prev{MakeTransactionRef(reg)};
+    for (int i = 0; i <= 40; ++i) {
+        CMutableTransaction tx;
+        tx.SetKevacoin();
+        tx.vin.emplace_back(COutPoint(prev->GetHash(), 0));
+        tx.vout.emplace_back(prev->vout[0].nValue - 10000,
+                             CKevaScript::buildKevaPut(addr, nameSpace, ValtypeFromString("key" + ToString(i)), ValtypeFromString("value")));
+        prev = MakeTransactionRef(tx);
+        const MempoolAcceptResult result{m_node.chainman->ProcessTransaction(prev)};
+        if (i < 40) {
+            BOOST_CHECK_MESSAGE(result.m_result_type == MempoolAcceptResult::ResultType::VALID, result.m_state.ToString());
+        } else {
+            BOOST_CHECK(result.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+            BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "too-long-mempool-chain");
+        }
+    }
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 40U);
+}
+
+BOOST_FIXTURE_TEST_CASE(CryptoNoteTemplate, RegTestingSetup)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler{m_node.chainman->ActiveChainstate(), m_node.mempool.get()}.CreateNewBlock(scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    const int height{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Height() + 1)};
+
+    const auto tmpl{node::MakeCryptoNoteTemplate(pblocktemplate->block, height, Params().GetConsensus(), node::DEFAULT_CN_RESERVE_SIZE)};
+    BOOST_CHECK_EQUAL(tmpl.block.nNonce, uint32_t(height));
+    BOOST_CHECK(tmpl.block.hashMerkleRoot == BlockMerkleRoot(tmpl.block));
+    BOOST_CHECK(tmpl.block.isCNConsistent());
+
+    // The extra nonce ends up at reserved_offset of the serialized block.
+    const std::vector<unsigned char> extra_nonce{ParseHex("0102030405")};
+    auto pblock{std::make_shared<CBlock>(tmpl.block)};
+    node::SetCryptoNoteNonce(tmpl, *pblock, extra_nonce, 0xdeadbeef);
+    BOOST_CHECK_EQUAL(pblock->cnHeader.nonce, 0xdeadbeef);
+    BOOST_CHECK_EQUAL(pblock->nNonce, uint32_t(height));
+    BOOST_CHECK(pblock->hashMerkleRoot == BlockMerkleRoot(*pblock));
+    BOOST_CHECK(pblock->isCNConsistent());
+
+    DataStream ss;
+    ss << TX_WITH_WITNESS(*pblock);
+    BOOST_REQUIRE(ss.size() >= tmpl.reserved_offset + tmpl.reserve_size);
+    const auto reserved{MakeUCharSpan(ss).subspan(tmpl.reserved_offset, tmpl.reserve_size)};
+    std::vector<unsigned char> expected{extra_nonce};
+    expected.resize(tmpl.reserve_size, 0);
+    BOOST_CHECK(std::vector<unsigned char>(reserved.begin(), reserved.end()) == expected);
+
+    // A solved template is accepted as the new tip.
+    for (uint32_t nonce = 0; !CheckProofOfWork(*pblock, pblock->nBits, Params().GetConsensus()); ++nonce) {
+        node::SetCryptoNoteNonce(tmpl, *pblock, extra_nonce, nonce);
+    }
+    BOOST_CHECK(Assert(m_node.chainman)->ProcessNewBlock(pblock, /*force_processing=*/true, /*min_pow_checked=*/true, nullptr));
+    BOOST_CHECK_EQUAL(WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()), pblock->GetHash());
+
+    // The merkle branch of the coinbase covers any number of transactions.
+    for (size_t num_txs = 2; num_txs <= 7; ++num_txs) {
+        CBlock block{pblocktemplate->block};
+        for (size_t i = 1; i < num_txs; ++i) {
+            CMutableTransaction tx;
+            tx.nLockTime = i;
+            block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+        }
+        const auto tmpl_txs{node::MakeCryptoNoteTemplate(block, height, Params().GetConsensus(), 4)};
+        CBlock solved{tmpl_txs.block};
+        node::SetCryptoNoteNonce(tmpl_txs, solved, ParseHex("ffffffff"), 1);
+        BOOST_CHECK(solved.hashMerkleRoot == BlockMerkleRoot(solved));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
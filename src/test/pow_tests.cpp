@@ -5,6 +5,9 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <pow.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <validation.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <util/chaintype.h>
@@ -156,6 +159,35 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(pow_seed_hash_table)
+{
+    std::vector<CBlockIndex> blocks(2200);
+    std::vector<uint256> hashes(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        hashes[i] = InsecureRand256();
+        blocks[i].phashBlock = &hashes[i];
+        blocks[i].BuildSkip();
+    }
+
+    // The next block on top of blocks.back(), whose RandomX seed is block 2048.
+    CBlockHeader header;
+    header.nTime = 1600000000;
+    header.nBits = 0x207fffff;
+    header.nNonce = blocks.size();
+    header.cnHeader.major_version = RX_BLOCK_VERSION;
+    header.cnHeader.prev_id = header.GetOriginalBlockHash();
+    BOOST_REQUIRE_EQUAL(crypto::rx_seedheight(header.nNonce), 2048U);
+
+    LOCK(cs_main);
+    UpdatePoWSeedHashes(&blocks.back());
+    const uint256 hash = GetPoWHash(header);
+    BOOST_CHECK_EQUAL(hash, GetPoWHash(header, hashes[2048]));
+    BOOST_CHECK(hash != GetPoWHash(header, hashes[0]));
+    UpdatePoWSeedHashes(nullptr);
+}
+
 void sanity_check_chainparams(const ArgsManager& args, ChainType chain_type)
 {
     const auto chainParams = CreateChainParams(args, chain_type);
@@ -203,4 +235,78 @@ BOOST_AUTO_TEST_CASE(ChainParams_SIGNET_sanity)
     sanity_check_chainparams(*m_node.args, ChainType::SIGNET);
 }
 
+BOOST_AUTO_TEST_CASE(cryptonote_header_blob)
+{
+    CryptoNoteHeader header;
+    header.major_version = 12;
+    header.minor_version = 0x80;
+    header.timestamp = 1600000000;
+    header.prev_id = InsecureRand256();
+    header.nonce = 0x12345678;
+    header.merkle_root = InsecureRand256();
+    header.nTxes = 300;
+
+    // The fixed buffer serialization matches binary_archive.
+    unsigned char blob[CryptoNoteHeader::MAX_BLOB_SIZE];
+    const size_t size = header.WriteBlob(blob);
+    BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char*>(blob), size),
+                      cryptonote::t_serializable_object_to_blob(header));
+
+    DataStream ss;
+    ss << header;
+    CryptoNoteHeader read;
+    ss >> read;
+    BOOST_CHECK(read == header);
+
+    // Truncated blobs and blobs with trailing data are left to binary_archive.
+    read.SetNull();
+    BOOST_CHECK(!read.ReadBlob(Span{blob}.first(size - 1)));
+    blob[size] = 0;
+    BOOST_CHECK(!read.ReadBlob(Span{blob}.first(size + 1)));
+    BOOST_CHECK(read.IsNull());
+    ss << std::vector<unsigned char>(blob, blob + size + 1);
+    ss >> read;
+    BOOST_CHECK(read == header);
+
+    header.major_version = 0xff;
+    header.timestamp = std::numeric_limits<uint64_t>::max();
+    header.nTxes = std::numeric_limits<size_t>::max();
+    BOOST_CHECK(header.WriteBlob(blob) <= CryptoNoteHeader::MAX_BLOB_SIZE);
+    BOOST_CHECK(read.ReadBlob(Span{blob}.first(header.WriteBlob(blob))));
+    BOOST_CHECK(read == header);
+}
+
+BOOST_AUTO_TEST_CASE(block_header_hash_cache)
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1600000000;
+    header.nBits = 0x1e0fffff;
+    header.nNonce = 1000;
+    header.cnHeader.major_version = 12;
+    header.cnHeader.timestamp = header.nTime;
+    header.cnHeader.prev_id = header.GetOriginalBlockHash();
+    header.cnHeader.nTxes = 1;
+    BOOST_CHECK(header.isCNConsistent());
+    const uint256 hash = header.GetHash();
+
+    DataStream ss;
+    ss << header;
+    CBlockHeader read;
+    ss >> read;
+    BOOST_CHECK_EQUAL(read.GetHash(), hash);
+    BOOST_CHECK_EQUAL(CBlock(read).GetBlockHeader().GetHash(), hash);
+
+    // Changes made after deserialization are not hidden by the cached hash.
+    ++read.cnHeader.nonce;
+    BOOST_CHECK(read.GetHash() != hash);
+    --read.cnHeader.nonce;
+    BOOST_CHECK_EQUAL(read.GetHash(), hash);
+    ++read.nTime;
+    BOOST_CHECK(!read.isCNConsistent());
+    BOOST_CHECK_EQUAL(read.GetHash(), (HashWriter{} << read).GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
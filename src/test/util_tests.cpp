@@ -299,6 +299,12 @@ BOOST_AUTO_TEST_CASE(util_FormatISO8601Date)
     BOOST_CHECK_EQUAL(FormatISO8601Date(1317425777), "2011-09-30");
 }
 
+BOOST_AUTO_TEST_CASE(util_FormatHTTPDateTime)
+{
+    BOOST_CHECK_EQUAL(FormatHTTPDateTime(1317425777), "Fri, 30 Sep 2011 23:36:17 GMT");
+    BOOST_CHECK_EQUAL(FormatHTTPDateTime(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+}
+
 BOOST_AUTO_TEST_CASE(util_FormatMoney)
 {
     BOOST_CHECK_EQUAL(FormatMoney(0), "0.00");
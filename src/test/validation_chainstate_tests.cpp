@@ -4,14 +4,19 @@
 //
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <keva/common.h>
 #include <random.h>
 #include <rpc/blockchain.h>
+#include <script/keva.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
 #include <test/util/coins.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
+#include <util/translation.h>
 #include <validation.h>
 
 #include <vector>
@@ -140,4 +145,92 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
 }
 
+//! Blocks connected to the chain are marked as having had their proof of work
+//! verified, so that it need not be recomputed when they are reconnected.
+BOOST_FIXTURE_TEST_CASE(chainstate_pow_checked, TestChain100Setup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    // The flag is recorded even though it is only used with -trustcheckedpow.
+    BOOST_CHECK(!chainman.m_options.trust_checked_pow);
+
+    mineBlocks(1);
+
+    LOCK(::cs_main);
+    const CChain& chain = chainman.ActiveChain();
+    for (int height = 1; height <= chain.Height(); ++height) {
+        BOOST_CHECK(chain[height]->nStatus & BLOCK_POW_CHECKED);
+    }
+}
+
+//! With -trustcheckedpow, the proof of work of reindexed blocks is only
+//! trusted for the ancestors of the assumed valid block.
+BOOST_FIXTURE_TEST_CASE(chainstate_trusted_block_file_pow, TestChain100Setup)
+{
+    LOCK(::cs_main);
+    const CChain& chain = m_node.chainman->ActiveChain();
+    const CBlockIndex* assumed_valid = chain[50];
+
+    BOOST_CHECK(IsTrustedBlockFilePoW(*chain[1], assumed_valid, arith_uint256{0}));
+    BOOST_CHECK(IsTrustedBlockFilePoW(*chain[50], assumed_valid, assumed_valid->nChainWork));
+    // Blocks after the assumed valid block are checked.
+    BOOST_CHECK(!IsTrustedBlockFilePoW(*chain[51], assumed_valid, arith_uint256{0}));
+    BOOST_CHECK(!IsTrustedBlockFilePoW(*chain.Tip(), assumed_valid, arith_uint256{0}));
+    // So are blocks not on the assumed valid chain.
+    CBlockIndex fork{chain[30]->GetBlockHeader()};
+    fork.pprev = chain[29];
+    fork.nHeight = 30;
+    BOOST_CHECK(!IsTrustedBlockFilePoW(fork, assumed_valid, arith_uint256{0}));
+    // Nothing is trusted if the assumed valid block is unknown, or has less
+    // than the minimum chain work.
+    BOOST_CHECK(!IsTrustedBlockFilePoW(*chain[1], nullptr, arith_uint256{0}));
+    BOOST_CHECK(!IsTrustedBlockFilePoW(*chain[1], assumed_valid, assumed_valid->nChainWork + 1));
+}
+
+//! Test disconnecting a block with keva operations the way ReplayBlocks
+//! does on startup: through a view on top of the coins database, before
+//! the chainstate has a tip cache.
+BOOST_FIXTURE_TEST_CASE(chainstate_rollback_keva_block, TestChain100Setup)
+{
+    ChainstateManager& chainman = *Assert(m_node.chainman);
+    const CScript addr = CScript() << OP_TRUE;
+    const valtype key = ValtypeFromString("key");
+
+    CMutableTransaction reg;
+    reg.SetKevacoin();
+    reg.vin.emplace_back(COutPoint(m_coinbase_txns[0]->GetHash(), 0));
+    valtype nameSpace;
+    CKevaScript::generateNamespace(reg.vin[0].prevout.hash, reg.vin[0].prevout.n, nameSpace, Params(), true);
+    reg.vout.emplace_back(m_coinbase_txns[0]->vout[0].nValue - 10000,
+                          CKevaScript::buildKevaNamespace(addr, nameSpace, ValtypeFromString("name")));
+    {
+        FillableSigningProvider keystore;
+        BOOST_REQUIRE(keystore.AddKey(coinbaseKey));
+        std::map<COutPoint, Coin> coins;
+        coins[reg.vin[0].prevout] = Coin(m_coinbase_txns[0]->vout[0], 1, /*fCoinBaseIn=*/true);
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(reg, &keystore, coins, SIGHASH_ALL, input_errors));
+    }
+    CMutableTransaction put;
+    put.SetKevacoin();
+    put.vin.emplace_back(COutPoint(reg.GetHash(), 0));
+    put.vout.emplace_back(reg.vout[0].nValue - 10000, CKevaScript::buildKevaPut(addr, nameSpace, key, ValtypeFromString("value")));
+    const CBlock block = CreateAndProcessBlock({reg, put}, addr);
+    chainman.ActiveChainstate().ForceFlushStateToDisk();
+
+    LOCK(cs_main);
+    const CBlockIndex* tip = chainman.ActiveChain().Tip();
+    BOOST_REQUIRE(tip->GetBlockHash() == block.GetHash());
+
+    Chainstate replay{m_node.mempool.get(), chainman.m_blockman, chainman};
+    replay.InitCoinsDB(/*cache_size_bytes=*/1 << 20, /*in_memory=*/true, /*should_wipe=*/false, "chainstate_replay");
+    BOOST_REQUIRE(!replay.CanFlushToDisk());
+
+    CCoinsViewCache view{&chainman.ActiveChainstate().CoinsDB()};
+    CKevaData data;
+    BOOST_REQUIRE(view.GetName(nameSpace, key, data));
+    BOOST_CHECK(replay.DisconnectBlock(block, tip, view) == DISCONNECT_OK);
+    BOOST_CHECK(!view.GetName(nameSpace, key, data));
+    BOOST_CHECK(view.GetBestBlock() == tip->pprev->GetBlockHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
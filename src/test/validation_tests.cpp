@@ -6,6 +6,7 @@
 #include <consensus/amount.h>
 #include <consensus/merkle.h>
 #include <core_io.h>
+#include <crypto/hash-ops.h>
 #include <hash.h>
 #include <net.h>
 #include <signet.h>
@@ -360,4 +361,53 @@ BOOST_AUTO_TEST_CASE(block_malleation)
     }
 }
 
+//! Build a continuous sequence of RandomX headers at the given heights,
+//! following an unknown block.
+static std::vector<CBlockHeader> MakeRandomXHeaders(uint32_t start_height, size_t count)
+{
+    std::vector<CBlockHeader> headers(count);
+    for (size_t i = 0; i < count; ++i) {
+        CBlockHeader& header = headers[i];
+        header.hashPrevBlock = i == 0 ? uint256::ONE : headers[i - 1].GetHash();
+        header.nTime = 1600000000 + i;
+        header.nBits = 0x1e0fffff;
+        header.nNonce = start_height + i;
+        header.cnHeader.major_version = RX_BLOCK_VERSION;
+        header.cnHeader.timestamp = header.nTime;
+        header.cnHeader.prev_id = header.GetOriginalBlockHash();
+    }
+    return headers;
+}
+
+BOOST_AUTO_TEST_CASE(headers_seed_hashes)
+{
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+    const uint256 genesis{chainman.GetParams().GenesisBlock().GetHash()};
+
+    // The seeds of the first epochs are the genesis block, then a header of
+    // the sequence.
+    auto headers{MakeRandomXHeaders(2048, 66)};
+    auto seeds{GetHeadersSeedHashes(headers, chainman)};
+    BOOST_REQUIRE(seeds);
+    for (size_t i = 0; i < 65; ++i) BOOST_CHECK_EQUAL((*seeds)[i], genesis);
+    BOOST_CHECK_EQUAL((*seeds)[65], headers[0].GetHash());
+
+    // Non-continuous headers have no seeds.
+    std::swap(headers[1], headers[2]);
+    BOOST_CHECK(!GetHeadersSeedHashes(headers, chainman));
+
+    // A seed before an unknown first header can only be found in the chain
+    // being synced.
+    headers = MakeRandomXHeaders(2113, 10);
+    BOOST_CHECK(!GetHeadersSeedHashes(headers, chainman));
+    BOOST_CHECK(!GetHeadersSeedHashes(headers, chainman, {{4096, uint256::ONE}}));
+    seeds = GetHeadersSeedHashes(headers, chainman, {{2048, uint256::ONE}});
+    BOOST_REQUIRE(seeds);
+    for (const uint256& seed : *seeds) BOOST_CHECK_EQUAL(seed, uint256::ONE);
+
+    // Same for headers whose seed is a block that isn't known at all.
+    headers = MakeRandomXHeaders(5000, 10);
+    BOOST_CHECK(!GetHeadersSeedHashes(headers, chainman));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,7 +4,10 @@
 
 #include <boost/test/unit_test.hpp>
 #include <consensus/validation.h>
+#include <keva/common.h>
+#include <keva/main.h>
 #include <primitives/block.h>
+#include <script/keva.h>
 #include <scheduler.h>
 #include <test/util/setup_common.h>
 #include <util/check.h>
@@ -101,4 +104,53 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call)
     BOOST_CHECK(destroyed);
 }
 
+struct TestKevaSubscriber final : public CValidationInterface {
+    std::vector<std::pair<std::string, std::string>> updates;
+    bool WantsKevaNotifications() const override { return true; }
+    void KevaUpdated(const CTransactionRef&, int, const std::string&, const std::string& key, const std::string& value) override
+    {
+        updates.emplace_back(key, value);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(keva_notifications)
+{
+    ValidationSignals& signals{*m_node.validation_signals};
+    CMutableTransaction mtx;
+    mtx.SetKevacoin();
+    mtx.vout.emplace_back(COIN, CKevaScript::buildKevaPut(CScript() << OP_TRUE, ValtypeFromString("namespace"),
+                                                          ValtypeFromString("key"), ValtypeFromString("value")));
+    const CTransactionRef ptx{MakeTransactionRef(mtx)};
+
+    // Nothing is recorded without listeners.
+    auto noop{std::make_shared<TestSubscriberNoop>()};
+    signals.RegisterSharedValidationInterface(noop);
+    BOOST_CHECK(!signals.HasKevaListeners());
+
+    auto sub{std::make_shared<TestKevaSubscriber>()};
+    signals.RegisterSharedValidationInterface(sub);
+    signals.RegisterSharedValidationInterface(sub);
+    BOOST_CHECK(signals.HasKevaListeners());
+
+    CKevaNotifier notifier{&signals};
+    notifier.KevaApplied(ptx, 0, 1);
+    notifier.Flush();
+    signals.SyncWithValidationInterfaceQueue();
+    BOOST_REQUIRE_EQUAL(sub->updates.size(), 1U);
+    BOOST_CHECK_EQUAL(sub->updates[0].first, "key");
+    BOOST_CHECK_EQUAL(sub->updates[0].second, "value");
+
+    signals.UnregisterSharedValidationInterface(sub);
+    BOOST_CHECK(!signals.HasKevaListeners());
+    CKevaNotifier unused{&signals};
+    unused.KevaApplied(ptx, 0, 1);
+    unused.Flush();
+    signals.SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(sub->updates.size(), 1U);
+
+    signals.RegisterSharedValidationInterface(sub);
+    signals.UnregisterAllValidationInterfaces();
+    BOOST_CHECK(!signals.HasKevaListeners());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
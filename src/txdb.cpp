@@ -14,11 +14,14 @@
 #include <script/keva.h>
 #include <serialize.h>
 #include <uint256.h>
+#include <util/strencodings.h>
 #include <util/vector.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <iterator>
+#include <numeric>
 #include <utility>
 
 static constexpr uint8_t DB_COIN{'C'};
@@ -28,6 +31,13 @@ static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
 static constexpr uint8_t DB_COINS{'c'};
 static constexpr uint8_t DB_NAME{'n'};
 static constexpr uint8_t DB_NS_ASSOC{'a'};
+// Height index of the keva entries, by namespace and across namespaces:
+static constexpr uint8_t DB_NAME_HEIGHT{'h'};
+static constexpr uint8_t DB_HEIGHT_NAME{'u'};
+static constexpr uint8_t DB_NAME_HEIGHT_VERSION{'V'};
+
+//! Version of the keva height index.  The index is rebuilt if it differs.
+static constexpr int KEVA_HEIGHT_INDEX_VERSION{1};
 
 bool CCoinsViewDB::NeedsUpgrade()
 {
@@ -48,27 +58,282 @@ struct CoinEntry {
     SERIALIZE_METHODS(CoinEntry, obj) { READWRITE(obj.key, obj.outpoint->hash, VARINT(obj.outpoint->n)); }
 };
 
+//! Key of the height index entry of a keva entry, sorted by namespace and
+//! height, so that the recently updated keys of a namespace are a range.
+struct NameHeightKey {
+    uint8_t prefix{DB_NAME_HEIGHT};
+    valtype nameSpace;
+    uint32_t height{0};
+    valtype key;
+
+    SERIALIZE_METHODS(NameHeightKey, obj)
+    {
+        READWRITE(obj.prefix, obj.nameSpace, Using<BigEndianFormatter<4>>(obj.height), obj.key);
+    }
+};
+
+//! Key of the height index entry of a keva entry, sorted by height across
+//! all namespaces.
+struct HeightNameKey {
+    uint8_t prefix{DB_HEIGHT_NAME};
+    uint32_t height{0};
+    valtype nameSpace;
+    valtype key;
+
+    SERIALIZE_METHODS(HeightNameKey, obj)
+    {
+        READWRITE(obj.prefix, Using<BigEndianFormatter<4>>(obj.height), obj.nameSpace, obj.key);
+    }
+};
+
+//! Add the height index entries of a keva entry to a batch.
+void WriteHeightIndex(CDBBatch& batch, const valtype& nameSpace, const valtype& key, uint32_t height)
+{
+    batch.Write(NameHeightKey{.nameSpace = nameSpace, .height = height, .key = key}, uint8_t{});
+    batch.Write(HeightNameKey{.height = height, .nameSpace = nameSpace, .key = key}, uint8_t{});
+}
+
+//! Erase the height index entries of a keva entry in a batch.
+void EraseHeightIndex(CDBBatch& batch, const valtype& nameSpace, const valtype& key, uint32_t height)
+{
+    batch.Erase(NameHeightKey{.nameSpace = nameSpace, .height = height, .key = key});
+    batch.Erase(HeightNameKey{.height = height, .nameSpace = nameSpace, .key = key});
+}
+
+//! Whether the database contains any keva entries (or their height index).
+bool HasKevaEntries(CDBWrapper& db)
+{
+    for (const uint8_t prefix : {DB_NAME, DB_NS_ASSOC, DB_NAME_HEIGHT, DB_HEIGHT_NAME, DB_NAME_HEIGHT_VERSION}) {
+        std::unique_ptr<CDBIterator> cursor{db.NewIterator()};
+        cursor->Seek(prefix);
+        uint8_t key;
+        if (cursor->Valid() && cursor->GetKey(key) && key == prefix) return true;
+    }
+    return false;
+}
+
+//! Erase the keva height index, in batches.  The version marker goes first,
+//! so that an interrupted erase is completed by the next rebuild.
+void EraseKevaHeightIndex(CDBWrapper& db, size_t batch_bytes)
+{
+    db.Erase(DB_NAME_HEIGHT_VERSION, /*fSync=*/true);
+
+    CDBBatch batch(db);
+    std::unique_ptr<CDBIterator> cursor{db.NewIterator()};
+    for (cursor->Seek(DB_NAME_HEIGHT); cursor->Valid(); cursor->Next()) {
+        NameHeightKey key;
+        if (!cursor->GetKey(key) || key.prefix != DB_NAME_HEIGHT) break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > batch_bytes) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    for (cursor->Seek(DB_HEIGHT_NAME); cursor->Valid(); cursor->Next()) {
+        HeightNameKey key;
+        if (!cursor->GetKey(key) || key.prefix != DB_HEIGHT_NAME) break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > batch_bytes) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch, /*fSync=*/true);
+}
+
+//! Build the keva height index from the keva entries, unless the database
+//! already has an up-to-date one.  This is needed once for databases
+//! written before the index existed, and after keva entries were moved
+//! between databases.
+void BuildKevaHeightIndex(CDBWrapper& db, size_t batch_bytes)
+{
+    int version;
+    if (db.Read(DB_NAME_HEIGHT_VERSION, version) && version == KEVA_HEIGHT_INDEX_VERSION) return;
+
+    LogPrintf("Building keva height index...\n");
+    EraseKevaHeightIndex(db, batch_bytes);
+
+    size_t count = 0;
+    CDBBatch batch(db);
+    std::unique_ptr<CDBIterator> cursor{db.NewIterator()};
+    for (cursor->Seek(DB_NAME); cursor->Valid(); cursor->Next()) {
+        std::pair<uint8_t, std::pair<valtype, valtype>> key;
+        if (!cursor->GetKey(key) || key.first != DB_NAME) break;
+        CKevaData data;
+        if (!cursor->GetValue(data)) {
+            throw dbwrapper_error("Failed to read keva entry while building keva height index");
+        }
+        WriteHeightIndex(batch, key.second.first, key.second.second, data.getHeight());
+        if (batch.SizeEstimate() > batch_bytes) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+        ++count;
+    }
+    batch.Write(DB_NAME_HEIGHT_VERSION, KEVA_HEIGHT_INDEX_VERSION);
+    db.WriteBatch(batch, /*fSync=*/true);
+    LogPrintf("Indexed %u keva entries by height\n", count);
+}
+
+//! Copy all keva entries from one database to another (if to is set), and
+//! erase them and their height index from the source (if erase is set), in
+//! batches.
+void MoveKevaEntries(CDBWrapper& from, CDBWrapper* to, bool erase, size_t batch_bytes)
+{
+    // The height index is not copied, but rebuilt by the target database.
+    if (erase) EraseKevaHeightIndex(from, batch_bytes);
+
+    size_t count = 0;
+    for (const uint8_t prefix : {DB_NAME, DB_NS_ASSOC}) {
+        std::unique_ptr<CDBIterator> cursor{from.NewIterator()};
+        std::optional<CDBBatch> to_batch;
+        if (to) to_batch.emplace(*to);
+        CDBBatch from_batch(from);
+        for (cursor->Seek(prefix); cursor->Valid(); cursor->Next()) {
+            std::pair<uint8_t, std::pair<valtype, valtype>> key;
+            if (!cursor->GetKey(key) || key.first != prefix) break;
+            if (to_batch) {
+                CKevaData data;
+                if (!cursor->GetValue(data)) {
+                    throw dbwrapper_error("Failed to read keva entry while moving keva database");
+                }
+                to_batch->Write(key, data);
+                if (to_batch->SizeEstimate() > batch_bytes) {
+                    to->WriteBatch(*to_batch);
+                    to_batch->Clear();
+                }
+            }
+            if (erase) {
+                from_batch.Erase(key);
+                if (from_batch.SizeEstimate() > batch_bytes) {
+                    from.WriteBatch(from_batch);
+                    from_batch.Clear();
+                }
+            }
+            ++count;
+        }
+        // Data is copied before erasing the source entries of each prefix,
+        // so that an interrupted move never loses entries.
+        if (to_batch) to->WriteBatch(*to_batch, /*fSync=*/true);
+        if (erase) from.WriteBatch(from_batch, /*fSync=*/true);
+    }
+    LogPrintf("Moved %u keva entries from %s\n", count, from.StoragePath() ? fs::PathToString(*from.StoragePath()) : "memory");
+}
+
 } // namespace
 
 CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options) :
     m_db_params{std::move(db_params)},
     m_options{std::move(options)},
-    m_db{std::make_unique<CDBWrapper>(m_db_params)} { }
+    m_db{std::make_shared<CDBWrapper>(m_db_params)}
+{
+    InitKevaDB();
+    BuildKevaHeightIndex(KevaDB(), m_options.batch_write_bytes);
+}
+
+DBParams CCoinsViewDB::KevaDBParams() const
+{
+    return DBParams{
+        .path = m_db_params.path / "keva",
+        .cache_bytes = m_options.keva_db_cache_bytes,
+        .memory_only = m_db_params.memory_only,
+        .wipe_data = m_db_params.wipe_data,
+        .obfuscate = m_db_params.obfuscate,
+        .options = m_options.keva_db_options};
+}
+
+void CCoinsViewDB::InitKevaDB()
+{
+    const DBParams keva_params{KevaDBParams()};
+    if (!m_options.keva_db) {
+        // Move the keva entries back if a separate database was used before.
+        if (m_db_params.memory_only || !fs::exists(keva_params.path)) return;
+        LogPrintf("Moving keva entries from %s back into the coins database\n", fs::PathToString(keva_params.path));
+        {
+            CDBWrapper keva_db(keva_params);
+            // Entries left over from an interrupted move out of the coins
+            // database may be stale.
+            MoveKevaEntries(*m_db, /*to=*/nullptr, /*erase=*/true, m_options.batch_write_bytes);
+            MoveKevaEntries(keva_db, m_db.get(), /*erase=*/false, m_options.batch_write_bytes);
+        }
+        fs::remove_all(keva_params.path);
+        return;
+    }
+
+    m_keva_db = std::make_shared<CDBWrapper>(keva_params);
+    const uint256 coins_best = GetBestBlock();
+
+    std::vector<uint256> keva_heads;
+    if (m_keva_db->Read(DB_HEAD_BLOCKS, keva_heads)) {
+        // A flush was interrupted after the keva changes were written.  If
+        // the coins database got to the same block, complete the transition.
+        // Otherwise the coins database is itself in the middle of that
+        // transition, and the flush at the end of ReplayBlocks completes it.
+        if (keva_heads.size() == 2 && keva_heads[0] == coins_best) {
+            CDBBatch batch(*m_keva_db);
+            batch.Erase(DB_HEAD_BLOCKS);
+            batch.Write(DB_BEST_BLOCK, coins_best);
+            m_keva_db->WriteBatch(batch, /*fSync=*/true);
+        }
+        return;
+    }
+
+    uint256 keva_best;
+    if (!m_keva_db->Read(DB_BEST_BLOCK, keva_best)) {
+        // New keva database: move the existing entries over, and only then
+        // mark it as up to date with the coins database.
+        if (HasKevaEntries(*m_db)) {
+            LogPrintf("Moving keva entries from the coins database to %s\n", fs::PathToString(keva_params.path));
+            MoveKevaEntries(*m_db, m_keva_db.get(), /*erase=*/false, m_options.batch_write_bytes);
+        }
+        if (!coins_best.IsNull()) {
+            m_keva_db->Write(DB_BEST_BLOCK, coins_best, /*fSync=*/true);
+        }
+        keva_best = coins_best;
+    }
+
+    // The coins database may also be in the middle of a flush that did not
+    // get to write the keva changes, which ReplayBlocks takes care of.
+    const std::vector<uint256> coins_heads{GetHeadBlocks()};
+    const bool replaying{coins_best.IsNull() && coins_heads.size() == 2 && coins_heads[1] == keva_best};
+    if (keva_best != coins_best && !replaying) {
+        throw dbwrapper_error(strprintf("The keva database is at block %s, but the coins database at block %s. "
+            "Restart with -reindex-chainstate to rebuild them.", keva_best.ToString(), coins_best.ToString()));
+    }
+
+    // Drop what remains in the coins database after (possibly interrupted)
+    // moves of the keva entries.
+    if (HasKevaEntries(*m_db)) {
+        MoveKevaEntries(*m_db, /*to=*/nullptr, /*erase=*/true, m_options.batch_write_bytes);
+    }
+}
 
 void CCoinsViewDB::ResizeCache(size_t new_cache_size)
 {
     // We can't do this operation with an in-memory DB since we'll lose all the coins upon
     // reset.
     if (!m_db_params.memory_only) {
-        // Have to do a reset first to get the original `m_db` state to release its
-        // filesystem lock.
-        m_db.reset();
-        m_db_params.cache_bytes = new_cache_size;
-        m_db_params.wipe_data = false;
-        m_db = std::make_unique<CDBWrapper>(m_db_params);
+        m_pending_cache_bytes = new_cache_size;
+        ApplyPendingResize();
     }
 }
 
+void CCoinsViewDB::ApplyPendingResize()
+{
+    // Keva scans may still be reading from a snapshot of the database,
+    // which keeps it open.  New snapshots are only taken under cs_main,
+    // so the count cannot go up again before the database is reopened.
+    if (!m_pending_cache_bytes || m_db.use_count() > 1) return;
+
+    // Have to do a reset first to get the original `m_db` state to release its
+    // filesystem lock.
+    m_db.reset();
+    m_db_params.cache_bytes = *m_pending_cache_bytes;
+    m_db_params.wipe_data = false;
+    m_db = std::make_shared<CDBWrapper>(m_db_params);
+    m_pending_cache_bytes.reset();
+}
+
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
@@ -100,6 +365,9 @@ private:
     /* The backing LevelDB iterator.  */
     CDBIterator* iter;
 
+    /* The snapshot iterated over, if any, which is kept alive for it.  */
+    std::shared_ptr<const CDBWrapper::Snapshot> snapshot;
+
     /* This iterator is for namespace association search. */
     bool isAssociation;
 
@@ -110,8 +378,10 @@ public:
     /**
      * Construct a new name iterator for the database.
      * @param db The database to create the iterator for.
+     * @param snap The snapshot of the database to iterate over, if any.
      */
-    CDbKeyIterator(const CDBWrapper& db, const valtype& nameSpace, bool association=false);
+    CDbKeyIterator(const CDBWrapper& db, const valtype& nameSpace, bool association=false,
+                   std::shared_ptr<const CDBWrapper::Snapshot> snap=nullptr);
 
     /* Implement iterator methods.  */
     void seek(const valtype& start);
@@ -123,8 +393,10 @@ CDbKeyIterator::~CDbKeyIterator() {
     delete iter;
 }
 
-CDbKeyIterator::CDbKeyIterator(const CDBWrapper& db, const valtype& ns, bool association)
-    : CKevaIterator(ns), iter(const_cast<CDBWrapper*>(&db)->NewIterator()), isAssociation(association)
+CDbKeyIterator::CDbKeyIterator(const CDBWrapper& db, const valtype& ns, bool association,
+                               std::shared_ptr<const CDBWrapper::Snapshot> snap)
+    : CKevaIterator(ns), iter(const_cast<CDBWrapper*>(&db)->NewIterator(snap.get())), snapshot(std::move(snap)),
+      isAssociation(association)
 {
     seek(valtype());
 }
@@ -158,28 +430,149 @@ bool CDbKeyIterator::next(valtype& key, CKevaData& data) {
     return true;
 }
 
+namespace {
+
+bool ReadKevaEntry(const CDBWrapper& db, const CDBWrapper::Snapshot* snapshot,
+                   const valtype& nameSpace, const valtype& key, CKevaData& data)
+{
+    return db.Read(std::make_pair(DB_NAME, std::make_pair(nameSpace, key)), data, snapshot);
+}
+
+std::vector<std::optional<CKevaData>> ReadKevaEntries(const CDBWrapper& db, const CDBWrapper::Snapshot* snapshot,
+                                                      const std::vector<CKevaCache::NamespaceKeyType>& names)
+{
+    // Read the names in database order, so that the reads of a namespace hit
+    // the same database blocks one after another.  The namespace and key are
+    // serialized with a length prefix, so shorter ones sort first.
+    const auto db_less = [](const valtype& a, const valtype& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    };
+    std::vector<size_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const auto& [ns_a, key_a] = names[a];
+        const auto& [ns_b, key_b] = names[b];
+        if (ns_a != ns_b) return db_less(ns_a, ns_b);
+        return db_less(key_a, key_b);
+    });
+
+    std::vector<std::optional<CKevaData>> result(names.size());
+    for (const size_t i : order) {
+        CKevaData data;
+        if (ReadKevaEntry(db, snapshot, std::get<0>(names[i]), std::get<1>(names[i]), data)) result[i] = std::move(data);
+    }
+    return result;
+}
+
+bool ReadKeysSinceHeight(const CDBWrapper& db, const CDBWrapper::Snapshot* snapshot,
+                         const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys)
+{
+    std::unique_ptr<CDBIterator> cursor{const_cast<CDBWrapper&>(db).NewIterator(snapshot)};
+    for (cursor->Seek(NameHeightKey{.nameSpace = nameSpace, .height = nMinHeight}); cursor->Valid(); cursor->Next()) {
+        NameHeightKey entry;
+        if (!cursor->GetKey(entry) || entry.prefix != DB_NAME_HEIGHT || entry.nameSpace != nameSpace) {
+            break;
+        }
+        keys.insert(std::move(entry.key));
+    }
+    return true;
+}
+
+bool ReadNamesSinceHeight(const CDBWrapper& db, const CDBWrapper::Snapshot* snapshot,
+                          unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names)
+{
+    std::unique_ptr<CDBIterator> cursor{const_cast<CDBWrapper&>(db).NewIterator(snapshot)};
+    for (cursor->Seek(HeightNameKey{.height = nMinHeight}); cursor->Valid(); cursor->Next()) {
+        HeightNameKey entry;
+        if (!cursor->GetKey(entry) || entry.prefix != DB_HEIGHT_NAME) {
+            break;
+        }
+        names.emplace(std::move(entry.nameSpace), std::move(entry.key));
+    }
+    return true;
+}
+
+/**
+ * Read-only view of the keva entries in a snapshot of the database, which
+ * is not affected by later writes.  Only the keva methods are supported.
+ */
+class CKevaDBSnapshot final : public CCoinsView
+{
+private:
+    //! The database is kept open as long as the snapshot is used.
+    const std::shared_ptr<CDBWrapper> m_db;
+    const std::shared_ptr<const CDBWrapper::Snapshot> m_snapshot;
+
+public:
+    explicit CKevaDBSnapshot(std::shared_ptr<CDBWrapper> db)
+        : m_db{std::move(db)}, m_snapshot{m_db->GetSnapshot()} {}
+
+    bool GetNamespace(const valtype& nameSpace, CKevaData& data) const override
+    {
+        return ReadKevaEntry(*m_db, m_snapshot.get(), nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data);
+    }
+    bool GetName(const valtype& nameSpace, const valtype& key, CKevaData& data) const override
+    {
+        return ReadKevaEntry(*m_db, m_snapshot.get(), nameSpace, key, data);
+    }
+    std::vector<std::optional<CKevaData>> GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override
+    {
+        return ReadKevaEntries(*m_db, m_snapshot.get(), names);
+    }
+    bool GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const override
+    {
+        return ReadKeysSinceHeight(*m_db, m_snapshot.get(), nameSpace, nMinHeight, keys);
+    }
+    bool GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const override
+    {
+        return ReadNamesSinceHeight(*m_db, m_snapshot.get(), nMinHeight, names);
+    }
+    CKevaIterator* IterateKeys(const valtype& nameSpace) const override
+    {
+        return new CDbKeyIterator(*m_db, nameSpace, false, m_snapshot);
+    }
+    CKevaIterator* IterateAssociatedNamespaces(const valtype& nameSpace) const override
+    {
+        return new CDbKeyIterator(*m_db, nameSpace, true, m_snapshot);
+    }
+};
+
+} // namespace
+
 CKevaIterator* CCoinsViewDB::IterateKeys(const valtype& nameSpace) const {
-    
-    return new CDbKeyIterator(*m_db, nameSpace);
+    return new CDbKeyIterator(KevaDB(), nameSpace);
 }
 
 CKevaIterator* CCoinsViewDB::IterateAssociatedNamespaces(const valtype& nameSpace) const {
-    return new CDbKeyIterator(*m_db, nameSpace, true);
+    return new CDbKeyIterator(KevaDB(), nameSpace, true);
 }
 
 bool CCoinsViewDB::GetNamespace(const valtype &nameSpace, CKevaData &data) const {
-    return m_db->Read(std::make_pair(DB_NAME, std::make_pair(nameSpace, CKevaScript::KEVA_DISPLAY_NAME_KEY)), data);
+    return ReadKevaEntry(KevaDB(), nullptr, nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data);
 }
 
 bool CCoinsViewDB::GetName(const valtype &nameSpace, const valtype &key, CKevaData &data) const {
-    return m_db->Read(std::make_pair(DB_NAME, std::make_pair(nameSpace, key)), data);
+    return ReadKevaEntry(KevaDB(), nullptr, nameSpace, key, data);
 }
 
-bool CCoinsViewDB::GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const {
-    return false;
+std::vector<std::optional<CKevaData>> CCoinsViewDB::GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    return ReadKevaEntries(KevaDB(), nullptr, names);
+}
+
+bool CCoinsViewDB::GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const {
+    return ReadKeysSinceHeight(KevaDB(), nullptr, nameSpace, nMinHeight, keys);
+}
+
+bool CCoinsViewDB::GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const {
+    return ReadNamesSinceHeight(KevaDB(), nullptr, nMinHeight, names);
+}
+
+std::unique_ptr<CCoinsView> CCoinsViewDB::GetKevaSnapshot() const {
+    return std::make_unique<CKevaDBSnapshot>(m_keva_db ? m_keva_db : m_db);
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names, bool erase) {
+    ApplyPendingResize();
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
@@ -230,7 +623,24 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, con
         }
     }
 
-    names.writeBatch(batch);
+    if (m_keva_db) {
+        // The two databases cannot be written atomically.  Instead, the keva
+        // database goes first and carries its own transition marker, which
+        // is only cleared once the coins database is consistent again (or
+        // by InitKevaDB after a crash).  Make sure the coins database has
+        // recorded the transition before the keva database moves ahead.
+        m_db->WriteBatch(batch);
+        batch.Clear();
+
+        CDBBatch keva_batch(*m_keva_db);
+        keva_batch.Erase(DB_BEST_BLOCK);
+        keva_batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+        names.writeBatch(keva_batch);
+        LogPrint(BCLog::COINDB, "Writing keva batch of %.2f MiB\n", keva_batch.SizeEstimate() * (1.0 / 1048576.0));
+        m_keva_db->WriteBatch(keva_batch);
+    } else {
+        names.writeBatch(batch);
+    }
 
     // In the last batch, mark the database as consistent with hashBlock again.
     batch.Erase(DB_HEAD_BLOCKS);
@@ -238,6 +648,12 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, con
 
     LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
     bool ret = m_db->WriteBatch(batch);
+    if (ret && m_keva_db) {
+        CDBBatch keva_batch(*m_keva_db);
+        keva_batch.Erase(DB_HEAD_BLOCKS);
+        keva_batch.Write(DB_BEST_BLOCK, hashBlock);
+        ret = m_keva_db->WriteBatch(keva_batch);
+    }
     LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
@@ -270,6 +686,177 @@ private:
     friend class CCoinsViewDB;
 };
 
+/** Specialization of CKevaViewCursor to iterate over the keva entries of a CCoinsViewDB */
+class CCoinsViewDBKevaCursor : public CKevaViewCursor
+{
+public:
+    explicit CCoinsViewDBKevaCursor(std::shared_ptr<CDBWrapper> db)
+        : m_db{std::move(db)}, m_cursor{m_db->NewIterator()}
+    {
+        // A single iterator is used for both prefixes, so that they are
+        // read from the same state of the database.
+        Seek(DB_NAME);
+    }
+
+    bool GetKey(bool& association, valtype& nameSpace, valtype& key) const override;
+    bool GetValue(CKevaData& data) const override;
+
+    bool Valid() const override { return m_key.first != 0; }
+    void Next() override;
+
+private:
+    //! Kept alive for the iterator.
+    const std::shared_ptr<CDBWrapper> m_db;
+    const std::unique_ptr<CDBIterator> m_cursor;
+    std::pair<uint8_t, std::pair<valtype, valtype>> m_key;
+    uint8_t m_prefix{0};
+
+    void Seek(uint8_t prefix);
+    void ReadKey();
+};
+
+void CCoinsViewDBKevaCursor::Seek(uint8_t prefix)
+{
+    m_prefix = prefix;
+    m_cursor->Seek(prefix);
+    ReadKey();
+}
+
+void CCoinsViewDBKevaCursor::ReadKey()
+{
+    if (m_cursor->Valid() && m_cursor->GetKey(m_key) && m_key.first == m_prefix) return;
+    if (m_prefix == DB_NAME) {
+        Seek(DB_NS_ASSOC);
+    } else {
+        m_key.first = 0; // Make sure Valid() and GetKey() return false
+    }
+}
+
+bool CCoinsViewDBKevaCursor::GetKey(bool& association, valtype& nameSpace, valtype& key) const
+{
+    if (!Valid()) return false;
+    association = m_key.first == DB_NS_ASSOC;
+    nameSpace = m_key.second.first;
+    key = m_key.second.second;
+    return true;
+}
+
+bool CCoinsViewDBKevaCursor::GetValue(CKevaData& data) const
+{
+    return m_cursor->GetValue(data);
+}
+
+void CCoinsViewDBKevaCursor::Next()
+{
+    m_cursor->Next();
+    ReadKey();
+}
+
+std::unique_ptr<CKevaViewCursor> CCoinsViewDB::KevaCursor() const
+{
+    return std::make_unique<CCoinsViewDBKevaCursor>(m_keva_db ? m_keva_db : m_db);
+}
+
+bool CCoinsViewDB::ValidateKevaDB() const
+{
+    CDBWrapper& db{KevaDB()};
+
+    int version;
+    if (!db.Read(DB_NAME_HEIGHT_VERSION, version) || version != KEVA_HEIGHT_INDEX_VERSION) {
+        LogError("%s: keva height index is missing or outdated\n", __func__);
+        return false;
+    }
+
+    // Every entry must be readable and have both height index records.
+    size_t entries = 0;
+    std::unique_ptr<CDBIterator> cursor{db.NewIterator()};
+    for (cursor->Seek(DB_NAME); cursor->Valid(); cursor->Next()) {
+        std::pair<uint8_t, std::pair<valtype, valtype>> key;
+        if (!cursor->GetKey(key) || key.first != DB_NAME) break;
+        const auto& [nameSpace, name] = key.second;
+        CKevaData data;
+        if (!cursor->GetValue(data)) {
+            LogError("%s: cannot read keva entry %s %s\n", __func__, HexStr(nameSpace), HexStr(name));
+            return false;
+        }
+        if (!db.Exists(NameHeightKey{.nameSpace = nameSpace, .height = data.getHeight(), .key = name})
+            || !db.Exists(HeightNameKey{.height = data.getHeight(), .nameSpace = nameSpace, .key = name})) {
+            LogError("%s: keva entry %s %s is missing from the height index\n", __func__, HexStr(nameSpace), HexStr(name));
+            return false;
+        }
+        ++entries;
+    }
+
+    // Every height index record must belong to an entry of that height.  With
+    // the above, this means there are no stale records.
+    const auto check_index_record = [&](const valtype& nameSpace, const valtype& name, uint32_t height) {
+        CKevaData data;
+        if (!ReadKevaEntry(db, nullptr, nameSpace, name, data) || data.getHeight() != height) {
+            LogError("%s: stale keva height index record for %s %s at height %u\n", __func__, HexStr(nameSpace), HexStr(name), height);
+            return false;
+        }
+        return true;
+    };
+    size_t name_height_records = 0;
+    for (cursor->Seek(DB_NAME_HEIGHT); cursor->Valid(); cursor->Next()) {
+        NameHeightKey key;
+        if (!cursor->GetKey(key) || key.prefix != DB_NAME_HEIGHT) break;
+        if (!check_index_record(key.nameSpace, key.key, key.height)) return false;
+        ++name_height_records;
+    }
+    size_t height_name_records = 0;
+    for (cursor->Seek(DB_HEIGHT_NAME); cursor->Valid(); cursor->Next()) {
+        HeightNameKey key;
+        if (!cursor->GetKey(key) || key.prefix != DB_HEIGHT_NAME) break;
+        if (!check_index_record(key.nameSpace, key.key, key.height)) return false;
+        ++height_name_records;
+    }
+    if (name_height_records != entries || height_name_records != entries) {
+        LogError("%s: keva height index has %u and %u records for %u entries\n", __func__, name_height_records, height_name_records, entries);
+        return false;
+    }
+
+    size_t associations = 0;
+    for (cursor->Seek(DB_NS_ASSOC); cursor->Valid(); cursor->Next()) {
+        std::pair<uint8_t, std::pair<valtype, valtype>> key;
+        if (!cursor->GetKey(key) || key.first != DB_NS_ASSOC) break;
+        CKevaData data;
+        if (!cursor->GetValue(data)) {
+            LogError("%s: cannot read namespace association %s %s\n", __func__, HexStr(key.second.first), HexStr(key.second.second));
+            return false;
+        }
+        ++associations;
+    }
+
+    LogPrint(BCLog::KEVA, "Checked keva database: %u entries, %u namespace associations\n", entries, associations);
+    return true;
+}
+
+CKevaDBLoader::CKevaDBLoader(CCoinsViewDB& view)
+    : m_db{view.KevaDB()}, m_batch_bytes{view.m_options.batch_write_bytes}, m_batch{m_db}
+{}
+
+void CKevaDBLoader::Add(bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data)
+{
+    if (association) {
+        m_batch.Write(std::make_pair(DB_NS_ASSOC, std::make_pair(nameSpace, key)), data);
+    } else {
+        m_batch.Write(std::make_pair(DB_NAME, std::make_pair(nameSpace, key)), data);
+        WriteHeightIndex(m_batch, nameSpace, key, data.getHeight());
+    }
+    if (m_batch.SizeEstimate() > m_batch_bytes) {
+        LogPrint(BCLog::COINDB, "Writing partial keva batch of %.2f MiB\n", m_batch.SizeEstimate() * (1.0 / 1048576.0));
+        m_db.WriteBatch(m_batch);
+        m_batch.Clear();
+    }
+}
+
+void CKevaDBLoader::Commit()
+{
+    m_db.WriteBatch(m_batch, /*fSync=*/true);
+    m_batch.Clear();
+}
+
 std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
 {
     auto i = std::make_unique<CCoinsViewDBCursor>(
@@ -313,6 +900,14 @@ void CKevaCache::writeBatch (CDBBatch& batch) const
 {
   for (EntryMap::const_iterator i = entries.begin(); i != entries.end(); ++i) {
     std::pair<valtype, valtype> name = std::make_pair(std::get<0>(i->first), std::get<1>(i->first));
+    const unsigned height = i->second.getHeight();
+    const HeightMap::const_iterator old = oldHeights.find(i->first);
+    if (old == oldHeights.end()) {
+      WriteHeightIndex(batch, name.first, name.second, height);
+    } else if (old->second != height) {
+      EraseHeightIndex(batch, name.first, name.second, old->second);
+      WriteHeightIndex(batch, name.first, name.second, height);
+    }
     batch.Write(std::make_pair(DB_NAME, name), i->second);
   }
 
@@ -321,12 +916,16 @@ void CKevaCache::writeBatch (CDBBatch& batch) const
     batch.Write(std::make_pair(DB_NS_ASSOC, name), i->second);
   }
 
-  for (std::set<NamespaceKeyType>::const_iterator i = deleted.begin(); i != deleted.end(); ++i) {
+  for (NameSet::const_iterator i = deleted.begin(); i != deleted.end(); ++i) {
     std::pair<valtype, valtype> name = std::make_pair(std::get<0>(*i), std::get<1>(*i));
+    const HeightMap::const_iterator old = oldHeights.find(*i);
+    if (old != oldHeights.end()) {
+      EraseHeightIndex(batch, name.first, name.second, old->second);
+    }
     batch.Erase(std::make_pair(DB_NAME, name));
   }
 
-  for (std::set<NamespaceKeyType>::const_iterator i = disassociations.begin(); i != disassociations.end(); ++i) {
+  for (NameSet::const_iterator i = disassociations.begin(); i != disassociations.end(); ++i) {
     std::pair<valtype, valtype> name = std::make_pair(std::get<0>(*i), std::get<1>(*i));
     batch.Erase(std::make_pair(DB_NS_ASSOC, name));
   }
@@ -40,6 +40,14 @@ static const int64_t nMaxTxIndexCache = 1024;
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -kevacache default (MiB)
+static const int64_t nDefaultKevaCache = 32;
+//! -kevagroupcache default (MiB)
+static const int64_t nDefaultKevaGroupCache = 8;
+//! -kevadb default
+static const bool DEFAULT_KEVA_DB = false;
+//! -kevadbcache default (MiB)
+static const int64_t nDefaultKevaDbCache = 16;
 
 //! User-controlled performance and debug options.
 struct CoinsViewOptions {
@@ -48,6 +56,17 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Memory budget in bytes of the read cache for confirmed keva entries.
+    size_t keva_cache_bytes = nDefaultKevaCache << 20;
+    //! Memory budget in bytes of the cache of namespace groups.
+    size_t keva_group_cache_bytes = nDefaultKevaGroupCache << 20;
+    //! Store keva entries in their own database (chainstate/keva) instead
+    //! of the coins database.
+    bool keva_db = DEFAULT_KEVA_DB;
+    //! LevelDB cache size in bytes of the separate keva database.
+    size_t keva_db_cache_bytes = nDefaultKevaDbCache << 20;
+    //! LevelDB options of the separate keva database.
+    DBOptions keva_db_options{};
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -56,7 +75,27 @@ class CCoinsViewDB final : public CCoinsView
 protected:
     DBParams m_db_params;
     CoinsViewOptions m_options;
-    std::unique_ptr<CDBWrapper> m_db;
+    //! Shared with the keva snapshots taken of it (see GetKevaSnapshot).
+    std::shared_ptr<CDBWrapper> m_db;
+    //! Separate keva database, if enabled with CoinsViewOptions::keva_db.
+    std::shared_ptr<CDBWrapper> m_keva_db;
+    //! LevelDB cache size that m_db is to be reopened with, once it is no
+    //! longer shared with keva snapshots (see ResizeCache).
+    std::optional<size_t> m_pending_cache_bytes;
+
+    //! Database holding the keva entries.
+    CDBWrapper& KevaDB() const { return m_keva_db ? *m_keva_db : *m_db; }
+
+    //! Parameters of the separate keva database.
+    DBParams KevaDBParams() const;
+
+    //! Open the separate keva database if enabled, and move the keva entries
+    //! between it and the coins database if the option was changed.
+    void InitKevaDB();
+
+    //! Reopen m_db with the cache size of a deferred ResizeCache, if no
+    //! keva snapshot holds it anymore.
+    void ApplyPendingResize();
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
@@ -66,21 +105,57 @@ public:
     std::vector<uint256> GetHeadBlocks() const override;
     bool GetNamespace(const valtype &nameSpace, CKevaData &data) const override;
     bool GetName(const valtype &nameSpace, const valtype &key, CKevaData &data) const override;
-    bool GetNamesForHeight(unsigned nHeight, std::set<valtype>& names) const override;
+    std::vector<std::optional<CKevaData>> GetNames(const std::vector<CKevaCache::NamespaceKeyType>& names) const override;
+    bool GetKeysSinceHeight(const valtype& nameSpace, unsigned nMinHeight, std::set<valtype>& keys) const override;
+    bool GetNamesSinceHeight(unsigned nMinHeight, std::set<CKevaCache::NamespaceKeyType>& names) const override;
     CKevaIterator* IterateKeys(const valtype& nameSpace) const override;
     CKevaIterator* IterateAssociatedNamespaces(const valtype& nameSpace) const override;
+    std::unique_ptr<CCoinsView> GetKevaSnapshot() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, const CKevaCache &names,bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
+    std::unique_ptr<CKevaViewCursor> KevaCursor() const override;
+    bool ValidateKevaDB() const override;
 
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
     size_t EstimateSize() const override;
 
-    //! Dynamically alter the underlying leveldb cache size.
+    //! Dynamically alter the underlying leveldb cache size.  While keva
+    //! snapshots of the database are in use, this is deferred until the
+    //! first write after they are released.
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    //! Options this view was created with.
+    const CoinsViewOptions& Options() const { return m_options; }
+
+    //! Whether the keva entries are stored in a separate database.
+    bool HasSeparateKevaDB() const { return m_keva_db != nullptr; }
+
     //! @returns filesystem path to on-disk storage or std::nullopt if in memory.
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
+
+    friend class CKevaDBLoader;
+};
+
+/**
+ * Writes keva entries and namespace associations straight to the database
+ * of a CCoinsViewDB in large batches, bypassing the coins cache.  This is
+ * used to load the keva state of a UTXO snapshot.
+ */
+class CKevaDBLoader
+{
+private:
+    CDBWrapper& m_db;
+    const size_t m_batch_bytes;
+    CDBBatch m_batch;
+
+public:
+    explicit CKevaDBLoader(CCoinsViewDB& view);
+
+    void Add(bool association, const valtype& nameSpace, const valtype& key, const CKevaData& data);
+
+    //! Write the remaining entries and sync the database.
+    void Commit();
 };
 
 #endif // KEVACOIN_TXDB_H
@@ -92,7 +92,8 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
             // Don't directly remove the transaction here -- doing so would
             // invalidate iterators in cachedDescendants. Mark it for removal
             // by inserting into descendants_to_remove.
-            if (descendant.GetCountWithAncestors() > uint64_t(m_limits.ancestor_count) || descendant.GetSizeWithAncestors() > m_limits.ancestor_size_vbytes) {
+            const int64_t ancestor_count{descendant.GetTx().IsKevacoin() ? std::max(m_limits.ancestor_count, m_limits.keva_chain_count) : m_limits.ancestor_count};
+            if (descendant.GetCountWithAncestors() > uint64_t(ancestor_count) || descendant.GetSizeWithAncestors() > m_limits.ancestor_size_vbytes) {
                 descendants_to_remove.insert(descendant.GetTx().GetHash());
             }
         }
@@ -1378,13 +1379,33 @@ util::Result<std::pair<std::vector<FeeFrac>, std::vector<FeeFrac>>> CTxMemPool::
 }
 
 bool CTxMemPool::getUnconfirmedKeyValue(const valtype& nameSpace, const valtype& key, valtype& value) const {
+    LOCK(cs);
     return kevaMemPool.getUnconfirmedKeyValue(nameSpace, key, value);
 }
 
+std::vector<std::optional<valtype>> CTxMemPool::getUnconfirmedKeyValues(const std::vector<CKevaCache::NamespaceKeyType>& names) const {
+    std::vector<std::optional<valtype>> values(names.size());
+    LOCK(cs);
+    for (size_t i = 0; i < names.size(); ++i) {
+        valtype value;
+        if (kevaMemPool.getUnconfirmedKeyValue(std::get<0>(names[i]), std::get<1>(names[i]), value)) {
+            values[i] = std::move(value);
+        }
+    }
+    return values;
+}
+
 void CTxMemPool::getUnconfirmedNamespaceList(std::vector<std::tuple<valtype, valtype, uint256>>& nameSpaces) const {
+    LOCK(cs);
     return kevaMemPool.getUnconfirmedNamespaceList(nameSpaces);
 }
 
-void CTxMemPool::getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) {
+void CTxMemPool::getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) const {
+    LOCK(cs);
     kevaMemPool.getUnconfirmedKeyValueList(keyValueList, nameSpace);
 }
+
+void CTxMemPool::getUnconfirmedGroupKeys(const valtype& nameSpace, std::vector<std::tuple<valtype, valtype, valtype>>& groupKeys) const {
+    LOCK(cs);
+    kevaMemPool.getUnconfirmedGroupKeys(nameSpace, groupKeys);
+}
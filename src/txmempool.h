@@ -707,11 +707,17 @@ public:
     /** Keva get unconfirmed key values. */
     bool getUnconfirmedKeyValue(const valtype& nameSpace, const valtype& key, valtype& value) const;
 
+    /** Keva get the unconfirmed values of many keys at once, holding the lock only once. */
+    std::vector<std::optional<valtype>> getUnconfirmedKeyValues(const std::vector<CKevaCache::NamespaceKeyType>& names) const;
+
     /** Keva get unconfirmed namespaces. */
     void getUnconfirmedNamespaceList(std::vector<std::tuple<valtype, valtype, uint256>>& nameSpaces) const;
 
     /** Keva get list of unconfirmed key value list. */
-    void getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace);
+    void getUnconfirmedKeyValueList(std::vector<std::tuple<valtype, valtype, valtype, uint256>>& keyValueList, const valtype& nameSpace) const;
+
+    /** Keva get the pending changes to the namespace group of a namespace. */
+    void getUnconfirmedGroupKeys(const valtype& nameSpace, std::vector<std::tuple<valtype, valtype, valtype>>& groupKeys) const;
    
     CTransactionRef get(const uint256& hash) const;
     txiter get_iter_from_wtxid(const uint256& wtxid) const EXCLUSIVE_LOCKS_REQUIRED(cs)
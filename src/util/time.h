@@ -106,6 +106,12 @@ T GetTime()
 std::string FormatISO8601DateTime(int64_t nTime);
 std::string FormatISO8601Date(int64_t nTime);
 
+/**
+ * Format a time as an HTTP date (RFC 7231 IMF-fixdate), for headers such as
+ * Last-Modified, e.g. "Fri, 30 Sep 2011 23:36:17 GMT".
+ */
+std::string FormatHTTPDateTime(int64_t nTime);
+
 /**
  * Convert milliseconds to a struct timeval for e.g. select.
  */
@@ -66,6 +66,7 @@
 #include <warnings.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
 #include <deque>
@@ -90,6 +91,8 @@ using node::BlockMap;
 using node::CBlockIndexHeightOnlyComparator;
 using node::CBlockIndexWorkComparator;
 using node::fReindex;
+using node::SNAPSHOT_KEVA_MAGIC;
+using node::SnapshotKevaReader;
 using node::SnapshotMetadata;
 
 /** Time to wait between writing blocks/block index to disk. */
@@ -840,29 +843,25 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     /* If this is a name update (or firstupdate), make sure that the
         existing name entry (if any) is in the dummy cache.  Otherwise
         tx validation done below (in CheckInputs) will not be correct.  */
-    for (const auto& txout : tx.vout)
+    for (const auto& [n, kevaOp] : tx.GetKevaOutputs())
     {
-        const CKevaScript kevaOp(txout.scriptPubKey);
-        if (!kevaOp.isKevaOp()) {
-            continue;
-        }
         if (kevaOp.isAnyUpdate()) {
             const valtype& nameSpace = kevaOp.getOpNamespace();
             const valtype& key = kevaOp.getOpKey();
             CKevaData data;
             // Make sure namespace info is in cache.
             if (m_view.GetNamespace(nameSpace, data)) {
-                m_view.SetKeyValue(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data, false);
+                m_view.SetKeyValue(nameSpace, ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY), data, false, data.getHeight());
             }
             if (m_view.GetName(nameSpace, key, data)) {
-                m_view.SetKeyValue(nameSpace, key, data, false);
+                m_view.SetKeyValue(nameSpace, key, data, false, data.getHeight());
             }
         } else if (kevaOp.isNamespaceRegistration()) {
             const valtype& nameSpace = kevaOp.getOpNamespace();
             const valtype& key = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
             CKevaData data;
             if (m_view.GetName(nameSpace, key, data)) {
-                m_view.SetKeyValue(nameSpace, key, data, false);
+                m_view.SetKeyValue(nameSpace, key, data, false, data.getHeight());
             }
         } else {
             assert(false);
@@ -951,6 +950,13 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     // carve-outs and package RBF are disabled for multi-transaction evaluations.
     CTxMemPool::Limits maybe_rbf_limits = m_pool.m_limits;
 
+    // Keva: updates of a namespace spend each other's keva output, so busy
+    // namespaces form long chains which have their own limit.
+    if (tx.IsKevacoin()) {
+        maybe_rbf_limits.ancestor_count = std::max(maybe_rbf_limits.ancestor_count, maybe_rbf_limits.keva_chain_count);
+        maybe_rbf_limits.descendant_count = std::max(maybe_rbf_limits.descendant_count, maybe_rbf_limits.keva_chain_count);
+    }
+
     // Calculate in-mempool ancestors, up to a limit.
     if (ws.m_conflicts.size() == 1) {
         // In general, when we receive an RBF transaction with mempool conflicts, we want to know whether we
@@ -1814,6 +1820,8 @@ void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
     m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview->SetKevaCacheSize(m_dbview.Options().keva_cache_bytes);
+    m_cacheview->SetKevaGroupCacheSize(m_dbview.Options().keva_group_cache_bytes);
 }
 
 Chainstate::Chainstate(
@@ -2206,9 +2214,10 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     }
 
     // undo keva operations in reverse order
+    view.PrefetchNames(GetKevaUndoNames(blockUndo));
     std::vector<CKevaTxUndo>::const_reverse_iterator kevaUndoIter;
     for (kevaUndoIter = blockUndo.vkevaundo.rbegin(); kevaUndoIter != blockUndo.vkevaundo.rend(); ++kevaUndoIter) {
-        kevaUndoIter->apply(view);
+        kevaUndoIter->apply(view, pindex->nHeight);
     }
 
     // move best block pointer to prevout block
@@ -2323,7 +2332,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // the clock to go backward).
-    if (!CheckBlock(block, state, params.GetConsensus(), !fJustCheck, !fJustCheck)) {
+    // Kevacoin: the CryptoNight/RandomX hash is expensive, so the proof of work
+    // is not recomputed for blocks whose proof of work was already verified
+    // (e.g. when reconnecting blocks during -reindex-chainstate).
+    const bool check_pow{!fJustCheck && !(m_chainman.m_options.trust_checked_pow && (pindex->nStatus & BLOCK_POW_CHECKED))};
+    if (!CheckBlock(block, state, params.GetConsensus(), check_pow, !fJustCheck)) {
         if (state.GetResult() == BlockValidationResult::BLOCK_MUTATED) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -2333,6 +2346,10 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         LogError("%s: Consensus::CheckBlock: %s\n", __func__, state.ToString());
         return false;
     }
+    if (!fJustCheck && !(pindex->nStatus & BLOCK_POW_CHECKED)) {
+        pindex->nStatus |= BLOCK_POW_CHECKED;
+        m_blockman.m_dirty_blockindex.insert(pindex);
+    }
 
     // verify that the view's current state corresponds to the previous block
     uint256 hashPrevBlock = pindex->pprev == nullptr ? uint256() : pindex->pprev->GetBlockHash();
@@ -2503,6 +2520,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int nInputs = 0;
     int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
+    // Keva notifications are only sent for blocks actually connected.
+    CKevaNotifier kevaNotifier(fJustCheck ? nullptr : m_chainman.m_options.signals);
+    // Read the old state of all names touched by the block in one go,
+    // instead of one database read per keva operation below.
+    view.PrefetchNames(GetKevaBlockNames(block));
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
@@ -2574,8 +2596,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         }
         UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight);
 
-        CKevaNotifier kevaNotifier(m_chainman.m_options.signals);
-        ApplyKevaTransaction(tx, pindex->nHeight, view, blockundo, kevaNotifier);
+        ApplyKevaTransaction(block.vtx[i], pindex->nHeight, view, blockundo, kevaNotifier);
     }
     const auto time_3{SteadyClock::now()};
     time_connect += time_3 - time_2;
@@ -2641,6 +2662,8 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         time_5 - time_start // in microseconds (µs)
     );
 
+    kevaNotifier.Flush();
+
     return true;
 }
 
@@ -2887,6 +2910,8 @@ void Chainstate::UpdateTip(const CBlockIndex* pindexNew)
         return;
     }
 
+    UpdatePoWSeedHashes(pindexNew);
+
     // New best block
     if (m_mempool) {
         m_mempool->AddTransactionsUpdated(1);
@@ -2935,7 +2960,6 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     CBlockIndex *pindexDelete = m_chain.Tip();
     assert(pindexDelete);
     assert(pindexDelete->pprev);
-    CheckNameDB(true);
     // Read block from disk.
     std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
     CBlock& block = *pblock;
@@ -2985,7 +3009,7 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     m_chain.SetTip(*pindexDelete->pprev);
 
     UpdateTip(pindexDelete->pprev);
-    CheckNameDB(true);
+    CheckNameDB(*this, /*disconnect=*/true);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     if (m_chainman.m_options.signals) {
@@ -3118,6 +3142,7 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     // Update m_chain & related variables.
     m_chain.SetTip(*pindexNew);
     UpdateTip(pindexNew);
+    CheckNameDB(*this, /*disconnect=*/false);
 
     const auto time_6{SteadyClock::now()};
     time_post_connect += time_6 - time_5;
@@ -4007,12 +4032,68 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
     return commitment;
 }
 
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+std::optional<std::vector<uint256>> GetHeadersSeedHashes(const std::vector<CBlockHeader>& headers, ChainstateManager& chainman,
+                                                         const std::map<uint64_t, uint256>& chain_seeds)
 {
-    // Disabled for speed, need to replace with less expensive check
-    // return std::all_of(headers.cbegin(), headers.cend(),
-    //         [&](const auto& header) { return CheckProofOfWork(header, header.nBits, consensusParams);});
-    return true;
+    std::vector<uint256> hashes;
+    hashes.reserve(headers.size());
+    for (const auto& header : headers) {
+        if (!hashes.empty() && header.hashPrevBlock != hashes.back()) return std::nullopt;
+        hashes.push_back(header.GetHash());
+    }
+
+    std::vector<uint256> seed_hashes(headers.size());
+    LOCK(cs_main);
+    const CBlockIndex* parent{headers.empty() ? nullptr : chainman.m_blockman.LookupBlockIndex(headers[0].hashPrevBlock)};
+    for (size_t i = 0; i < headers.size(); ++i) {
+        const CBlockHeader& header = headers[i];
+        if (header.cnHeader.major_version < RX_BLOCK_VERSION) continue;
+
+        // The height of a header is its nonce.  The seed block is either in
+        // the sequence, or before its first header.
+        const uint64_t height = header.nNonce;
+        const uint64_t seed_height = crypto::rx_seedheight(height);
+        const uint64_t distance = height - seed_height;
+        if (seed_height == 0) {
+            seed_hashes[i] = chainman.GetParams().GenesisBlock().GetHash();
+        } else if (distance <= i) {
+            seed_hashes[i] = hashes[i - distance];
+        } else if (parent != nullptr) {
+            const CBlockIndex* seed{parent->GetAncestor(seed_height)};
+            if (seed == nullptr) return std::nullopt;
+            seed_hashes[i] = seed->GetBlockHash();
+        } else if (auto it = chain_seeds.find(seed_height); it != chain_seeds.end()) {
+            seed_hashes[i] = it->second;
+        } else {
+            return std::nullopt;
+        }
+    }
+    return seed_hashes;
+}
+
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& seed_hashes,
+                         ChainstateManager& chainman)
+{
+    assert(seed_hashes.size() == headers.size());
+    // NOTE: Like CheckBlockHeader, always return true for REGTEST
+    if (chainman.GetParams().GetChainType() == ChainType::REGTEST) {
+        return true;
+    }
+    const Consensus::Params& consensusParams = chainman.GetConsensus();
+
+    std::vector<CPoWCheck> checks;
+    checks.reserve(headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        checks.emplace_back(headers[i], seed_hashes[i], consensusParams);
+    }
+
+    CCheckQueue<CPoWCheck>& queue = chainman.GetPoWCheckQueue();
+    if (!queue.HasThreads()) {
+        return std::all_of(checks.begin(), checks.end(), [](CPoWCheck& check) { return check(); });
+    }
+    CCheckQueueControl<CPoWCheck> control(&queue);
+    control.Add(std::move(checks));
+    return control.Wait();
 }
 
 bool IsBlockMutated(const CBlock& block, bool check_witness_root)
@@ -4346,6 +4427,12 @@ void ChainstateManager::ReportHeadersPresync(const arith_uint256& work, int64_t
 }
 
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
+bool IsTrustedBlockFilePoW(const CBlockIndex& index, const CBlockIndex* assumed_valid, const arith_uint256& minimum_chain_work)
+{
+    return assumed_valid && assumed_valid->nChainWork >= minimum_chain_work &&
+           assumed_valid->GetAncestor(index.nHeight) == &index;
+}
+
 bool ChainstateManager::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock, bool min_pow_checked)
 {
     const CBlock& block = *pblock;
@@ -4398,7 +4485,13 @@ bool ChainstateManager::AcceptBlock(const std::shared_ptr<const CBlock>& pblock,
 
     const CChainParams& params{GetParams()};
 
-    if (!CheckBlock(block, state, params.GetConsensus()) ||
+    // Blocks in our own block files (dbp is only set when reindexing) were
+    // written after their proof of work passed this same check.  The files
+    // may have been copied from elsewhere though, so the check is only
+    // skipped if asked for, and within the assumed valid chain.
+    const bool check_pow{!(dbp && m_options.trust_checked_pow &&
+                           IsTrustedBlockFilePoW(*pindex, m_blockman.LookupBlockIndex(AssumedValidBlock()), MinimumChainWork()))};
+    if (!CheckBlock(block, state, params.GetConsensus(), check_pow) ||
         !ContextualCheckBlock(block, state, *this, pindex->pprev)) {
         if (state.IsInvalid() && state.GetResult() != BlockValidationResult::BLOCK_MUTATED) {
             pindex->nStatus |= BLOCK_FAILED_VALID;
@@ -4407,6 +4500,8 @@ bool ChainstateManager::AcceptBlock(const std::shared_ptr<const CBlock>& pblock,
         LogError("%s: %s\n", __func__, state.ToString());
         return false;
     }
+    pindex->nStatus |= BLOCK_POW_CHECKED;
+    m_blockman.m_dirty_blockindex.insert(pindex);
 
     // Header is valid/has work, merkle tree and segwit merkle tree are good...RELAY NOW
     // (but if it does not build on our best tip, let the SendMessages loop relay it)
@@ -4471,16 +4566,6 @@ bool ChainstateManager::ProcessNewBlock(const std::shared_ptr<const CBlock>& blo
             LogError("%s: AcceptBlock FAILED (%s)\n", __func__, state.ToString());
             return false;
         }
-
-        CKevaNotifier kevaNotifier(m_options.signals);
-        CCoinsViewCache view(&ActiveChainstate().CoinsTip());
-        CBlockUndo blockundo;
-        blockundo.vtxundo.reserve(block->vtx.size() - 1);
-        for (unsigned int i = 0; i < block->vtx.size(); i++)
-        {
-            const CTransaction &tx = *(block->vtx[i]);
-            ApplyKevaTransaction(tx, pindex->nHeight, view, blockundo, kevaNotifier);
-        }
     }
 
     NotifyHeaderTip(*this);
@@ -4583,6 +4668,9 @@ bool Chainstate::LoadChainTip()
     PruneBlockIndexCandidates();
 
     tip = m_chain.Tip();
+    if (this == &m_chainman.ActiveChainstate()) {
+        UpdatePoWSeedHashes(tip);
+    }
     LogPrintf("Loaded best chain: hashBestChain=%s height=%d date=%s progress=%f\n",
               tip->GetBlockHash().ToString(),
               m_chain.Height(),
@@ -5815,14 +5903,17 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // method.
     coins_cache.SetBestBlock(base_blockhash);
 
+    // The coins are followed by the keva section, if there are any keva
+    // records, and nothing else.
+    std::array<uint8_t, 4> keva_magic;
     bool out_of_coins{false};
     try {
-        coins_file >> outpoint;
+        coins_file >> keva_magic;
     } catch (const std::ios_base::failure&) {
-        // We expect an exception since we should be out of coins.
+        // We expect an exception if there are no keva records.
         out_of_coins = true;
     }
-    if (!out_of_coins) {
+    if (!out_of_coins && keva_magic != SNAPSHOT_KEVA_MAGIC) {
         LogPrintf("[snapshot] bad snapshot - coins left over after deserializing %d coins\n",
             coins_count);
         return false;
@@ -5833,6 +5924,55 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
         coins_cache.DynamicMemoryUsage() / (1000 * 1000),
         base_blockhash.ToString());
 
+    if (!out_of_coins) {
+        // Keva records go straight to the database, which is much faster
+        // than taking them through the coins cache.
+        CKevaDBLoader keva_loader{*WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB())};
+        uint64_t keva_count{0};
+        uint64_t keva_processed{0};
+        try {
+            SnapshotKevaReader keva_reader{coins_file, keva_count};
+            bool association;
+            valtype nameSpace;
+            valtype key;
+            CKevaData data;
+            for (; keva_processed < keva_count; ++keva_processed) {
+                keva_reader.Read(association, nameSpace, key, data);
+                if (data.getHeight() > static_cast<unsigned>(base_height)) {
+                    LogPrintf("[snapshot] bad snapshot data after deserializing %d keva records\n",
+                              keva_processed);
+                    return false;
+                }
+                keva_loader.Add(association, nameSpace, key, data);
+
+                if (keva_processed % 120000 == 0 && m_interrupt) {
+                    return false;
+                }
+            }
+        } catch (const std::ios_base::failure&) {
+            LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d keva records\n",
+                      keva_processed);
+            return false;
+        }
+        keva_loader.Commit();
+
+        bool out_of_keva{false};
+        try {
+            uint8_t left_over;
+            coins_file >> left_over;
+        } catch (const std::ios_base::failure&) {
+            out_of_keva = true;
+        }
+        if (!out_of_keva) {
+            LogPrintf("[snapshot] bad snapshot - data left over after deserializing %d keva records\n",
+                keva_count);
+            return false;
+        }
+
+        LogPrintf("[snapshot] loaded %d keva records from snapshot %s\n",
+            keva_count, base_blockhash.ToString());
+    }
+
     // No need to acquire cs_main since this chainstate isn't being used yet.
     FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
 
@@ -6118,6 +6258,7 @@ static ChainstateManager::Options&& Flatten(ChainstateManager::Options&& opts)
 
 ChainstateManager::ChainstateManager(const util::SignalInterrupt& interrupt, Options options, node::BlockManager::Options blockman_options)
     : m_script_check_queue{/*batch_size=*/128, options.worker_threads_num},
+      m_pow_check_queue{/*batch_size=*/8, options.worker_threads_num, "powcheck"},
       m_interrupt{interrupt},
       m_options{Flatten(std::move(options))},
       m_blockman{interrupt, std::move(blockman_options)}
@@ -20,6 +20,7 @@
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <script/script_error.h>
 #include <sync.h>
 #include <txdb.h>
@@ -379,6 +380,14 @@ uint256 GetSeedBlockHash(ChainstateManager& chainMgr, uint64_t seed_height);
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/**
+ * Whether the proof of work of a block read from our own block files during
+ * -reindex may be trusted with -trustcheckedpow instead of being recomputed:
+ * the block must be an ancestor of the assumed valid block, and that must
+ * have at least the minimum chain work.
+ */
+bool IsTrustedBlockFilePoW(const CBlockIndex& index, const CBlockIndex* assumed_valid, const arith_uint256& minimum_chain_work);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
@@ -388,8 +397,28 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-/** Check with the proof of work on each blockheader matches the value in nBits */
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/**
+ * Look up the RandomX seed block hash of each of a continuous sequence of
+ * headers in their ancestry: earlier headers of the sequence, the block index
+ * entry of the parent of the first header, or chain_seeds.
+ * @param[in] chain_seeds  Seed block hashes by height of the chain the headers
+ *                         continue, for when their parent is not in the block
+ *                         index yet (e.g. during a low-work headers sync).
+ * @returns The seed block hash of each header (null before RandomX), or
+ *          std::nullopt if the headers are not continuous or a seed block
+ *          is not known.
+ */
+std::optional<std::vector<uint256>> GetHeadersSeedHashes(const std::vector<CBlockHeader>& headers, ChainstateManager& chainman,
+                                                         const std::map<uint64_t, uint256>& chain_seeds = {});
+
+/**
+ * Check with the proof of work on each blockheader matches the value in nBits.
+ * The hashes are computed in parallel on the PoW check queue of chainman.
+ * @param[in] seed_hashes  The RandomX seed block hash of each header, as
+ *                         returned by GetHeadersSeedHashes.
+ */
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& seed_hashes,
+                         ChainstateManager& chainman);
 
 /** Check if a block has been mutated (with respect to its merkle root and witness commitments). */
 bool IsBlockMutated(const CBlock& block, bool check_witness_root);
@@ -932,6 +961,9 @@ private:
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
 
+    //! A queue for the proof of work checks of headers, see HasValidProofOfWork.
+    CCheckQueue<CPoWCheck> m_pow_check_queue;
+
 public:
     using Options = kernel::ChainstateManagerOpts;
 
@@ -1286,6 +1318,7 @@ public:
     std::optional<int> GetSnapshotBaseHeight() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    CCheckQueue<CPoWCheck>& GetPoWCheckQueue() { return m_pow_check_queue; }
 
     // //! Add seed and block mapping.
     // void AddSeedBlock(uint64_t height, CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
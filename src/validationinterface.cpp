@@ -15,6 +15,7 @@
 #include <util/check.h>
 #include <util/task_runner.h>
 
+#include <atomic>
 #include <future>
 #include <unordered_map>
 #include <utility>
@@ -37,21 +38,28 @@ private:
     //! count is equal to the number of current executions of that entry, plus 1
     //! if it's registered. It cannot be 0 because that would imply it is
     //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; };
+    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; bool keva = false; };
     std::list<ListEntry> m_list GUARDED_BY(m_mutex);
     std::unordered_map<CValidationInterface*, std::list<ListEntry>::iterator> m_map GUARDED_BY(m_mutex);
 
 public:
+    //! Number of registered callbacks that want keva notifications.
+    std::atomic<int> m_keva_listeners{0};
+
     std::unique_ptr<util::TaskRunnerInterface> m_task_runner;
 
     explicit ValidationSignalsImpl(std::unique_ptr<util::TaskRunnerInterface> task_runner)
         : m_task_runner{std::move(Assert(task_runner))} {}
 
-    void Register(std::shared_ptr<CValidationInterface> callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    void Register(std::shared_ptr<CValidationInterface> callbacks, bool keva) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         LOCK(m_mutex);
         auto inserted = m_map.emplace(callbacks.get(), m_list.end());
-        if (inserted.second) inserted.first->second = m_list.emplace(m_list.end());
+        if (inserted.second) {
+            inserted.first->second = m_list.emplace(m_list.end());
+            inserted.first->second->keva = keva;
+            if (keva) ++m_keva_listeners;
+        }
         inserted.first->second->callbacks = std::move(callbacks);
     }
 
@@ -60,6 +68,7 @@ public:
         LOCK(m_mutex);
         auto it = m_map.find(callbacks);
         if (it != m_map.end()) {
+            if (it->second->keva) --m_keva_listeners;
             if (!--it->second->count) m_list.erase(it->second);
             m_map.erase(it);
         }
@@ -73,6 +82,7 @@ public:
     {
         LOCK(m_mutex);
         for (const auto& entry : m_map) {
+            if (entry.second->keva) --m_keva_listeners;
             if (!--entry.second->count) m_list.erase(entry.second);
         }
         m_map.clear();
@@ -111,7 +121,8 @@ void ValidationSignals::RegisterSharedValidationInterface(std::shared_ptr<CValid
 {
     // Each connection captures the shared_ptr to ensure that each callback is
     // executed before the subscriber is destroyed. For more details see #18338.
-    m_internals->Register(std::move(callbacks));
+    const bool keva{callbacks->WantsKevaNotifications()};
+    m_internals->Register(std::move(callbacks), keva);
 }
 
 void ValidationSignals::RegisterValidationInterface(CValidationInterface* callbacks)
@@ -251,6 +262,10 @@ void ValidationSignals::NewPoWValidBlock(const CBlockIndex *pindex, const std::s
     m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.NewPoWValidBlock(pindex, block); });
 }
 
+bool ValidationSignals::HasKevaListeners() const {
+    return m_internals->m_keva_listeners > 0;
+}
+
 void ValidationSignals::KevaNamespaceCreated(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace) {
     m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.KevaNamespaceCreated(ptx, nHeight, nameSpace); });
 }
@@ -150,21 +150,35 @@ protected:
     virtual void BlockChecked(const CBlock&, const BlockValidationState&) {}
     
     
+    /**
+     * Keva related interface.
+     * Return true to receive the Keva* notifications below.  Keva
+     * operations are only recorded during block connection if a registered
+     * listener wants them.
+     */
+    virtual bool WantsKevaNotifications() const { return false; }
+
     /**
      * Keva related interface.
      * Notifies listeners of a new namespace.
+     *
+     * Called on a background thread.
      */
     virtual void KevaNamespaceCreated(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace) {}
 
     /**
      * Keva related interface.
      * Notifies listeners of a key creation or update.
+     *
+     * Called on a background thread.
      */
     virtual void KevaUpdated(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace, const std::string& key, const std::string& value) {}
 
     /**
      * Keva related interface.
-     * Notifies listeners of a key creation or update.
+     * Notifies listeners of a key deletion.
+     *
+     * Called on a background thread.
      */
     virtual void KevaDeleted(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace, const std::string& key) {}
 
@@ -244,6 +258,8 @@ public:
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
 
     /** Keva related */
+    /** Whether any registered subscriber wants the keva notifications */
+    bool HasKevaListeners() const;
     void KevaNamespaceCreated(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace);
     void KevaUpdated(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace, const std::string& key, const std::string& value);
     void KevaDeleted(const CTransactionRef &ptx, int nHeight, const std::string& nameSpace, const std::string& key);
@@ -2392,8 +2392,9 @@ std::unique_ptr<FlatSigningProvider> DescriptorScriptPubKeyMan::GetSigningProvid
 
     // Find the index of the script
     // If we have a keva script, strip the prefix
-    const CKevaScript kevaOp(script);
-    const CScript& script1 = kevaOp.getAddress();
+    std::optional<CKevaScript> kevaOp;
+    if (CKevaScript::hasKevaPrefix(script)) kevaOp.emplace(script);
+    const CScript& script1 = kevaOp ? kevaOp->getAddress() : script;
     auto it = m_map_script_pub_keys.find(script1);
     if (it == m_map_script_pub_keys.end()) {
         return nullptr;
@@ -132,8 +132,9 @@ static std::optional<int64_t> GetSignedTxinWeight(const CWallet* wallet, const C
 
     // Otherwise, use the maximum satisfaction size provided by the descriptor.
     // If we have a keva script, strip the prefix
-    const CKevaScript kevaOp(txo.scriptPubKey);
-    const CScript& script1 = kevaOp.getAddress();
+    std::optional<CKevaScript> kevaOp;
+    if (CKevaScript::hasKevaPrefix(txo.scriptPubKey)) kevaOp.emplace(txo.scriptPubKey);
+    const CScript& script1 = kevaOp ? kevaOp->getAddress() : txo.scriptPubKey;
     std::unique_ptr<Descriptor> desc{GetDescriptor(wallet, coin_control, script1)};
     if (desc) return MaxInputWeight(*desc, {txin}, coin_control, tx_is_segwit, can_grind_r);
 
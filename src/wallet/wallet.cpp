@@ -1606,8 +1606,9 @@ isminetype CWallet::IsMine(const CScript& script) const
     AssertLockHeld(cs_wallet);
 
     // If we have a keva script, strip the prefix
-    const CKevaScript kevaOp(script);
-    const CScript& script1 = kevaOp.getAddress();
+    std::optional<CKevaScript> kevaOp;
+    if (CKevaScript::hasKevaPrefix(script)) kevaOp.emplace(script);
+    const CScript& script1 = kevaOp ? kevaOp->getAddress() : script;
     // Search the cache so that IsMine is called only on the relevant SPKMs instead of on everything in m_spk_managers
     const auto& it = m_cached_spks.find(script1);
     if (it != m_cached_spks.end()) {
@@ -3586,8 +3587,9 @@ std::unique_ptr<SigningProvider> CWallet::GetSolvingProvider(const CScript& scri
 {
     SignatureData sigdata;
     // If we have a keva script, strip the prefix
-    const CKevaScript kevaOp(script);
-    const CScript& script1 = kevaOp.getAddress();
+    std::optional<CKevaScript> kevaOp;
+    if (CKevaScript::hasKevaPrefix(script)) kevaOp.emplace(script);
+    const CScript& script1 = kevaOp ? kevaOp->getAddress() : script;
     return GetSolvingProvider(script1, sigdata);
 }
 
@@ -42,3 +42,8 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyKevaOps(const CBlockIndex * /*CBlockIndex*/, const std::vector<ZMQKevaOp>& /*ops*/, bool /*connected*/)
+{
+    return true;
+}
@@ -5,15 +5,34 @@
 #ifndef KEVACOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 #define KEVACOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
+#include <uint256.h>
+
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
 
+/** A keva operation of a connected or disconnected block. */
+struct ZMQKevaOp
+{
+    enum class Type { NAMESPACE, UPDATE, DELETION };
+
+    Type type;
+    std::vector<unsigned char> nameSpace;
+    //! The display name key for namespace registrations.
+    std::vector<unsigned char> key;
+    //! The display name for namespace registrations, empty for deletions.
+    std::vector<unsigned char> value;
+    uint256 txid;
+    //! Position of the operation among the keva operations of the block.
+    uint32_t sequence{0};
+};
+
 using CZMQNotifierFactory = std::function<std::unique_ptr<CZMQAbstractNotifier>()>;
 
 class CZMQAbstractNotifier
@@ -56,6 +75,8 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of the keva operations of every block connection and disconnection
+    virtual bool NotifyKevaOps(const CBlockIndex *pindex, const std::vector<ZMQKevaOp>& ops, bool connected);
 
 protected:
     void* psocket{nullptr};
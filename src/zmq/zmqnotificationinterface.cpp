@@ -7,9 +7,11 @@
 #include <common/args.h>
 #include <kernel/chain.h>
 #include <kernel/mempool_entry.h>
+#include <keva/common.h>
 #include <logging.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <script/keva.h>
 #include <validationinterface.h>
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqpublishnotifier.h>
@@ -17,6 +19,7 @@
 
 #include <zmq.h>
 
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <string>
@@ -51,6 +54,15 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(std
     };
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubkevans"] = []() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishKevaNotifier>(ZMQKevaOp::Type::NAMESPACE);
+    };
+    factories["pubkevaupdate"] = []() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishKevaNotifier>(ZMQKevaOp::Type::UPDATE);
+    };
+    factories["pubkevadelete"] = []() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishKevaNotifier>(ZMQKevaOp::Type::DELETION);
+    };
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -141,6 +153,53 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
     }
 }
 
+// The keva operations of a block, in the order they are applied to the keva
+// state.  These are taken from the block rather than from the KevaUpdated
+// etc. signals, which are sent synchronously from ConnectBlock, also for
+// block templates being tested, and carry no block boundaries.
+std::vector<ZMQKevaOp> GetKevaOps(const CBlock& block)
+{
+    std::vector<ZMQKevaOp> ops;
+    for (const CTransactionRef& ptx : block.vtx) {
+        if (!ptx->IsKevacoin()) continue;
+        for (const auto& [n, kevaOp] : ptx->GetKevaOutputs()) {
+            ZMQKevaOp op{.nameSpace = kevaOp.getOpNamespace(), .txid = ptx->GetHash(), .sequence = static_cast<uint32_t>(ops.size())};
+            if (kevaOp.isNamespaceRegistration()) {
+                op.type = ZMQKevaOp::Type::NAMESPACE;
+                op.key = ValtypeFromString(CKevaScript::KEVA_DISPLAY_NAME_KEY);
+                op.value = kevaOp.getOpNamespaceDisplayName();
+            } else if (kevaOp.isDelete()) {
+                op.type = ZMQKevaOp::Type::DELETION;
+                op.key = kevaOp.getOpKey();
+            } else {
+                op.type = ZMQKevaOp::Type::UPDATE;
+                op.key = kevaOp.getOpKey();
+                op.value = kevaOp.getOpValue();
+            }
+            ops.push_back(std::move(op));
+        }
+    }
+    return ops;
+}
+
+// All keva operations of a block are batched into one message per topic.
+// Only collect them if anyone subscribed to a keva topic.
+void NotifyKevaOps(std::list<std::unique_ptr<CZMQAbstractNotifier>>& notifiers, const CBlock& block, const CBlockIndex* pindex, bool connected)
+{
+    const bool has_keva_notifier{std::any_of(notifiers.begin(), notifiers.end(), [](const auto& notifier) {
+        return dynamic_cast<const CZMQPublishKevaNotifier*>(notifier.get()) != nullptr;
+    })};
+    if (!has_keva_notifier) {
+        return;
+    }
+    const std::vector<ZMQKevaOp> keva_ops{GetKevaOps(block)};
+    if (!keva_ops.empty()) {
+        TryForEachAndRemoveFailed(notifiers, [pindex, &keva_ops, connected](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyKevaOps(pindex, keva_ops, connected);
+        });
+    }
+}
+
 } // anonymous namespace
 
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
@@ -188,6 +247,8 @@ void CZMQNotificationInterface::BlockConnected(ChainstateRole role, const std::s
     TryForEachAndRemoveFailed(notifiers, [pindexConnected](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyBlockConnect(pindexConnected);
     });
+
+    NotifyKevaOps(notifiers, *pblock, pindexConnected, /*connected=*/true);
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
@@ -203,6 +264,8 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     TryForEachAndRemoveFailed(notifiers, [pindexDisconnected](CZMQAbstractNotifier* notifier) {
         return notifier->NotifyBlockDisconnect(pindexDisconnected);
     });
+
+    NotifyKevaOps(notifiers, *pblock, pindexDisconnected, /*connected=*/false);
 }
 
 std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
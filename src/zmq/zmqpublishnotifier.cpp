@@ -23,6 +23,7 @@
 
 #include <zmq.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstddef>
@@ -45,6 +46,9 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_KEVANS     = "kevans";
+static const char *MSG_KEVAUPDATE = "kevaupdate";
+static const char *MSG_KEVADELETE = "kevadelete";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -301,3 +305,40 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+// Write a hash in the byte order of the hashblock and hashtx bodies
+static void WriteReversedHash(DataStream& ss, uint256 hash)
+{
+    std::reverse(hash.begin(), hash.end());
+    ss << hash;
+}
+
+// Send all keva operations of one type in a block as a single message:
+//    <4-byte LE height> | <32-byte block hash> | <1-byte label> | <compact size count> | count * entry
+// with the label being 'C' for a connected and 'D' for a disconnected block,
+// and each entry being
+//    <namespace> | <key> | <value> | <32-byte txid> | <4-byte LE sequence>
+// where namespace, key and value are prefixed with their compact size length.
+bool CZMQPublishKevaNotifier::NotifyKevaOps(const CBlockIndex *pindex, const std::vector<ZMQKevaOp>& ops, bool connected)
+{
+    const size_t count = std::count_if(ops.begin(), ops.end(), [this](const ZMQKevaOp& op) { return op.type == m_op_type; });
+    if (count == 0) return true;
+
+    const char* command = m_op_type == ZMQKevaOp::Type::NAMESPACE ? MSG_KEVANS :
+                          m_op_type == ZMQKevaOp::Type::UPDATE ? MSG_KEVAUPDATE : MSG_KEVADELETE;
+    LogPrint(BCLog::ZMQ, "Publish %s %s %s (%u ops) to %s\n", command, connected ? "connect" : "disconnect",
+             pindex->GetBlockHash().GetHex(), count, this->address);
+
+    DataStream ss;
+    ss << static_cast<uint32_t>(pindex->nHeight);
+    WriteReversedHash(ss, pindex->GetBlockHash());
+    ss << static_cast<uint8_t>(connected ? 'C' : 'D');
+    WriteCompactSize(ss, count);
+    for (const ZMQKevaOp& op : ops) {
+        if (op.type != m_op_type) continue;
+        ss << op.nameSpace << op.key << op.value;
+        WriteReversedHash(ss, op.txid);
+        ss << op.sequence;
+    }
+    return SendZmqMessage(command, ss.data(), ss.size());
+}
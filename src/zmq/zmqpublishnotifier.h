@@ -72,4 +72,14 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+class CZMQPublishKevaNotifier : public CZMQAbstractPublishNotifier
+{
+private:
+    const ZMQKevaOp::Type m_op_type;
+
+public:
+    explicit CZMQPublishKevaNotifier(ZMQKevaOp::Type op_type) : m_op_type{op_type} {}
+    bool NotifyKevaOps(const CBlockIndex *pindex, const std::vector<ZMQKevaOp>& ops, bool connected) override;
+};
+
 #endif // KEVACOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -7,14 +7,22 @@
 from decimal import Decimal
 from enum import Enum
 import http.client
+from io import BytesIO
 import json
 import typing
 import urllib.parse
 
 
+from test_framework.address import byte_to_base58
+from test_framework.keva import KevaNamespace
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    deser_compact_size,
+    deser_string,
+    deser_uint256,
+    ser_compact_size,
+    ser_string,
 )
 from test_framework.test_framework import KevacoinTestFramework
 from test_framework.util import (
@@ -43,6 +51,17 @@ class RetType(Enum):
     BYTES = 2
     JSON = 3
 
+def deser_keva_rest_entry(f):
+    """Deserialize an entry of the keva REST responses as (state, value, height, txid, vout)."""
+    state = f.read(1)[0]
+    value = deser_string(f) if state != 0 else b""
+    if state != 1:
+        return state, value, None, None, None
+    height = int.from_bytes(f.read(4), 'little')
+    txid = f.read(32)[::-1].hex()
+    vout = int.from_bytes(f.read(4), 'little')
+    return state, value, height, txid, vout
+
 def filter_output_indices_by_value(vouts, value):
     for vout in vouts:
         if vout['value'] == value:
@@ -65,6 +84,7 @@ class RESTTest (KevacoinTestFramework):
             status: int = 200,
             ret_type: RetType = RetType.JSON,
             query_params: Optional[dict[str, typing.Any]] = None,
+            headers: Optional[dict[str, str]] = None,
             ) -> typing.Union[http.client.HTTPResponse, bytes, str, None]:
         rest_uri = '/rest' + uri
         if req_type in ReqType:
@@ -75,9 +95,9 @@ class RESTTest (KevacoinTestFramework):
         conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
         self.log.debug(f'{http_method} {rest_uri} {body}')
         if http_method == 'GET':
-            conn.request('GET', rest_uri)
+            conn.request('GET', rest_uri, headers=headers or {})
         elif http_method == 'POST':
-            conn.request('POST', rest_uri, body)
+            conn.request('POST', rest_uri, body, headers=headers or {})
         resp = conn.getresponse()
 
         assert_equal(resp.status, status)
@@ -435,5 +455,156 @@ class RESTTest (KevacoinTestFramework):
         resp = self.test_rest_request(f"/deploymentinfo/{INVALID_PARAM}", ret_type=RetType.OBJ, status=400)
         assert_equal(resp.read().decode('utf-8').rstrip(), f"Invalid hash: {INVALID_PARAM}")
 
+        self.test_keva_get_multi()
+        self.test_keva_namespace()
+
+    def test_keva_get_multi(self):
+        self.log.info("Test the /kevagetmulti URI")
+        self.wallet.rescan_utxos()
+        namespace = KevaNamespace(self.wallet, b"name")
+        txs = [namespace.last_tx, namespace.put(b"k1", b"v1"), namespace.put(b"k2", b"v2")]
+        self.generateblock(self.nodes[0], self.wallet.get_address(), [tx.serialize().hex() for tx in txs])
+        height = self.nodes[0].getblockcount()
+        tip = self.nodes[0].getbestblockhash()
+        namespace_b58 = byte_to_base58(namespace.id[1:], namespace.id[0])
+
+        # Results follow the request order, missing keys included.
+        keys = [b"k2", b"missing", b"k1"]
+        uri = "/kevagetmulti/" + "/".join(f"{namespace_b58}-{key.hex()}" for key in keys)
+        json_obj = self.test_rest_request(uri)
+        assert_equal(json_obj["chainHeight"], height)
+        assert_equal(json_obj["chaintipHash"], tip)
+        assert_equal(json_obj["entries"], [
+            {"namespace": namespace_b58, "key": "k2", "value": "v2", "txid": txs[2].hash, "vout": 0, "height": height},
+            {"namespace": namespace_b58, "key": "missing", "value": ""},
+            {"namespace": namespace_b58, "key": "k1", "value": "v1", "txid": txs[1].hash, "vout": 0, "height": height},
+        ])
+
+        def check_bin_response(response):
+            f = BytesIO(response)
+            assert_equal(int.from_bytes(f.read(4), 'little'), height)
+            assert_equal(f"{deser_uint256(f):064x}", tip)
+            entries = [deser_keva_rest_entry(f) for _ in range(deser_compact_size(f))]
+            assert_equal(f.read(), b"")
+            assert_equal(entries, [
+                (1, b"v2", height, txs[2].hash, 0),
+                (0, b"", None, None, None),
+                (1, b"v1", height, txs[1].hash, 0),
+            ])
+
+        bin_response = self.test_rest_request(uri, req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        check_bin_response(bin_response)
+        hex_response = self.test_rest_request(uri, req_type=ReqType.HEX, ret_type=RetType.BYTES)
+        assert_equal(hex_response.decode().rstrip(), bin_response.hex())
+
+        # The keys can also be posted in the binary formats.
+        bin_request = ser_compact_size(len(keys)) + b"".join(ser_string(namespace.id) + ser_string(key) for key in keys)
+        check_bin_response(self.test_rest_request("/kevagetmulti", http_method='POST', req_type=ReqType.BIN, body=bin_request, ret_type=RetType.BYTES))
+        hex_response = self.test_rest_request("/kevagetmulti", http_method='POST', req_type=ReqType.HEX, body=bin_request.hex(), ret_type=RetType.BYTES)
+        assert_equal(hex_response.decode().rstrip(), bin_response.hex())
+
+        # Posted keys cannot be combined with keys in the URI, and must be complete.
+        self.test_rest_request(uri, http_method='POST', req_type=ReqType.BIN, body=bin_request, status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/kevagetmulti", http_method='POST', req_type=ReqType.BIN, body=bin_request[:-1], status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/kevagetmulti", http_method='POST', req_type=ReqType.BIN, body=bin_request + b"\x00", status=400, ret_type=RetType.OBJ)
+        self.test_rest_request("/kevagetmulti", http_method='POST', req_type=ReqType.JSON, body=bin_request, status=400, ret_type=RetType.OBJ)
+        self.test_rest_request(f"/kevagetmulti/{namespace_b58}-{INVALID_PARAM}", status=400, ret_type=RetType.OBJ)
+
+    def check_not_modified(self, uri, query_params=None):
+        """Check that a response is only sent again once its ETag changed, and return the ETag."""
+        resp = self.test_rest_request(uri, ret_type=RetType.OBJ, query_params=query_params)
+        resp.read()
+        etag = resp.getheader("ETag")
+        assert etag is not None
+        assert resp.getheader("Last-Modified") is not None
+        for req_type in ReqType:
+            resp = self.test_rest_request(uri, req_type=req_type, status=304, ret_type=RetType.OBJ, query_params=query_params, headers={"If-None-Match": etag})
+            assert_equal(resp.read(), b"")
+            assert_equal(resp.getheader("ETag"), etag)
+        self.test_rest_request(uri, status=304, ret_type=RetType.OBJ, query_params=query_params, headers={"If-None-Match": "*"})
+        self.test_rest_request(uri, ret_type=RetType.OBJ, query_params=query_params, headers={"If-None-Match": '"other"'})
+        return etag
+
+    def test_keva_namespace(self):
+        self.log.info("Test the /keva and /kevanamespace URIs")
+        self.wallet.rescan_utxos()
+        namespace = KevaNamespace(self.wallet, b"list")
+        keys = [b"k1", b"k2", b"k3"]
+        txs = [namespace.last_tx] + [namespace.put(key, b"v" + key) for key in keys]
+        self.generateblock(self.nodes[0], self.wallet.get_address(), [tx.serialize().hex() for tx in txs])
+        height = self.nodes[0].getblockcount()
+        namespace_b58 = byte_to_base58(namespace.id[1:], namespace.id[0])
+        entries = [{"namespace": namespace_b58, "key": key.decode(), "value": "v" + key.decode(), "txid": tx.hash, "vout": 0, "height": height}
+                   for key, tx in zip(keys, txs[1:])]
+
+        # /keva returns a single entry, in the format of /kevagetmulti.
+        uri = f"/keva/{namespace_b58}/{b'k2'.hex()}"
+        assert_equal(self.test_rest_request(uri), entries[1])
+        bin_response = self.test_rest_request(uri, req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        f = BytesIO(bin_response)
+        assert_equal(deser_keva_rest_entry(f), (1, b"vk2", height, txs[2].hash, 0))
+        assert_equal(f.read(), b"")
+        hex_response = self.test_rest_request(uri, req_type=ReqType.HEX, ret_type=RetType.BYTES)
+        assert_equal(hex_response.decode().rstrip(), bin_response.hex())
+
+        self.test_rest_request(f"/keva/{namespace_b58}/{b'missing'.hex()}", status=404, ret_type=RetType.OBJ)
+        self.test_rest_request(f"/keva/{INVALID_PARAM}/{b'k2'.hex()}", status=400, ret_type=RetType.OBJ)
+        self.test_rest_request(f"/keva/{namespace_b58}/{INVALID_PARAM}", status=400, ret_type=RetType.OBJ)
+
+        # /kevanamespace lists the keys in order, in pages of at most count entries.
+        uri = f"/kevanamespace/{namespace_b58}"
+        assert_equal(self.test_rest_request(uri), {"entries": entries})
+        page = self.test_rest_request(uri, query_params={"count": 2})
+        assert_equal(page, {"entries": entries[:2], "next": b"k3".hex()})
+        page = self.test_rest_request(uri, query_params={"start": page["next"], "count": 2})
+        assert_equal(page, {"entries": entries[2:]})
+
+        def deser_namespace_response(response):
+            f = BytesIO(response)
+            result = [(deser_string(f), deser_keva_rest_entry(f)) for _ in range(deser_compact_size(f))]
+            next_key = deser_string(f)
+            assert_equal(f.read(), b"")
+            return result, next_key
+
+        bin_response = self.test_rest_request(uri, req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 2})
+        assert_equal(deser_namespace_response(bin_response), (
+            [(key, (1, b"v" + key, height, tx.hash, 0)) for key, tx in zip(keys[:2], txs[1:3])], b"k3"))
+        hex_response = self.test_rest_request(uri, req_type=ReqType.HEX, ret_type=RetType.BYTES, query_params={"count": 2})
+        assert_equal(hex_response.decode().rstrip(), bin_response.hex())
+        bin_response = self.test_rest_request(uri, req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"start": b"k3".hex()})
+        assert_equal(deser_namespace_response(bin_response), ([(b"k3", (1, b"vk3", height, txs[3].hash, 0))], b""))
+
+        for count in [0, 1001, INVALID_PARAM]:
+            self.test_rest_request(uri, status=400, ret_type=RetType.OBJ, query_params={"count": count})
+        self.test_rest_request(uri, status=400, ret_type=RetType.OBJ, query_params={"start": INVALID_PARAM})
+        self.test_rest_request(f"/kevanamespace/{INVALID_PARAM}", status=400, ret_type=RetType.OBJ)
+
+        self.log.info("Test the caching headers of the keva URIs")
+        key_uri = f"/keva/{namespace_b58}/{b'k2'.hex()}"
+        key_etag = self.check_not_modified(key_uri)
+        page_etag = self.check_not_modified(uri, query_params={"count": 2})
+        last_page_etag = self.check_not_modified(uri, query_params={"start": b"k3".hex()})
+
+        # A new block that does not change the entries keeps the ETags.
+        self.generate(self.nodes[0], 1)
+        assert_equal(self.check_not_modified(key_uri), key_etag)
+        assert_equal(self.check_not_modified(uri, query_params={"count": 2}), page_etag)
+
+        # Updating a key changes the ETags of the responses that contain it.
+        tx = namespace.put(b"k2", b"new")
+        self.generateblock(self.nodes[0], self.wallet.get_address(), [tx.serialize().hex()])
+        for etag_uri, query_params, etag in [(key_uri, None, key_etag), (uri, {"count": 2}, page_etag)]:
+            self.test_rest_request(etag_uri, ret_type=RetType.OBJ, query_params=query_params, headers={"If-None-Match": etag})
+            assert self.check_not_modified(etag_uri, query_params=query_params) != etag
+        assert_equal(self.check_not_modified(uri, query_params={"start": b"k3".hex()}), last_page_etag)
+
+        # Deleting a key changes the ETag of its page, although no height grows.
+        page_etag = self.check_not_modified(uri)
+        tx = namespace.delete(b"k1")
+        self.generateblock(self.nodes[0], self.wallet.get_address(), [tx.serialize().hex()])
+        self.test_rest_request(uri, ret_type=RetType.OBJ, headers={"If-None-Match": page_etag})
+        page = self.test_rest_request(uri)
+        assert_equal([entry["key"] for entry in page["entries"]], ["k2", "k3"])
+
 if __name__ == '__main__':
     RESTTest().main()
@@ -17,8 +17,14 @@ from test_framework.blocktools import (
     create_coinbase,
 )
 from test_framework.test_framework import KevacoinTestFramework
+from test_framework.keva import (
+    KEVA_DISPLAY_NAME_KEY,
+    KevaNamespace,
+)
 from test_framework.messages import (
     CBlock,
+    deser_compact_size,
+    deser_string,
     hash256,
     tx_from_hex,
 )
@@ -42,6 +48,22 @@ except ImportError:
 def hash256_reversed(byte_str):
     return hash256(byte_str)[::-1]
 
+def parse_keva_notification(body):
+    f = BytesIO(body)
+    height = struct.unpack("<I", f.read(4))[0]
+    block_hash = f.read(32).hex()
+    label = chr(f.read(1)[0])
+    ops = []
+    for _ in range(deser_compact_size(f)):
+        namespace = deser_string(f)
+        key = deser_string(f)
+        value = deser_string(f)
+        txid = f.read(32).hex()
+        sequence = struct.unpack("<I", f.read(4))[0]
+        ops.append((namespace, key, value, txid, sequence))
+    assert_equal(f.read(), b"")
+    return height, block_hash, label, ops
+
 class ZMQSubscriber:
     def __init__(self, socket, topic):
         self.sequence = None  # no sequence number received yet
@@ -124,6 +146,7 @@ class ZMQTest (KevacoinTestFramework):
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
+            self.test_keva()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -580,6 +603,85 @@ class ZMQTest (KevacoinTestFramework):
         # Should receive the same block hash
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
 
+    def receive_keva_notifications(self, socket, sequences):
+        """Receive the keva notifications up to the next hashblock
+        notification, i.e. those of the blocks disconnected before the next
+        block and of the next block itself."""
+        notifications = {}
+        while True:
+            topic, body, seq = socket.recv_multipart()
+            topic = topic.decode()
+            received_seq = struct.unpack('<I', seq)[-1]
+            if topic in sequences:
+                assert_equal(received_seq, sequences[topic])
+            sequences[topic] = received_seq + 1
+            if topic == "hashblock":
+                return body.hex(), notifications
+            assert topic not in notifications
+            notifications[topic] = parse_keva_notification(body)
+
+    def test_keva(self):
+        self.log.info("Testing the keva notifications")
+        address = f"tcp://127.0.0.1:{self.zmq_port_base}"
+        topics = ["hashblock", "kevans", "kevaupdate", "kevadelete"]
+
+        # All topics share one socket, so that the hashblock sync-up also
+        # makes sure that the keva subscriptions are in place.
+        socket = self.ctx.socket(zmq.SUB)
+        for topic in topics:
+            socket.setsockopt(zmq.SUBSCRIBE, topic.encode())
+        self.restart_node(0, [f"-zmqpub{topic}={address}" for topic in topics])
+        socket.connect(address)
+        socket.set(zmq.RCVTIMEO, 1000)
+        while True:
+            test_block = ZMQTestSetupBlock(self, self.nodes[0])
+            try:
+                while not test_block.caused_notification(socket.recv_multipart()[1].hex()):
+                    self.log.debug("Ignoring sync-up notification for previously generated block.")
+                break
+            except zmq.error.Again:
+                self.log.debug("Didn't receive sync-up notification, trying again.")
+        socket.set(zmq.RCVTIMEO, 60000)
+        self.wallet.rescan_utxos()
+        sequences = {}
+
+        self.log.info("Register a namespace and put a key in the same block")
+        namespace = KevaNamespace(self.wallet, b"name")
+        register_tx = namespace.last_tx
+        put_tx = namespace.put(b"key", b"v1")
+        block_hash = self.generateblock(self.nodes[0], ADDRESS_BCRT1_UNSPENDABLE,
+                                        [register_tx.serialize().hex(), put_tx.serialize().hex()], sync_fun=self.no_op)["hash"]
+        height = self.nodes[0].getblockcount()
+        assert_equal(self.receive_keva_notifications(socket, sequences), (block_hash, {
+            "kevans": (height, block_hash, "C", [(namespace.id, KEVA_DISPLAY_NAME_KEY, b"name", register_tx.hash, 0)]),
+            "kevaupdate": (height, block_hash, "C", [(namespace.id, b"key", b"v1", put_tx.hash, 1)]),
+        }))
+
+        self.log.info("Update and delete the key in the same block")
+        update_tx = namespace.put(b"key", b"v2")
+        delete_tx = namespace.delete(b"key")
+        update_block_hash = self.generateblock(self.nodes[0], ADDRESS_BCRT1_UNSPENDABLE,
+                                               [update_tx.serialize().hex(), delete_tx.serialize().hex()], sync_fun=self.no_op)["hash"]
+        assert_equal(self.receive_keva_notifications(socket, sequences), (update_block_hash, {
+            "kevaupdate": (height + 1, update_block_hash, "C", [(namespace.id, b"key", b"v2", update_tx.hash, 0)]),
+            "kevadelete": (height + 1, update_block_hash, "C", [(namespace.id, b"key", b"", delete_tx.hash, 1)]),
+        }))
+
+        self.log.info("Blocks without keva operations are not notified")
+        block_hash = self.generatetoaddress(self.nodes[0], 1, ADDRESS_BCRT1_UNSPENDABLE, sync_fun=self.no_op)[0]
+        assert_equal(self.receive_keva_notifications(socket, sequences), (block_hash, {}))
+
+        self.log.info("Disconnected blocks are notified with their keva operations")
+        # Invalidating the block with the update and the deletion disconnects
+        # the empty block after it as well.  No hashblock is sent for the
+        # disconnection, so mine an empty block to end the notifications.
+        self.nodes[0].invalidateblock(update_block_hash)
+        block_hash = self.generateblock(self.nodes[0], ADDRESS_BCRT1_UNSPENDABLE, [], sync_fun=self.no_op)["hash"]
+        assert_equal(self.receive_keva_notifications(socket, sequences), (block_hash, {
+            "kevaupdate": (height + 1, update_block_hash, "D", [(namespace.id, b"key", b"v2", update_tx.hash, 0)]),
+            "kevadelete": (height + 1, update_block_hash, "D", [(namespace.id, b"key", b"", delete_tx.hash, 1)]),
+        }))
+
 
 if __name__ == '__main__':
     ZMQTest().main()
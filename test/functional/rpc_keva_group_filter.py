@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Copyright (c) 2026 The Kevacoin Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test keva_group_filter on namespaces that share keys, with and without a cursor."""
+
+from test_framework.address import byte_to_base58
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.keva import KevaNamespace
+from test_framework.test_framework import KevacoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+def encode_namespace(namespace):
+    return byte_to_base58(namespace[1:], namespace[0])
+
+
+class KevaGroupFilterTest(KevacoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def mine(self, txs):
+        self.generateblock(self.nodes[0], self.wallet.get_address(), [tx.serialize().hex() for tx in txs])
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        self.generate(self.wallet, COINBASE_MATURITY + 2)
+
+        self.log.info("Create two namespaces of a group that share a key")
+        ns_a = KevaNamespace(self.wallet, b"a")
+        ns_b = KevaNamespace(self.wallet, b"b")
+        group_key = b"_g:" + encode_namespace(ns_b.id).encode()
+        self.mine([ns_a.last_tx, ns_a.put(b"a", b"1"), ns_a.put(b"shared", b"old"), ns_a.put(group_key, b"join"),
+                   ns_b.last_tx, ns_b.put(b"b", b"2")])
+        # The newer value of the shared key is in the other namespace.
+        self.mine([ns_b.put(b"shared", b"new")])
+
+        # Namespaces are scanned in byte order, the keys of each by length first.
+        keys = {ns_a.id: [b"a", b"shared", group_key], ns_b.id: [b"b", b"shared"]}
+        scan = [(encode_namespace(ns), key.decode()) for ns in sorted(keys) for key in sorted(keys[ns], key=lambda k: (len(k), k))]
+        assert_equal(len(scan), 5)
+
+        self.log.info("Without a cursor, every key is returned once with its newest value")
+        result = node.keva_group_filter(encode_namespace(ns_a.id), "all", "", 0)
+        assert_equal([(entry["key"], entry["value"]) for entry in result],
+                     [(group_key.decode(), "join"), ("a", "1"), ("b", "2"), ("shared", "new")])
+        assert_equal(result[-1]["namespace"], encode_namespace(ns_b.id))
+        stats = node.keva_group_filter(encode_namespace(ns_a.id), "all", "", 0, 0, 0, "stat")
+        assert_equal(stats["count"], 4)
+
+        # from and nb count distinct keys in scan order.
+        distinct = []
+        for _, key in scan:
+            if key not in distinct:
+                distinct.append(key)
+        assert_equal(len(distinct), 4)
+        for start in range(4):
+            result = node.keva_group_filter(encode_namespace(ns_a.id), "all", "", 0, start, 2)
+            assert_equal(sorted(entry["key"] for entry in result), sorted(distinct[start:start + 2]))
+
+        self.log.info("Pages list every entry in scan order, across namespaces")
+        for nb in range(1, 6):
+            entries = []
+            cursor = ""
+            while True:
+                page = node.keva_group_filter(namespace=encode_namespace(ns_a.id), maxage=0, nb=nb, cursor=cursor)
+                assert len(page["keys"]) <= nb
+                entries += [(entry["namespace"], entry["key"]) for entry in page["keys"]]
+                if "next" not in page:
+                    break
+                assert_equal(len(page["keys"]), nb)
+                cursor = page["next"]
+            assert_equal(entries, scan)
+
+        self.log.info("Entries created between pages after the cursor are returned")
+        page = node.keva_group_filter(namespace=encode_namespace(ns_a.id), maxage=0, nb=4, cursor="")
+        last = max(ns_a, ns_b, key=lambda ns: ns.id)
+        self.mine([last.put(b"z" * 40, b"3")])
+        page = node.keva_group_filter(namespace=encode_namespace(ns_a.id), maxage=0, nb=4, cursor=page["next"])
+        assert_equal([(entry["namespace"], entry["key"]) for entry in page["keys"]], scan[4:] + [(encode_namespace(last.id), "z" * 40)])
+
+
+if __name__ == '__main__':
+    KevaGroupFilterTest().main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Copyright (c) 2026 The Kevacoin Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Helpers for creating keva operations without a wallet.
+
+The keva outputs use a bare OP_TRUE as address, so that they can be spent
+without a signature.  Such outputs are not standard, so the transactions
+are mined directly with generateblock instead of being relayed."""
+
+from test_framework.messages import (
+    COIN,
+    COutPoint,
+    CTransaction,
+    CTxIn,
+    CTxOut,
+    ser_uint256,
+)
+from test_framework.script import (
+    CScript,
+    CScriptOp,
+    OP_2DROP,
+    OP_DROP,
+    OP_TRUE,
+    hash160,
+)
+
+OP_KEVA_NAMESPACE = CScriptOp(0xd0)
+OP_KEVA_PUT = CScriptOp(0xd1)
+OP_KEVA_DELETE = CScriptOp(0xd2)
+
+KEVACOIN_TX_VERSION = 0x7100
+KEVA_LOCKED_AMOUNT = COIN // 100
+KEVA_DISPLAY_NAME_KEY = b"_KEVA_NS_"
+# Base58 prefix of the namespace ids ("N")
+KEVA_NAMESPACE_PREFIX = bytes([53])
+
+
+def keva_namespace(txid, n):
+    """Namespace id registered by the keva output spending txid:n."""
+    return KEVA_NAMESPACE_PREFIX + hash160(ser_uint256(int(txid, 16)) + str(n).encode())
+
+
+def keva_namespace_script(namespace, display_name):
+    return CScript([OP_KEVA_NAMESPACE, namespace, display_name, OP_2DROP, OP_TRUE])
+
+
+def keva_put_script(namespace, key, value):
+    return CScript([OP_KEVA_PUT, namespace, key, value, OP_2DROP, OP_DROP, OP_TRUE])
+
+
+def keva_delete_script(namespace, key):
+    return CScript([OP_KEVA_DELETE, namespace, key, OP_2DROP, OP_TRUE])
+
+
+class KevaNamespace:
+    """A namespace whose keva output is tracked, so that every operation
+    spends the output of the previous one."""
+
+    def __init__(self, wallet, display_name):
+        utxo = wallet.get_utxo(confirmed_only=True)
+        self.id = keva_namespace(utxo['txid'], utxo['vout'])
+        tx = CTransaction()
+        tx.nVersion = KEVACOIN_TX_VERSION
+        tx.vin = [CTxIn(COutPoint(int(utxo['txid'], 16), utxo['vout']))]
+        tx.vout = [CTxOut(KEVA_LOCKED_AMOUNT, keva_namespace_script(self.id, display_name))]
+        wallet.sign_tx(tx)
+        self._set_last(tx)
+
+    def _set_last(self, tx):
+        tx.rehash()
+        self.last_tx = tx
+        self.last_txid = tx.hash
+        return tx
+
+    def _spend(self, script):
+        tx = CTransaction()
+        tx.nVersion = KEVACOIN_TX_VERSION
+        tx.vin = [CTxIn(COutPoint(self.last_tx.sha256, 0))]
+        tx.vout = [CTxOut(KEVA_LOCKED_AMOUNT, script)]
+        return self._set_last(tx)
+
+    def put(self, key, value):
+        return self._spend(keva_put_script(self.id, key, value))
+
+    def delete(self, key):
+        return self._spend(keva_delete_script(self.id, key))